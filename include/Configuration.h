@@ -8,6 +8,8 @@
 #include <mutex>
 
 #define CONFIG_FILENAME "/config.json"
+#define CONFIG_IMAGE_FILENAME "/config.bin"
+#define CONFIG_IMAGE_TMP_FILENAME "/config.bin.tmp"
 #define CONFIG_VERSION 0x00011e00 // 0.1.30 // make sure to clean all after change
 
 #define WIFI_MAX_SSID_STRLEN 32
@@ -127,6 +129,23 @@ struct CONFIG_T {
             bool Expire;
         } Hass;
 
+        struct {
+            bool Enabled;
+            uint16_t DeadbandSteps;
+            float DeadbandRelative;
+            uint32_t MaxAge;
+        } ChangeOnly;
+
+        struct {
+            uint8_t Format;
+            bool FieldTopics;
+        } Aggregated;
+
+        struct {
+            uint32_t Budget;
+            bool Coalesce;
+        } Outbox;
+
         struct {
             bool Enabled;
             char RootCaCert[MQTT_MAX_CERT_STRLEN + 1];
@@ -139,6 +158,7 @@ struct CONFIG_T {
     struct {
         uint64_t Serial;
         uint32_t PollInterval;
+        bool PollAdaptive;
         struct {
             uint8_t PaLevel;
         } Nrf;
@@ -185,31 +205,53 @@ struct CONFIG_T {
 class ConfigurationClass {
 public:
     void init(Scheduler& scheduler);
+
+    // Loads the binary image. CONFIG_FILENAME is only imported if the image is missing,
+    // fails its CRC check or was written with another layout of CONFIG_T.
     bool read();
+
+    // Replaces the binary image atomically, CONFIG_FILENAME is not touched
     bool write();
+
+    // Exports the configuration to CONFIG_FILENAME. Only called on demand by
+    // /api/file/get and when an OTA update begins, so a firmware with another layout imports it.
+    bool writeJson();
+
     void migrate();
-    CONFIG_T const& get();
 
+    // Snapshot of the published configuration, never blocks. It does not change
+    // until the scheduler passed a new publish, so it must not be kept longer.
+    CONFIG_T const& get() const;
+
+    // Copy of the configuration which is published when the guard is destroyed.
+    // Writers are serialized and wait until the previous publish passed the scheduler.
     class WriteGuard {
     public:
         WriteGuard();
+        WriteGuard(const WriteGuard&) = delete;
+        WriteGuard& operator=(const WriteGuard&) = delete;
         CONFIG_T& getConfig();
         ~WriteGuard();
 
+        INVERTER_CONFIG_T* getFreeInverterSlot();
+        void deleteInverterById(const uint8_t id);
+
     private:
         std::unique_lock<std::mutex> _lock;
+        CONFIG_T* _config;
     };
 
     WriteGuard getWriteGuard();
 
-    INVERTER_CONFIG_T* getFreeInverterSlot();
-    INVERTER_CONFIG_T* getInverterConfig(const uint64_t serial);
-    void deleteInverterById(const uint8_t id);
+    const INVERTER_CONFIG_T* getInverterConfig(const uint64_t serial) const;
 
     int8_t getIndexForLogModule(const String& moduleName) const;
 
 private:
     void loop();
+    bool readImage(CONFIG_T& config);
+    bool readJson(CONFIG_T& config);
+    bool migrateJson(CONFIG_T& config);
 
     Task _loopTask;
 };
@@ -2,7 +2,11 @@
 #pragma once
 
 #include <TaskSchedulerDeclarations.h>
+#include <atomic>
+#include <map>
 #include <mutex>
+#include <set>
+#include <vector>
 
 class DatastoreClass {
 public:
@@ -57,13 +61,47 @@ public:
     // True if all enabled inverters are reachable
     bool getIsAllEnabledReachable();
 
+    // Incremented every time the totals have been recalculated
+    uint32_t getGeneration() const;
+
 private:
+    struct InverterContribution_t {
+        float acYieldTotal;
+        float acYieldDay;
+        float acPower;
+        float dcPower;
+        float dcPowerIrradiation;
+        float dcIrradiationInstalled;
+        uint32_t acYieldTotalDigits;
+        uint32_t acYieldDayDigits;
+        uint32_t acPowerDigits;
+        uint32_t dcPowerDigits;
+        bool isPollEnabled;
+        bool isProducing;
+        bool isReachable;
+    };
+
     void loop();
+    void onInverterUpdate(const uint64_t serial);
+    void updateContribution(const uint64_t serial);
+    void updateTotals();
 
     Task _loopTask;
 
     std::mutex _mutex;
 
+    // Inverters which notified a change since the last run of the loop
+    std::mutex _dirtyMutex;
+    std::set<uint64_t> _dirtyInverters;
+
+    // Last known contribution of each inverter to the totals, only accessed by the loop
+    std::map<uint64_t, InverterContribution_t> _contributions;
+
+    // Field values of the inverter being processed, only accessed by the loop
+    std::vector<float> _fieldValues;
+
+    std::atomic<uint32_t> _generation { 0 };
+
     float _totalAcYieldTotalEnabled = 0;
     float _totalAcYieldDayEnabled = 0;
     float _totalAcPowerEnabled = 0;
@@ -4,6 +4,7 @@
 #include <TaskSchedulerDeclarations.h>
 #include <U8g2lib.h>
 #include <array>
+#include <atomic>
 
 #define MAX_DATAPOINTS 128
 
@@ -14,22 +15,47 @@ public:
     void init(Scheduler& scheduler, U8G2* display);
     void redraw(uint8_t screenSaverOffsetX, uint8_t xPos, uint8_t yPos, uint8_t width, uint8_t height, bool isFullscreen);
 
+    // Clears the diagram with the next loop, it is seeded again from the history
+    // using the new period. May be called from any task.
     void updatePeriod();
 
 private:
     void averageLoop();
     void dataPointLoop();
 
-    uint32_t getSecondsPerDot();
+    // Applies the configured period and clears the diagram. Called by init() and
+    // by the loops once updatePeriod() has been called.
+    void applyPeriod();
+
+    // Fills the data points before the existing ones with the AC power stored in the history.
+    // Reads the history of one inverter per call, the data points are replaced once all have been read.
+    void seedFromHistory(const uint32_t now);
+
+    // Ring buffer of the data points, index 0 is the oldest one
+    void addGraphValue(const float value);
+    float getGraphValue(const uint8_t index) const;
+
+    uint32_t getSecondsPerValue();
 
     Task _averageTask;
     Task _dataPointTask;
 
     U8G2* _display = nullptr;
     std::array<float, MAX_DATAPOINTS> _graphValues = {};
+    uint8_t _graphValuesHead = 0;
     uint8_t _graphValuesCount = 0;
-
-    uint8_t _chartWidth = MAX_DATAPOINTS;
+    float _graphValuesMax = 0;
+
+    std::atomic<bool> _periodChanged { false };
+
+    bool _seeded = false;
+    uint8_t _seedInverter = 0; // Position of the next inverter to read, 0 starts a new seeding
+    uint32_t _seedPeriod = 0;
+    uint32_t _seedStart = 0;
+    uint8_t _seedSlots = 0;
+    // Sum of the average AC power of all enabled inverters read so far per slot
+    std::array<float, MAX_DATAPOINTS> _seedTotals = {};
+    std::array<bool, MAX_DATAPOINTS> _seedPresent = {};
 
     float _iRunningAverage = 0;
     uint16_t _iRunningAverageCnt = 0;
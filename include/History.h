@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <Arduino.h>
+#include <HistoryRollup.h>
+#include <HistoryStore.h>
+#include <TaskSchedulerDeclarations.h>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Serial of the rollups of the Datastore totals
+#define HISTORY_TOTAL_SERIAL 0ULL
+
+// Values of the samples of one inverter:
+//   0: AC power, 1: yield day, 2: yield total,
+//   3 + 2 * n: DC power of channel n, 4 + 2 * n: yield day of channel n
+// Power is stored in 0.1 W, yields in Wh.
+//
+// In addition the AC power of every inverter and of the Datastore totals is
+// aggregated into rollups (see HistoryRollup) on every statistics update.
+// Each rollup takes about 3 KB. The one of the totals is static, the ones
+// of the inverters are allocated for configured inverters only, so up to
+// INV_MAX_COUNT * 3 KB (30 KB) of heap are used with all slots in use.
+class HistoryClass {
+public:
+    HistoryClass();
+    void init(Scheduler& scheduler);
+
+    // Writes all pending samples, required before the latest samples can be read
+    void flush();
+
+    // Writes all pending samples and the rollups
+    void save();
+
+    // Stops sampling and writing, pending samples are not written anymore. Used before a factory reset.
+    void close();
+
+    HistoryStore& getStore();
+
+    // Used buckets of the rollup of an inverter or HISTORY_TOTAL_SERIAL within the range
+    std::vector<HistoryBucket_t> getBuckets(const uint64_t serial, const HistoryResolution resolution, const uint32_t start, const uint32_t end);
+
+    size_t getRollupCount();
+    size_t getRollupBytes();
+
+    static String getSeriesName(const uint8_t index);
+
+    // Factor to get the value in W, Wh or kWh (yield total)
+    static float getSeriesScale(const uint8_t index);
+
+    // Cumulative series which are not averaged when downsampling
+    static uint32_t getCumulativeMask();
+
+private:
+    struct Inverter_t {
+        uint32_t LastUpdate = 0; // Time of the last statistics update which has been seen
+        bool Updated = false; // Statistics changed since the last sample
+        HistoryRollup Rollup;
+    };
+
+    void loop();
+    void addSample(const uint64_t serial, const uint32_t time);
+    void loadRollups();
+    void saveRollups();
+
+    Task _loopTask;
+
+    HistoryStore _store;
+    bool _available = false;
+    uint32_t _lastSample = 0;
+    uint32_t _lastSave = 0;
+
+    // Field values of the inverter being sampled, only accessed by the loop
+    std::vector<float> _fieldValues;
+
+    std::mutex _mutex;
+    std::map<uint64_t, Inverter_t> _inverters;
+    HistoryRollup _totals;
+    uint32_t _totalsGeneration = 0;
+};
+
+extern HistoryClass History;
@@ -2,11 +2,21 @@
 #pragma once
 
 #include "Configuration.h"
+#include "MqttSettings.h"
 #include <Hoymiles.h>
+#include <MqttTopicTable.h>
 #include <TaskSchedulerDeclarations.h>
+#include <atomic>
 #include <espMqttClient.h>
 #include <frozen/map.h>
 #include <frozen/string.h>
+#include <vector>
+
+enum class MqttAggregatedFormat : uint8_t {
+    None,
+    Json,
+    Csv,
+};
 
 class MqttHandleInverterClass {
 public:
@@ -18,14 +28,30 @@ public:
     void subscribeTopics();
     void unsubscribeTopics();
 
+    // Publishes all values in the next interval, even if they did not change.
+    // Called by MqttSettings on every connect.
+    void forceUpdate();
+
 private:
     void loop();
-    void publishField(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+
+    // Publishes all fields of the topic table as one document under <serial>/json or <serial>/csv
+    void publishAggregated(MqttSettingsClass::Batch& batch, InverterAbstract& inv, MqttTopicTable& topics, const MqttAggregatedFormat format, const time_t lastUpdate);
 
     Task _loopTask;
 
     uint32_t _lastPublishStats[INV_MAX_COUNT] = { 0 };
 
+    MqttTopicTable _topicTables[INV_MAX_COUNT];
+
+    // Field values of the inverter being published, all of the same frame
+    std::vector<float> _fieldValues;
+
+    std::atomic<bool> _updateForced { false };
+
+    // Topic hashes of the messages dropped by the MQTT outbox since the last loop
+    std::vector<uint32_t> _droppedTopics;
+
     FieldId_t _publishFields[14] = {
         FLD_UDC,
         FLD_IDC,
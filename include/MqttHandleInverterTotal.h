@@ -12,6 +12,9 @@ private:
     void loop();
 
     Task _loopTask;
+
+    uint32_t _lastGeneration = 0;
+    uint32_t _unchangedIntervals = 0;
 };
 
 extern MqttHandleInverterTotalClass MqttHandleInverterTotal;
@@ -2,21 +2,86 @@
 #pragma once
 
 #include "NetworkSettings.h"
+#include <MqttOutbox.h>
+#include <MqttPublishBuffer.h>
+#include <MqttPublishFilter.h>
 #include <MqttSubscribeParser.h>
+#include <TaskSchedulerDeclarations.h>
 #include <Ticker.h>
 #include <espMqttClient.h>
 #include <mutex>
 #include <map>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 class MqttSettingsClass {
 public:
+    // Publishes several values with the configured prefix and retain flag.
+    // Topics and payloads are assembled without the client lock, it is only
+    // taken once to hand all messages to the outbox when the batch is destroyed.
+    // Only one batch exists at a time.
+    // If a publish state is passed and change only publishing is enabled,
+    // values are only published if they changed or their max age expired.
+    class Batch {
+    public:
+        void publish(const char* subtopic, const char* payload, MqttPublishState_t* state = nullptr);
+        void publish(const char* subtopic, const float value, const uint8_t digits = 2, MqttPublishState_t* state = nullptr);
+
+        template <typename T, std::enable_if_t<std::is_integral_v<T>, bool> = true>
+        void publish(const char* subtopic, const T value, MqttPublishState_t* state = nullptr)
+        {
+            const char* payload = _settings._publishBuffer.setPayload(static_cast<int64_t>(value));
+            if (state == nullptr || _filter.check(*state, payload, _now)) {
+                send(subtopic, _retain);
+            }
+        }
+
+        // Documents are assembled in this buffer and sent with publishPayload()
+        MqttPublishBuffer& getBuffer();
+        void publishPayload(const char* subtopic, MqttPublishState_t* state = nullptr);
+
+        // Sends the buffered payload retained, but only if it differs from the last one of the state
+        void publishPayloadRetainedOnChange(const char* subtopic, MqttPublishState_t& state);
+
+        bool isChangeOnly() const;
+
+        ~Batch();
+
+    private:
+        friend class MqttSettingsClass;
+        explicit Batch(MqttSettingsClass& settings);
+
+        void send(const char* subtopic, const bool retain);
+
+        MqttSettingsClass& _settings;
+        std::unique_lock<std::mutex> _lock;
+        bool _retain;
+        MqttPublishFilter _filter;
+        uint32_t _now;
+    };
+
+    struct OutboxStats_t {
+        size_t Messages;
+        size_t Bytes;
+        size_t Budget;
+        size_t ClientQueue;
+        uint32_t Dropped;
+        uint32_t Coalesced;
+    };
+
     MqttSettingsClass();
-    void init();
+    void init(Scheduler& scheduler);
     void performReconnect();
     bool getConnected();
-    void publish(const String& subtopic, const String& payload);
-    void publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos = 0);
+    void publish(const String& subtopic, const String& payload, const MqttPriority priority = MqttPriority::Normal);
+    void publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos = 0, const MqttPriority priority = MqttPriority::Normal);
+    Batch beginBatch();
+
+    OutboxStats_t getOutboxStats();
+
+    // See MqttOutbox::takeDroppedTopics()
+    bool takeDroppedTopics(const MqttPriority priority, std::vector<uint32_t>& topics);
 
     void subscribe(const String& topic, const uint8_t qos, const OnMessageCallback& cb);
     void unsubscribe(const String& topic);
@@ -25,6 +90,7 @@ public:
     String getClientId() const;
 
 private:
+    void loop();
     void NetworkEvent(network_event event);
 
     void onMqttDisconnect(espMqttClientTypes::DisconnectReason reason);
@@ -36,11 +102,33 @@ private:
 
     void createMqttClientObject();
 
+    // All have to be called with _clientLock held
+    void enqueue(const char* topic, const char* payload, const bool retain, const uint8_t qos, const MqttPriority priority);
+    void drainOutbox();
+    void updateOutboxBudget();
+
+    Task _loopTask;
+
     MqttClient* _mqttClient = nullptr;
     Ticker _mqttReconnectTimer;
     std::map<String, std::vector<uint8_t>> _fragments;
     MqttSubscribeParser _mqttSubscribeParser;
     std::mutex _clientLock;
+
+    // Guarded by _clientLock
+    MqttOutbox _outbox;
+
+    // Guarded by _batchLock. Topic and payload of all messages of the current
+    // batch are stored back to back, each terminated by a null character.
+    struct BatchMessage_t {
+        size_t Topic;
+        size_t Payload;
+        bool Retain;
+    };
+    std::mutex _batchLock;
+    MqttPublishBuffer _publishBuffer;
+    std::string _batchData;
+    std::vector<BatchMessage_t> _batchMessages;
 };
 
 extern MqttSettingsClass MqttSettings;
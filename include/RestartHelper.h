@@ -9,10 +9,14 @@ public:
     void init(Scheduler& scheduler);
     void triggerRestart();
 
+    // Removes all files (see Utils::removeAllFiles) and restarts without saving the history again
+    void triggerFactoryReset();
+
 private:
     void loop();
 
     Task _rebootTask;
+    bool _factoryReset = false;
 };
 
 extern RestartHelperClass RestartHelper;
@@ -9,6 +9,7 @@
 #include "WebApi_file.h"
 #include "WebApi_firmware.h"
 #include "WebApi_gridprofile.h"
+#include "WebApi_history.h"
 #include "WebApi_i18n.h"
 #include "WebApi_inverter.h"
 #include "WebApi_limit.h"
@@ -25,9 +26,14 @@
 #include "WebApi_ws_console.h"
 #include "WebApi_ws_live.h"
 #include <AsyncJson.h>
+#include <AsyncMessagePack.h>
 #include <ESPAsyncWebServer.h>
 #include <TaskSchedulerDeclarations.h>
 
+// Writes the part with the given index of a JSON response to output.
+// Returns true if more parts follow.
+typedef std::function<bool(const size_t part, Print& output)> JsonPartWriter;
+
 class WebApiClass {
 public:
     WebApiClass();
@@ -45,6 +51,14 @@ public:
     static uint64_t parseSerialFromRequest(AsyncWebServerRequest* request, String param_name = "inv");
     static bool sendJsonResponse(AsyncWebServerRequest* request, AsyncJsonResponse* response, const char* function, const uint16_t line);
 
+    // Returns true if the client prefers MessagePack over JSON (Accept header)
+    static bool acceptsMessagePack(AsyncWebServerRequest* request);
+    static bool sendMessagePackResponse(AsyncWebServerRequest* request, AsyncMessagePackResponse* response, const char* function, const uint16_t line);
+
+    // Sends a chunked response which is generated part by part while it is sent,
+    // so only the current part has to be kept in memory
+    static void sendChunkedJsonResponse(AsyncWebServerRequest* request, const JsonPartWriter& writer);
+
 private:
     AsyncWebServer _server;
 
@@ -55,6 +69,7 @@ private:
     WebApiFileClass _webApiFile;
     WebApiFirmwareClass _webApiFirmware;
     WebApiGridProfileClass _webApiGridprofile;
+    WebApiHistoryClass _webApiHistory;
     WebApiI18nClass _webApiI18n;
     WebApiInverterClass _webApiInverter;
     WebApiLimitClass _webApiLimit;
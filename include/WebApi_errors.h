@@ -63,6 +63,12 @@ enum WebApiError {
     MqttHassTopicCharacter,
     MqttLwtQos,
     MqttClientIdLength,
+    MqttDeadbandSteps,
+    MqttDeadbandRelative,
+    MqttMaxAge,
+    MqttAggregatedFormat,
+    MqttAggregatedFieldTopics,
+    MqttOutboxBudget,
 
     NetworkBase = 8000,
     NetworkIpInvalid,
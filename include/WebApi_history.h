@@ -0,0 +1,16 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+#include <HistoryRollup.h>
+#include <TaskSchedulerDeclarations.h>
+
+class WebApiHistoryClass {
+public:
+    void init(AsyncWebServer& server, Scheduler& scheduler);
+
+private:
+    void onHistoryGet(AsyncWebServerRequest* request);
+    void sendSamples(AsyncWebServerRequest* request, const uint64_t serial, const uint32_t start, const uint32_t end, const uint32_t points);
+    void sendBuckets(AsyncWebServerRequest* request, const uint64_t serial, const HistoryResolution resolution, const uint32_t start, const uint32_t end);
+};
@@ -3,8 +3,16 @@
 
 #include <ESPAsyncWebServer.h>
 #include <Hoymiles.h>
+#include <StreamString.h>
 #include <TaskSchedulerDeclarations.h>
 #include <map>
+#include <memory>
+#include <vector>
+
+// Maximum time a rendered exposition is served without any inverter update.
+// Only the render cost is cached, the system metrics change with every render
+// so there is no stable ETag to answer repeated scrapes with 304.
+#define PROMETHEUS_CACHE_MAX_AGE (10 * 1000)
 
 class WebApiPrometheusClass {
 public:
@@ -13,9 +21,34 @@ public:
 private:
     void onPrometheusMetricsGet(AsyncWebServerRequest* request);
 
-    void addField(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* metricName, const char* channelName = nullptr);
+    struct ExpositionPart_t {
+        uint64_t Serial = 0;
+        uint32_t LastUpdate = 0;
+        std::shared_ptr<StreamString> Text;
+    };
+
+    // Re-renders the parts of inverters which have been updated since the last call
+    void updateExposition();
+    StreamString* clearPart(ExpositionPart_t& part);
+
+    void addSystemInfo(Print* stream);
+
+    void addInverter(Print* stream, const uint8_t idx, std::shared_ptr<InverterAbstract> inv);
+
+    void addField(Print* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const std::vector<float>& values, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* metricName, const char* channelName = nullptr);
+
+    void addPanelInfo(Print* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel);
 
-    void addPanelInfo(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel);
+    void addQueueWaitStats(Print* stream);
+
+    void addCommandStats(Print* stream);
+
+    void addMqttStats(Print* stream);
+
+    void addHistoryStats(Print* stream);
+
+    template <typename T>
+    void addHistogram(Print* stream, const char* metricName, const char* radio, const char* command, const T& histogram, const double divisor);
 
     enum MetricType_t {
         NONE = 0,
@@ -24,6 +57,8 @@ private:
     };
     const char* _metricTypes[3] = { 0, "gauge", "counter" };
 
+    const char* _commandPriorities[COMMAND_PRIORITY_COUNT] = { "control", "realtime", "config" };
+
     struct publish_type_t {
         FieldId_t field;
         MetricType_t type;
@@ -45,4 +80,9 @@ private:
         { FLD_EFF, MetricType_t::GAUGE },
         { FLD_IRR, MetricType_t::GAUGE },
     };
+
+    // Part 0 contains the system metrics followed by one part per inverter
+    std::vector<ExpositionPart_t> _parts;
+    uint32_t _lastRender = 0;
+    size_t _length = 0;
 };
@@ -6,6 +6,12 @@
 #include <ESPAsyncWebServer.h>
 #include <Hoymiles.h>
 #include <TaskSchedulerDeclarations.h>
+#include <map>
+#include <vector>
+
+// Text messages a client can send to change the format of the messages it receives
+#define WS_LIVE_PROTOCOL_DELTA "proto:2"
+#define WS_LIVE_ENCODING_MSGPACK "encoding:msgpack"
 
 class WebApiWsLiveClass {
 public:
@@ -17,20 +23,62 @@ private:
     static void generateInverterCommonJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
     static void generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
     static void generateCommonJsonResponse(JsonVariant& root);
+    static void generateCommandStatsJsonResponse(JsonVariant& root);
+    static void generateLivedataStatusResponse(JsonVariant& root, const uint64_t serial);
+
+    static void forEachLiveField(std::shared_ptr<InverterAbstract> inv, const std::function<void(const ChannelType_t, const ChannelNum_t, const FieldId_t)>& callback);
+    static String getLiveFieldName(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
 
-    static void addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, String topic = "");
+    static void addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const std::vector<float>& values, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, String topic = "");
     static void addTotalField(JsonObject& root, const String& name, const float value, const String& unit, const uint8_t digits);
 
     void onLivedataStatus(AsyncWebServerRequest* request);
+    bool writeLivedataStatusPart(const uint64_t serial, const size_t part, bool& first, Print& output);
     void onWebsocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
 
+    enum class ClientGroup {
+        Full, // Clients which did not request the delta protocol
+        Snapshot, // Delta clients which require a snapshot
+        Delta, // Delta clients which already received a snapshot
+    };
+    struct ClientState_t {
+        bool Delta = false;
+        bool SnapshotRequired = false;
+        bool MessagePack = false;
+    };
+    static ClientGroup getClientGroup(const ClientState_t& state);
+    bool hasClients(const ClientGroup group);
+    void sendToClients(JsonDocument& root, const ClientGroup group);
+
+    bool updateDeltaFields();
+    void collectDeltaChanges(std::shared_ptr<InverterAbstract> inv);
+    void sendSnapshots();
+
     AsyncWebSocket _ws;
     AsyncAuthenticationMiddleware _simpleDigestAuth;
 
     uint32_t _lastPublishStats[INV_MAX_COUNT] = { 0 };
+    uint32_t _lastPublishCommandStatsFull = 0;
+    uint32_t _lastPublishCommandStatsDelta = 0;
 
     std::mutex _mutex;
 
+    // Only contains clients which changed the protocol or the encoding
+    std::map<uint32_t, ClientState_t> _clients;
+    std::mutex _clientsMutex;
+
+    // The index is the id used by the delta protocol
+    struct DeltaField_t {
+        uint64_t Serial;
+        ChannelType_t Type;
+        ChannelNum_t Channel;
+        FieldId_t Field;
+        float Value; // Last value sent to the delta clients
+    };
+    std::vector<DeltaField_t> _deltaFields;
+    std::vector<uint16_t> _deltaChanges;
+    std::vector<float> _deltaValues; // Field values of the inverter being collected
+
     Task _wsCleanupTask;
     void wsCleanupTaskCb();
 
@@ -83,8 +83,23 @@
 #define MQTT_PUBLISH_INTERVAL 5U
 #define MQTT_CLEAN_SESSION true
 
+#define MQTT_CHANGE_ONLY false
+#define MQTT_CHANGE_ONLY_DEADBAND_STEPS 0U
+#define MQTT_CHANGE_ONLY_DEADBAND_RELATIVE 0.0
+#define MQTT_CHANGE_ONLY_MAX_AGE 300U
+
+#define MQTT_AGGREGATED_FORMAT 0U
+#define MQTT_AGGREGATED_FIELD_TOPICS true
+
+// Heap is only used while messages are waiting. One publish cycle of a four channel
+// inverter needs about 4.7 KiB, so the default holds a cycle of six of them.
+// The effective budget is limited to a share of the free heap (see MqttSettings).
+#define MQTT_OUTBOX_BUDGET 32768U
+#define MQTT_OUTBOX_COALESCE true
+
 #define DTU_SERIAL 0x99978563412U
 #define DTU_POLL_INTERVAL 5U
+#define DTU_POLL_ADAPTIVE false
 #define DTU_NRF_PA_LEVEL 0U
 #define DTU_CMT_PA_LEVEL 0
 #define DTU_CMT_FREQUENCY 865000000U
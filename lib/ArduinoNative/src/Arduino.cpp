@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "Arduino.h"
+#include "esp_log.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <mutex>
+#include <thread>
+
+struct NativeSemaphore {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool taken = false;
+};
+
+static const auto startTime = std::chrono::steady_clock::now();
+static std::atomic<uint64_t> millisOffset { 0 };
+static std::atomic<esp_log_level_t> logLevel { ESP_LOG_WARN };
+
+// Both clocks wrap independently like on the ESP32, micros() after about 71 minutes, millis() after 49 days
+static uint64_t elapsedMicros()
+{
+    const auto elapsed = std::chrono::steady_clock::now() - startTime;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() + millisOffset * 1000;
+}
+
+uint32_t millis()
+{
+    return static_cast<uint32_t>(elapsedMicros() / 1000);
+}
+
+uint32_t micros()
+{
+    return static_cast<uint32_t>(elapsedMicros());
+}
+
+void delay(const uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void advanceMillis(const uint32_t ms)
+{
+    millisOffset += ms;
+}
+
+bool getLocalTime(struct tm* info, const uint32_t)
+{
+    // Same plausibility check as the ESP32 core: time is not set before 2016
+    const time_t now = time(nullptr);
+    localtime_r(&now, info);
+    return info->tm_year > (2016 - 1900);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return new NativeSemaphore();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, const uint32_t ticks)
+{
+    std::unique_lock<std::mutex> lock(semaphore->mutex);
+    if (ticks == portMAX_DELAY) {
+        semaphore->cv.wait(lock, [semaphore] { return !semaphore->taken; });
+    } else if (!semaphore->cv.wait_for(lock, std::chrono::milliseconds(ticks), [semaphore] { return !semaphore->taken; })) {
+        return pdFAIL;
+    }
+    semaphore->taken = true;
+    return pdPASS;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    {
+        std::lock_guard<std::mutex> lock(semaphore->mutex);
+        if (!semaphore->taken) {
+            return pdFAIL;
+        }
+        semaphore->taken = false;
+    }
+    semaphore->cv.notify_one();
+    return pdPASS;
+}
+
+void esp_log_level_set(const char*, const esp_log_level_t level)
+{
+    logLevel = level;
+}
+
+esp_log_level_t esp_log_level_get(const char*)
+{
+    return logLevel;
+}
+
+void esp_log_write(const esp_log_level_t, const char*, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// Minimal subset of the Arduino ESP32 core required to build lib/Hoymiles on the host (HOY_NATIVE)
+
+#include "WString.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#define ARDUINO_ISR_ATTR
+
+using std::max;
+using std::min;
+
+uint32_t millis();
+uint32_t micros();
+void delay(const uint32_t ms);
+
+// Moves the clock returned by millis() forward without sleeping.
+// Allows benchmarks to skip radio timeouts and poll intervals.
+void advanceMillis(const uint32_t ms);
+
+bool getLocalTime(struct tm* info, const uint32_t ms = 5000);
+
+// FreeRTOS semaphore subset used by the parsers
+typedef struct NativeSemaphore* SemaphoreHandle_t;
+typedef int BaseType_t;
+
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xffffffffUL
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, const uint32_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
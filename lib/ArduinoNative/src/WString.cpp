@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "WString.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+static std::string integerToString(unsigned long long value, const bool negative, const unsigned char base)
+{
+    static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    if (base < 2 || base > 36) {
+        return "";
+    }
+
+    std::string result;
+    do {
+        result.insert(result.begin(), digits[value % base]);
+        value /= base;
+    } while (value > 0);
+
+    if (negative) {
+        result.insert(result.begin(), '-');
+    }
+    return result;
+}
+
+String::String(const char* str)
+    : _buffer(str ? str : "")
+{
+}
+
+String::String(const std::string& str)
+    : _buffer(str)
+{
+}
+
+String::String(const char c)
+    : _buffer(1, c)
+{
+}
+
+String::String(const int value, const unsigned char base)
+    : String(static_cast<long>(value), base)
+{
+}
+
+String::String(const unsigned int value, const unsigned char base)
+    : String(static_cast<unsigned long>(value), base)
+{
+}
+
+String::String(const long value, const unsigned char base)
+{
+    // Like the Arduino core only base 10 is signed
+    if (base == 10 && value < 0) {
+        _buffer = integerToString(-static_cast<unsigned long long>(value), true, base);
+    } else {
+        _buffer = integerToString(static_cast<unsigned long>(value), false, base);
+    }
+}
+
+String::String(const unsigned long value, const unsigned char base)
+    : _buffer(integerToString(value, false, base))
+{
+}
+
+String::String(const float value, const unsigned int decimalPlaces)
+    : String(static_cast<double>(value), decimalPlaces)
+{
+}
+
+String::String(const double value, const unsigned int decimalPlaces)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+    _buffer = buf;
+}
+
+bool String::reserve(const unsigned int size)
+{
+    _buffer.reserve(size);
+    return true;
+}
+
+bool String::concat(const String& str)
+{
+    _buffer += str._buffer;
+    return true;
+}
+
+bool String::concat(const char* str)
+{
+    if (str == nullptr) {
+        return false;
+    }
+    _buffer += str;
+    return true;
+}
+
+bool String::concat(const char c)
+{
+    _buffer += c;
+    return true;
+}
+
+String& String::operator+=(const String& rhs)
+{
+    concat(rhs);
+    return *this;
+}
+
+String& String::operator+=(const char* rhs)
+{
+    concat(rhs);
+    return *this;
+}
+
+String& String::operator+=(const char rhs)
+{
+    concat(rhs);
+    return *this;
+}
+
+char String::operator[](const unsigned int index) const
+{
+    return index < _buffer.length() ? _buffer[index] : '\0';
+}
+
+String String::substring(const unsigned int beginIndex) const
+{
+    return substring(beginIndex, length());
+}
+
+String String::substring(const unsigned int beginIndex, const unsigned int endIndex) const
+{
+    if (beginIndex >= endIndex || beginIndex >= length()) {
+        return String();
+    }
+    return String(_buffer.substr(beginIndex, endIndex - beginIndex));
+}
+
+int String::indexOf(const char c) const
+{
+    const size_t pos = _buffer.find(c);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+long String::toInt() const
+{
+    return strtol(_buffer.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const
+{
+    return strtof(_buffer.c_str(), nullptr);
+}
+
+void String::toLowerCase()
+{
+    for (auto& c : _buffer) {
+        c = tolower(static_cast<unsigned char>(c));
+    }
+}
+
+void String::trim()
+{
+    const size_t begin = _buffer.find_first_not_of(" \t\r\n\f\v");
+    if (begin == std::string::npos) {
+        _buffer.clear();
+        return;
+    }
+    const size_t end = _buffer.find_last_not_of(" \t\r\n\f\v");
+    _buffer = _buffer.substr(begin, end - begin + 1);
+}
+
+String operator+(const String& lhs, const String& rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+String operator+(const String& lhs, const char* rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+String operator+(const char* lhs, const String& rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return result;
+}
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// std::string backed replacement of the Arduino String class.
+// Only the members used by the Hoymiles library are provided.
+class String {
+public:
+    String() = default;
+    String(const char* str);
+    String(const std::string& str);
+    explicit String(const char c);
+    explicit String(const int value, const unsigned char base = 10);
+    explicit String(const unsigned int value, const unsigned char base = 10);
+    explicit String(const long value, const unsigned char base = 10);
+    explicit String(const unsigned long value, const unsigned char base = 10);
+    explicit String(const float value, const unsigned int decimalPlaces = 2);
+    explicit String(const double value, const unsigned int decimalPlaces = 2);
+
+    const char* c_str() const { return _buffer.c_str(); }
+    unsigned int length() const { return _buffer.length(); }
+    bool isEmpty() const { return _buffer.empty(); }
+    bool reserve(const unsigned int size);
+
+    bool concat(const String& str);
+    bool concat(const char* str);
+    bool concat(const char c);
+
+    String& operator+=(const String& rhs);
+    String& operator+=(const char* rhs);
+    String& operator+=(const char rhs);
+
+    bool equals(const String& str) const { return _buffer == str._buffer; }
+    bool equals(const char* str) const { return _buffer == (str ? str : ""); }
+    bool operator==(const String& rhs) const { return equals(rhs); }
+    bool operator==(const char* rhs) const { return equals(rhs); }
+    bool operator!=(const String& rhs) const { return !equals(rhs); }
+    bool operator!=(const char* rhs) const { return !equals(rhs); }
+    bool operator<(const String& rhs) const { return _buffer < rhs._buffer; }
+
+    char operator[](const unsigned int index) const;
+    String substring(const unsigned int beginIndex) const;
+    String substring(const unsigned int beginIndex, const unsigned int endIndex) const;
+    int indexOf(const char c) const;
+    long toInt() const;
+    void toLowerCase();
+    void trim();
+    float toFloat() const;
+
+    friend String operator+(const String& lhs, const String& rhs);
+    friend String operator+(const String& lhs, const char* rhs);
+    friend String operator+(const char* lhs, const String& rhs);
+
+private:
+    std::string _buffer;
+};
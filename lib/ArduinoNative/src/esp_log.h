@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cinttypes>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+// Only the global level ("*") is supported, default is ESP_LOG_WARN
+void esp_log_level_set(const char* tag, const esp_log_level_t level);
+esp_log_level_t esp_log_level_get(const char* tag);
+void esp_log_write(const esp_log_level_t level, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+// Arguments are only evaluated if the message is actually printed
+#define NATIVE_LOG(level, letter, tag, format, ...)                                        \
+    do {                                                                                   \
+        if (esp_log_level_get(tag) >= level) {                                             \
+            esp_log_write(level, tag, letter " (%s) " format "\n", tag, ##__VA_ARGS__);   \
+        }                                                                                  \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) NATIVE_LOG(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) NATIVE_LOG(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) NATIVE_LOG(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) NATIVE_LOG(ESP_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) NATIVE_LOG(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
@@ -0,0 +1,311 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+
+/*
+Writes simulated inverter samples into a HistoryStore in a temporary
+directory and verifies that they are read back unchanged, that the ring
+deletes the oldest segments, that a segment cut in the middle of a record
+(power loss while writing) is recovered and that the downsampled buckets
+match a straightforward calculation. Prints the average record size.
+Finally checks the rollup buckets, their energy and their persistence.
+
+Build and run:
+    pio run -e native_history_check
+    .pio/build/native_history_check/program [directory]
+*/
+#include <HistoryRollup.h>
+#include <HistoryStore.h>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#define SAMPLE_INTERVAL 60U
+#define MAX_SEGMENTS 12U
+
+static const uint64_t ids[] = { 0x114182345678ULL, 0x116482345678ULL, 0x138282345678ULL };
+static const uint8_t counts[] = { 5, 7, 15 };
+
+// Power in 0.1 W following the sun, yields in Wh
+static HistorySample_t simulate(const uint8_t count, const uint32_t time, int32_t& yieldTotal)
+{
+    HistorySample_t sample = {};
+    sample.Time = time;
+    sample.Count = count;
+
+    const double hour = (time % 86400) / 3600.0;
+    const double sun = std::max(0.0, std::sin((hour - 6) / 12 * M_PI));
+    const int32_t power = static_cast<int32_t>(sun * 8000 + (sun > 0 ? rand() % 50 : 0));
+
+    yieldTotal += power * SAMPLE_INTERVAL / 36000;
+
+    sample.Values[0] = power;
+    sample.Values[1] = static_cast<int32_t>(hour * 1000);
+    sample.Values[2] = yieldTotal;
+    for (uint8_t i = 3; i < count; i++) {
+        sample.Values[i] = power / (count - 3) + (i % 2 == 0 ? -rand() % 30 : rand() % 30);
+    }
+    return sample;
+}
+
+static bool equal(const HistorySample_t& a, const HistorySample_t& b)
+{
+    if (a.Time != b.Time || a.Count != b.Count) {
+        return false;
+    }
+    for (uint8_t i = 0; i < a.Count; i++) {
+        if (a.Values[i] != b.Values[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Compares all samples of the store within the range with the expected ones
+static bool verify(HistoryStore& store, const uint64_t id, const std::vector<HistorySample_t>& expected, const uint32_t start, const uint32_t end)
+{
+    HistoryReader reader(store, id, start, end);
+    HistorySample_t sample;
+
+    for (auto& e : expected) {
+        if (e.Time < start || e.Time > end) {
+            continue;
+        }
+        if (!reader.next(sample) || !equal(sample, e)) {
+            fprintf(stderr, "Sample %" PRIu32 " of %012" PRIx64 " differs\n", e.Time, id);
+            return false;
+        }
+    }
+
+    if (reader.next(sample)) {
+        fprintf(stderr, "Unexpected sample %" PRIu32 " of %012" PRIx64 "\n", sample.Time, id);
+        return false;
+    }
+    return true;
+}
+
+static off_t fileSize(const std::string& path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+int main(int argc, char* argv[])
+{
+    char tmp[] = "/tmp/history_check_XXXXXX";
+    const char* path = argc > 1 ? argv[1] : mkdtemp(tmp);
+    if (path == nullptr) {
+        fprintf(stderr, "Could not create a temporary directory\n");
+        return 1;
+    }
+
+    srand(1);
+
+    HistoryStore store;
+    if (!store.begin(path, MAX_SEGMENTS)) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return 1;
+    }
+
+    // Three days, flushed every 10 samples
+    const uint32_t begin = 1735689600;
+    std::vector<HistorySample_t> written[3];
+    int32_t yieldTotal[3] = { 1000000, 2000000, 3000000 };
+
+    for (uint32_t time = begin; time < begin + 3 * 86400; time += SAMPLE_INTERVAL) {
+        for (size_t i = 0; i < 3; i++) {
+            written[i].push_back(simulate(counts[i], time, yieldTotal[i]));
+            if (!store.append(ids[i], written[i].back())) {
+                fprintf(stderr, "Append failed\n");
+                return 1;
+            }
+        }
+        if ((time / SAMPLE_INTERVAL) % 10 == 0) {
+            store.flush();
+        }
+    }
+    store.flush();
+
+    if (store.getSegmentCount() != MAX_SEGMENTS) {
+        fprintf(stderr, "%" PRIu32 " segments instead of %u\n", store.getSegmentCount(), MAX_SEGMENTS);
+        return 1;
+    }
+
+    // Only the samples of the remaining segments can be read
+    std::vector<HistorySample_t> expected[3];
+    uint64_t bytes = 0;
+    size_t samples = 0;
+    for (size_t i = 0; i < 3; i++) {
+        auto segments = store.getSegments(ids[i]);
+        if (segments.empty()) {
+            fprintf(stderr, "No segments left for %012" PRIx64 "\n", ids[i]);
+            return 1;
+        }
+        for (auto& s : written[i]) {
+            if (s.Time >= segments.front().Start) {
+                expected[i].push_back(s);
+            }
+        }
+        for (auto& s : segments) {
+            bytes += fileSize(store.getSegmentPath(ids[i], s.Number));
+        }
+        samples += expected[i].size();
+
+        if (!verify(store, ids[i], expected[i], 0, UINT32_MAX)
+            || !verify(store, ids[i], expected[i], begin + 86400 + 7, begin + 2 * 86400 + 7)) {
+            return 1;
+        }
+    }
+
+    printf("%zu samples in %" PRIu64 " bytes, %.1f bytes per sample\n", samples, bytes, static_cast<double>(bytes) / samples);
+
+    // Cut the last segment in the middle of a record and reopen the store
+    auto segments = store.getSegments(ids[2]);
+    const std::string last = store.getSegmentPath(ids[2], segments.back().Number);
+    if (truncate(last.c_str(), fileSize(last) - 3) != 0) {
+        fprintf(stderr, "Could not truncate %s\n", last.c_str());
+        return 1;
+    }
+    expected[2].pop_back();
+
+    HistoryStore recovered;
+    recovered.begin(path, MAX_SEGMENTS);
+    if (!verify(recovered, ids[2], expected[2], 0, UINT32_MAX)) {
+        return 1;
+    }
+
+    // Older samples are rejected, newer ones are written to a new segment
+    const uint32_t next = expected[2].back().Time + SAMPLE_INTERVAL;
+    if (recovered.append(ids[2], expected[2].back())) {
+        fprintf(stderr, "Old sample accepted\n");
+        return 1;
+    }
+    expected[2].push_back(simulate(counts[2], next, yieldTotal[2]));
+    recovered.append(ids[2], expected[2].back());
+    recovered.flush();
+    if (recovered.getSegments(ids[2]).back().Number != segments.back().Number + 1
+        || !verify(recovered, ids[2], expected[2], 0, UINT32_MAX)) {
+        fprintf(stderr, "Sample after recovery not written to a new segment\n");
+        return 1;
+    }
+
+    // The new segment may have replaced the oldest one of another id
+    const uint32_t first = recovered.getSegments(ids[0]).front().Start;
+    while (expected[0].front().Time < first) {
+        expected[0].erase(expected[0].begin());
+    }
+
+    // Hourly buckets, yields keep their last value
+    const uint32_t mask = 0b110;
+    HistoryDownsampler downsampler(begin, 3600, mask);
+    HistoryReader reader(recovered, ids[0], begin, UINT32_MAX);
+    HistorySample_t sample;
+    HistorySample_t bucket;
+    std::vector<HistorySample_t> buckets;
+    while (reader.next(sample)) {
+        if (downsampler.add(sample, bucket)) {
+            buckets.push_back(bucket);
+        }
+    }
+    if (downsampler.finish(bucket)) {
+        buckets.push_back(bucket);
+    }
+
+    size_t pos = 0;
+    for (auto& b : buckets) {
+        int64_t sum = 0;
+        size_t n = 0;
+        int32_t yield = 0;
+        for (; pos < expected[0].size() && expected[0][pos].Time < b.Time + 3600; pos++) {
+            sum += expected[0][pos].Values[0];
+            yield = expected[0][pos].Values[2];
+            n++;
+        }
+        if (n == 0 || b.Values[0] != std::llround(static_cast<double>(sum) / n) || b.Values[2] != yield) {
+            fprintf(stderr, "Bucket %" PRIu32 " differs\n", b.Time);
+            return 1;
+        }
+    }
+
+    printf("%zu hourly buckets verified\n", buckets.size());
+
+    // Constant 600 W for two days every 5 s in UTC+2, with a gap of one hour
+    HistoryRollup rollup;
+    const int32_t utcOffset = 2 * 3600;
+    for (uint32_t time = begin; time < begin + 2 * 86400; time += 5) {
+        if (time < begin + 3600 || time >= begin + 2 * 3600) {
+            rollup.add(time, utcOffset, 600);
+        }
+    }
+
+    std::vector<HistoryBucket_t> days;
+    for (size_t i = 0; i < HistoryRollup::capacity(HistoryResolution::Day); i++) {
+        if (rollup.at(HistoryResolution::Day, i).Start > 0) {
+            days.push_back(rollup.at(HistoryResolution::Day, i));
+        }
+    }
+
+    // Local midnight is 22:00 UTC, the first day ends 22 hours after begin.
+    // The float sum of the energy is accurate to about 1e-4.
+    const float firstDay = 600 * (22 - 1) - 600 * 5 / 3600.0f * 2;
+    if (days.size() != 3 || days[0].Start != begin - utcOffset || days[1].Start != begin + 22 * 3600
+        || std::fabs(days[0].Energy - firstDay) > firstDay * 1e-3 || days[0].Min != 600 || days[0].Max != 600 || days[0].getAverage() != 600) {
+        fprintf(stderr, "Daily rollup differs\n");
+        return 1;
+    }
+
+    const HistoryBucket_t& quarter = rollup.at(HistoryResolution::Quarter, HistoryRollup::capacity(HistoryResolution::Quarter) - 1);
+    const HistoryBucket_t& minute = rollup.at(HistoryResolution::Minute, 0);
+    if (quarter.Count != 180 || std::fabs(quarter.Energy - 150) > 0.01 || minute.Start != begin + 2 * 86400 - 3600 || minute.Count != 12) {
+        fprintf(stderr, "Quarter or minute rollup differs\n");
+        return 1;
+    }
+
+    // Daily buckets keep their local midnight when the UTC offset changes (daylight saving time)
+    HistoryRollup dst;
+    dst.add(begin + 3600, 3600, 100);
+    dst.add(begin + 86400 + 3600, 7200, 100);
+    const size_t lastDay = HistoryRollup::capacity(HistoryResolution::Day) - 1;
+    if (dst.at(HistoryResolution::Day, lastDay - 1).Start != begin - 3600 || dst.at(HistoryResolution::Day, lastDay).Start != begin + 86400 - 7200) {
+        fprintf(stderr, "Daily rollup start differs after the UTC offset changed\n");
+        return 1;
+    }
+
+    const std::string rollupPath = std::string(path) + "/rollup.bin";
+    FILE* file = fopen(rollupPath.c_str(), "wb");
+    if (file == nullptr || !rollup.write(file) || fclose(file) != 0) {
+        fprintf(stderr, "Could not write %s\n", rollupPath.c_str());
+        return 1;
+    }
+    HistoryRollup loaded;
+    file = fopen(rollupPath.c_str(), "rb");
+    const bool read = file != nullptr && loaded.read(file);
+    if (file != nullptr) {
+        fclose(file);
+    }
+    remove(rollupPath.c_str());
+    if (!read || memcmp(&loaded, &rollup, sizeof(rollup)) != 0) {
+        fprintf(stderr, "Rollup differs after reading it back\n");
+        return 1;
+    }
+
+    printf("Rollups verified, %zu bytes per rollup\n", sizeof(HistoryRollup));
+
+    if (argc < 2) {
+        for (uint64_t id : ids) {
+            for (auto& s : recovered.getSegments(id)) {
+                remove(recovered.getSegmentPath(id, s.Number).c_str());
+            }
+        }
+        rmdir(path);
+    }
+
+    return 0;
+}
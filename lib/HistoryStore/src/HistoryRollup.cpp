@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "HistoryRollup.h"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<HistoryRollup>::value, "HistoryRollup is written as raw image");
+
+static uint32_t alignStart(const uint32_t time, const int32_t offset, const uint32_t interval)
+{
+    const int64_t local = static_cast<int64_t>(time) + offset;
+    return static_cast<uint32_t>(local - local % interval - offset);
+}
+
+void HistoryRollup::add(const uint32_t time, const int32_t utcOffset, const float power)
+{
+    // Trapezoid between the previous and this sample, a gap (e.g. night) adds nothing
+    float energy = 0;
+    if (_lastTime > 0 && time > _lastTime && time - _lastTime <= HISTORY_ROLLUP_MAX_GAP) {
+        energy = (power + _lastPower) / 2 * (time - _lastTime) / 3600;
+    }
+    if (time > _lastTime) {
+        _lastTime = time;
+        _lastPower = power;
+    }
+
+    update(_minutes.get(alignStart(time, utcOffset, interval(HistoryResolution::Minute))), power, energy);
+    update(_quarters.get(alignStart(time, utcOffset, interval(HistoryResolution::Quarter))), power, energy);
+    update(_days.get(alignStart(time, utcOffset, interval(HistoryResolution::Day))), power, energy);
+}
+
+void HistoryRollup::update(HistoryRollupBucket_t& bucket, const float power, const float energy)
+{
+    const uint16_t value = static_cast<uint16_t>(std::clamp(std::lround(power), 0L, static_cast<long>(UINT16_MAX)));
+
+    if (bucket.Count == 0) {
+        bucket.Min = value;
+        bucket.Max = value;
+    } else {
+        bucket.Min = std::min(bucket.Min, value);
+        bucket.Max = std::max(bucket.Max, value);
+    }
+    if (bucket.Count < UINT16_MAX) {
+        bucket.Sum += value;
+        bucket.Count++;
+    }
+    bucket.Energy += energy;
+}
+
+size_t HistoryRollup::capacity(const HistoryResolution resolution)
+{
+    switch (resolution) {
+    case HistoryResolution::Minute:
+        return HISTORY_ROLLUP_MINUTES;
+    case HistoryResolution::Quarter:
+        return HISTORY_ROLLUP_QUARTERS;
+    default:
+        return HISTORY_ROLLUP_DAYS;
+    }
+}
+
+uint32_t HistoryRollup::interval(const HistoryResolution resolution)
+{
+    switch (resolution) {
+    case HistoryResolution::Minute:
+        return 60;
+    case HistoryResolution::Quarter:
+        return 15 * 60;
+    default:
+        return 24 * 60 * 60;
+    }
+}
+
+HistoryBucket_t HistoryRollup::at(const HistoryResolution resolution, const size_t index) const
+{
+    switch (resolution) {
+    case HistoryResolution::Minute:
+        return _minutes.at(index);
+    case HistoryResolution::Quarter:
+        return _quarters.at(index);
+    default:
+        return _days.at(index);
+    }
+}
+
+bool HistoryRollup::write(FILE* file) const
+{
+    return fwrite(this, sizeof(*this), 1, file) == 1;
+}
+
+void HistoryRollup::clear()
+{
+    _minutes.clear();
+    _quarters.clear();
+    _days.clear();
+    _lastTime = 0;
+    _lastPower = 0;
+}
+
+// Reads directly into this, the rollup is too large for a temporary copy on the stack
+bool HistoryRollup::read(FILE* file)
+{
+    if (fread(this, sizeof(*this), 1, file) != 1
+        || !_minutes.isValid() || !_quarters.isValid() || !_days.isValid()) {
+        clear();
+        return false;
+    }
+    return true;
+}
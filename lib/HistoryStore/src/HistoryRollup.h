@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+
+// Number of buckets kept per resolution
+#define HISTORY_ROLLUP_MINUTES 60U // 1 hour
+#define HISTORY_ROLLUP_QUARTERS 96U // 24 hours
+#define HISTORY_ROLLUP_DAYS 31U // 1 month
+
+// Samples which are further apart are not integrated into the energy
+#define HISTORY_ROLLUP_MAX_GAP 300U
+
+enum class HistoryResolution : uint8_t {
+    Minute,
+    Quarter,
+    Day,
+};
+
+// Bucket as returned to the users of a rollup
+struct HistoryBucket_t {
+    uint32_t Start; // Unix time in seconds, 0 if the bucket is unused
+    uint32_t Count;
+    float Min;
+    float Max;
+    float Sum;
+    float Energy; // Wh
+
+    float getAverage() const { return Count > 0 ? Sum / Count : 0; }
+};
+
+// Bucket as kept in memory. Power is stored in whole W (up to 65535 W), the start
+// is kept as age relative to the newest bucket of the ring.
+struct HistoryRollupBucket_t {
+    uint16_t Age; // in steps of the ring
+    uint16_t Count; // 0 if the bucket is unused, saturates
+    uint16_t Min;
+    uint16_t Max;
+    uint32_t Sum;
+    float Energy; // Wh
+};
+
+// Fixed size ring of buckets of one resolution, the newest bucket is at _head.
+// Step is the unit of the age in seconds and has to divide the distance of any two
+// bucket starts, also across changes of the UTC offset (e.g. 900 for daily buckets).
+template <size_t Capacity, uint32_t Step>
+class HistoryBucketRing {
+public:
+    // Returns the bucket starting at start, replacing the oldest bucket if required
+    HistoryRollupBucket_t& get(const uint32_t start)
+    {
+        HistoryRollupBucket_t& head = _buckets[_head];
+
+        // Samples older than the newest bucket are added to it
+        if (_start >= start) {
+            return head;
+        }
+
+        // Buckets too old for their age are dropped
+        const uint32_t elapsed = _start > 0 ? (start - _start) / Step : UINT16_MAX;
+        for (auto& bucket : _buckets) {
+            if (bucket.Count > 0 && bucket.Age + elapsed < UINT16_MAX) {
+                bucket.Age += elapsed;
+            } else {
+                bucket = {};
+            }
+        }
+
+        _head = (_head + 1) % Capacity;
+        _buckets[_head] = {};
+        _start = start;
+        return _buckets[_head];
+    }
+
+    // index 0 is the oldest bucket, unused buckets have Start == 0
+    HistoryBucket_t at(const size_t index) const
+    {
+        const HistoryRollupBucket_t& bucket = _buckets[(_head + 1 + index) % Capacity];
+        if (bucket.Count == 0) {
+            return {};
+        }
+        return { _start - bucket.Age * Step, bucket.Count, static_cast<float>(bucket.Min),
+            static_cast<float>(bucket.Max), static_cast<float>(bucket.Sum), bucket.Energy };
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    bool isValid() const { return _head < Capacity; }
+
+    void clear()
+    {
+        _buckets.fill({});
+        _head = 0;
+        _start = 0;
+    }
+
+private:
+    std::array<HistoryRollupBucket_t, Capacity> _buckets = {};
+    uint32_t _start = 0; // of the bucket at _head
+    size_t _head = 0;
+};
+
+// Incrementally maintained min/max/avg/energy buckets of a power value at
+// several resolutions. The memory does not depend on the number of samples,
+// one rollup takes about 3 KB. At most UINT16_MAX samples are averaged per
+// bucket, so samples should be added at most every 2 s.
+class HistoryRollup {
+public:
+    // power in W. utcOffset aligns the daily buckets with local midnight.
+    void add(const uint32_t time, const int32_t utcOffset, const float power);
+
+    static size_t capacity(const HistoryResolution resolution);
+    static uint32_t interval(const HistoryResolution resolution);
+
+    // index 0 is the oldest bucket, unused buckets have Start == 0
+    HistoryBucket_t at(const HistoryResolution resolution, const size_t index) const;
+
+    void clear();
+
+    // Raw image of the buckets, only valid for the same firmware.
+    // The rollup is cleared if the image can not be read.
+    bool write(FILE* file) const;
+    bool read(FILE* file);
+
+private:
+    static void update(HistoryRollupBucket_t& bucket, const float power, const float energy);
+
+    // UTC offsets are multiples of 15 minutes
+    HistoryBucketRing<HISTORY_ROLLUP_MINUTES, 60> _minutes;
+    HistoryBucketRing<HISTORY_ROLLUP_QUARTERS, 15 * 60> _quarters;
+    HistoryBucketRing<HISTORY_ROLLUP_DAYS, 15 * 60> _days;
+
+    uint32_t _lastTime = 0;
+    float _lastPower = 0;
+};
@@ -0,0 +1,540 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "HistoryStore.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define HISTORY_VERSION 1U
+#define HISTORY_HEADER_SIZE 8U
+
+// Time delta plus one delta per value, 5 bytes per varint at most
+#define HISTORY_PAYLOAD_MAX (5U + 5U * HISTORY_MAX_SERIES)
+
+enum class RecordResult {
+    Ok,
+    End,
+    Invalid,
+};
+
+static uint8_t crc8(const uint8_t* buf, const size_t len)
+{
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static void putVarint(uint8_t* buf, size_t& pos, uint32_t value)
+{
+    while (value >= 0x80) {
+        buf[pos++] = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    buf[pos++] = static_cast<uint8_t>(value);
+}
+
+static bool getVarint(const uint8_t* buf, const size_t len, size_t& pos, uint32_t& value)
+{
+    value = 0;
+    for (uint8_t shift = 0; shift < 35 && pos < len; shift += 7) {
+        const uint8_t b = buf[pos++];
+        value |= static_cast<uint32_t>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Deltas are calculated modulo 2^32, so every int32 value can be represented
+static uint32_t zigzag(const int32_t value, const int32_t last)
+{
+    const int32_t delta = static_cast<int32_t>(static_cast<uint32_t>(value) - static_cast<uint32_t>(last));
+    return (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+}
+
+static int32_t unzigzag(const uint32_t value, const int32_t last)
+{
+    const uint32_t delta = (value >> 1) ^ (~(value & 1) + 1);
+    return static_cast<int32_t>(static_cast<uint32_t>(last) + delta);
+}
+
+static bool readHeader(FILE* file, uint8_t& count, uint32_t& start)
+{
+    uint8_t header[HISTORY_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header)
+        || header[0] != 'H' || header[1] != 'S' || header[2] != HISTORY_VERSION
+        || header[3] == 0 || header[3] > HISTORY_MAX_SERIES) {
+        return false;
+    }
+
+    count = header[3];
+    start = header[4] | (header[5] << 8) | (header[6] << 16) | (static_cast<uint32_t>(header[7]) << 24);
+    return true;
+}
+
+// Applies the next record of the file to last, which holds the previous sample
+static RecordResult readRecord(FILE* file, HistorySample_t& last, size_t& length)
+{
+    const int len = fgetc(file);
+    if (len == EOF) {
+        return RecordResult::End;
+    }
+    if (len == 0 || len > static_cast<int>(HISTORY_PAYLOAD_MAX)) {
+        return RecordResult::Invalid;
+    }
+
+    uint8_t buf[HISTORY_PAYLOAD_MAX + 1];
+    if (fread(buf, 1, len + 1, file) != static_cast<size_t>(len + 1) || crc8(buf, len) != buf[len]) {
+        return RecordResult::Invalid;
+    }
+
+    size_t pos = 0;
+    uint32_t value;
+    if (!getVarint(buf, len, pos, value)) {
+        return RecordResult::Invalid;
+    }
+    last.Time += value;
+
+    for (uint8_t i = 0; i < last.Count; i++) {
+        if (!getVarint(buf, len, pos, value)) {
+            return RecordResult::Invalid;
+        }
+        last.Values[i] = unzigzag(value, last.Values[i]);
+    }
+
+    if (pos != static_cast<size_t>(len)) {
+        return RecordResult::Invalid;
+    }
+
+    length = len + 2;
+    return RecordResult::Ok;
+}
+
+bool HistoryStore::begin(const char* basePath, const uint32_t maxSegments)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _basePath = basePath;
+    _maxSegments = maxSegments;
+    _series.clear();
+
+    mkdir(basePath, 0775);
+
+    DIR* dir = opendir(basePath);
+    if (dir == nullptr) {
+        return false;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        uint64_t id;
+        uint32_t number;
+        char suffix[5] = {};
+        if (sscanf(entry->d_name, "%12" SCNx64 "_%8" SCNx32 ".%4s", &id, &number, suffix) != 3 || strcmp(suffix, "seg") != 0) {
+            continue;
+        }
+
+        const std::string path = getSegmentPath(id, number);
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            continue;
+        }
+
+        uint8_t count;
+        uint32_t start;
+        const bool valid = readHeader(file, count, start);
+        fclose(file);
+
+        if (!valid) {
+            remove(path.c_str());
+            continue;
+        }
+
+        _series[id].Segments.push_back({ number, start });
+    }
+    closedir(dir);
+
+    for (auto& [id, series] : _series) {
+        std::sort(series.Segments.begin(), series.Segments.end(), [](const HistorySegment_t& a, const HistorySegment_t& b) {
+            return a.Number < b.Number;
+        });
+        recover(id, series);
+    }
+
+    while (_maxSegments > 0 && getSegmentCountLocked() > _maxSegments) {
+        removeOldestSegment();
+    }
+
+    return true;
+}
+
+void HistoryStore::recover(const uint64_t id, Series_t& series)
+{
+    series.Sealed = true;
+    if (series.Segments.empty()) {
+        return;
+    }
+
+    const std::string path = getSegmentPath(id, series.Segments.back().Number);
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return;
+    }
+
+    HistorySample_t last = {};
+    if (readHeader(file, last.Count, last.Time)) {
+        series.Size = HISTORY_HEADER_SIZE;
+
+        RecordResult result;
+        size_t length;
+        while ((result = readRecord(file, last, length)) == RecordResult::Ok) {
+            series.Size += length;
+        }
+
+        // Continue the segment only if it ends with a complete record
+        series.Sealed = result != RecordResult::End || series.Size >= HISTORY_SEGMENT_SIZE;
+        series.Count = last.Count;
+        series.LastTime = last.Time;
+        memcpy(series.Last, last.Values, sizeof(series.Last));
+    }
+
+    fclose(file);
+}
+
+bool HistoryStore::append(const uint64_t id, const HistorySample_t& sample)
+{
+    if (sample.Count == 0 || sample.Count > HISTORY_MAX_SERIES) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto& series = _series[id];
+    if (sample.Time <= series.LastTime) {
+        return false;
+    }
+
+    if ((series.Sealed || series.Count != sample.Count) && !startSegment(id, series, sample)) {
+        return false;
+    }
+
+    uint8_t record[HISTORY_PAYLOAD_MAX + 2];
+    size_t pos;
+
+    auto encode = [&]() {
+        pos = 1;
+        putVarint(record, pos, sample.Time - series.LastTime);
+        for (uint8_t i = 0; i < sample.Count; i++) {
+            putVarint(record, pos, zigzag(sample.Values[i], series.Last[i]));
+        }
+        record[0] = pos - 1;
+        record[pos] = crc8(&record[1], pos - 1);
+        pos++;
+    };
+
+    encode();
+    if (series.Size + pos > HISTORY_SEGMENT_SIZE) {
+        if (!startSegment(id, series, sample)) {
+            return false;
+        }
+        encode();
+    }
+
+    series.Pending.insert(series.Pending.end(), record, record + pos);
+    series.Size += pos;
+    series.LastTime = sample.Time;
+    memcpy(series.Last, sample.Values, sizeof(series.Last));
+
+    if (series.Pending.size() >= HISTORY_PENDING_MAX) {
+        flushSeries(id, series);
+    }
+
+    return true;
+}
+
+bool HistoryStore::startSegment(const uint64_t id, Series_t& series, const HistorySample_t& sample)
+{
+    flushSeries(id, series);
+
+    if (_maxSegments == 0) {
+        return false;
+    }
+
+    while (getSegmentCountLocked() >= _maxSegments) {
+        removeOldestSegment();
+    }
+
+    const uint32_t number = series.Segments.empty() ? 0 : series.Segments.back().Number + 1;
+    series.Segments.push_back({ number, sample.Time });
+
+    const uint8_t header[HISTORY_HEADER_SIZE] = {
+        'H', 'S', HISTORY_VERSION, sample.Count,
+        static_cast<uint8_t>(sample.Time), static_cast<uint8_t>(sample.Time >> 8),
+        static_cast<uint8_t>(sample.Time >> 16), static_cast<uint8_t>(sample.Time >> 24)
+    };
+    series.Pending.assign(header, header + sizeof(header));
+    series.Size = sizeof(header);
+    series.Sealed = false;
+    series.Count = sample.Count;
+    series.LastTime = sample.Time;
+    memset(series.Last, 0, sizeof(series.Last));
+
+    return true;
+}
+
+void HistoryStore::flush()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto& [id, series] : _series) {
+        flushSeries(id, series);
+    }
+}
+
+void HistoryStore::flushSeries(const uint64_t id, Series_t& series)
+{
+    if (series.Pending.empty()) {
+        return;
+    }
+
+    const std::string path = getSegmentPath(id, series.Segments.back().Number);
+    FILE* file = fopen(path.c_str(), "ab");
+    bool success = file != nullptr;
+    if (success) {
+        success = fwrite(series.Pending.data(), 1, series.Pending.size(), file) == series.Pending.size();
+        success = fclose(file) == 0 && success;
+    }
+
+    // A partially written segment ends with an invalid record, so don't append to it anymore
+    if (!success) {
+        series.Sealed = true;
+    }
+
+    series.Pending.clear();
+}
+
+void HistoryStore::removeOldestSegment()
+{
+    uint64_t oldestId = 0;
+    Series_t* oldest = nullptr;
+
+    for (auto& [id, series] : _series) {
+        if (!series.Segments.empty() && (oldest == nullptr || series.Segments.front().Start < oldest->Segments.front().Start)) {
+            oldestId = id;
+            oldest = &series;
+        }
+    }
+
+    if (oldest == nullptr) {
+        return;
+    }
+
+    remove(getSegmentPath(oldestId, oldest->Segments.front().Number).c_str());
+    oldest->Segments.erase(oldest->Segments.begin());
+
+    if (oldest->Segments.empty()) {
+        oldest->Pending.clear();
+        oldest->Sealed = true;
+    }
+}
+
+uint8_t HistoryStore::getSeriesCount(const uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _series.find(id);
+    if (it == _series.end() || it->second.Segments.empty()) {
+        return 0;
+    }
+    return it->second.Count;
+}
+
+std::vector<HistorySegment_t> HistoryStore::getSegments(const uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _series.find(id);
+    if (it == _series.end()) {
+        return {};
+    }
+    return it->second.Segments;
+}
+
+uint32_t HistoryStore::getSegmentCount()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return getSegmentCountLocked();
+}
+
+uint32_t HistoryStore::getSegmentCountLocked() const
+{
+    uint32_t count = 0;
+    for (auto& [id, series] : _series) {
+        count += series.Segments.size();
+    }
+    return count;
+}
+
+uint32_t HistoryStore::getMaxSegments() const
+{
+    return _maxSegments;
+}
+
+const std::string& HistoryStore::getBasePath() const
+{
+    return _basePath;
+}
+
+std::string HistoryStore::getSegmentPath(const uint64_t id, const uint32_t number) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/%012" PRIx64 "_%08" PRIx32 ".seg", id, number);
+    return _basePath + name;
+}
+
+HistoryReader::HistoryReader(HistoryStore& store, const uint64_t id, const uint32_t start, const uint32_t end)
+    : _store(store)
+    , _id(id)
+    , _start(start)
+    , _end(end)
+    , _segments(store.getSegments(id))
+{
+    // Skip all segments which end before the range starts
+    while (_segment + 1 < _segments.size() && _segments[_segment + 1].Start <= _start) {
+        _segment++;
+    }
+}
+
+HistoryReader::~HistoryReader()
+{
+    closeSegment();
+}
+
+bool HistoryReader::next(HistorySample_t& sample)
+{
+    while (_segment < _segments.size()) {
+        if (_file == nullptr) {
+            if (_segments[_segment].Start > _end) {
+                break;
+            }
+            if (!openSegment()) {
+                _segment++;
+                continue;
+            }
+        }
+
+        size_t length;
+        if (readRecord(_file, _last, length) != RecordResult::Ok) {
+            closeSegment();
+            _segment++;
+            continue;
+        }
+
+        if (_last.Time > _end) {
+            break;
+        }
+
+        if (_last.Time >= _start) {
+            sample = _last;
+            return true;
+        }
+    }
+
+    closeSegment();
+    _segment = _segments.size();
+    return false;
+}
+
+bool HistoryReader::openSegment()
+{
+    _file = fopen(_store.getSegmentPath(_id, _segments[_segment].Number).c_str(), "rb");
+    if (_file == nullptr) {
+        return false;
+    }
+    setvbuf(_file, _fileBuffer, _IOFBF, sizeof(_fileBuffer));
+
+    _last = {};
+    if (!readHeader(_file, _last.Count, _last.Time)) {
+        closeSegment();
+        return false;
+    }
+    return true;
+}
+
+void HistoryReader::closeSegment()
+{
+    if (_file != nullptr) {
+        fclose(_file);
+        _file = nullptr;
+    }
+}
+
+HistoryDownsampler::HistoryDownsampler(const uint32_t start, const uint32_t interval, const uint32_t lastMask)
+    : _start(start)
+    , _interval(std::max<uint32_t>(interval, 1))
+    , _lastMask(lastMask)
+{
+}
+
+bool HistoryDownsampler::add(const HistorySample_t& sample, HistorySample_t& bucket)
+{
+    if (sample.Time < _start) {
+        return false;
+    }
+
+    const uint32_t index = (sample.Time - _start) / _interval;
+    bool completed = false;
+
+    if (_samples > 0 && (index != _bucket || sample.Count != _count)) {
+        complete(bucket);
+        completed = true;
+    }
+
+    if (_samples == 0) {
+        _bucket = index;
+        _count = sample.Count;
+        memset(_sums, 0, sizeof(_sums));
+    }
+
+    for (uint8_t i = 0; i < _count; i++) {
+        _sums[i] += sample.Values[i];
+        _last[i] = sample.Values[i];
+    }
+    _samples++;
+
+    return completed;
+}
+
+bool HistoryDownsampler::finish(HistorySample_t& bucket)
+{
+    if (_samples == 0) {
+        return false;
+    }
+    complete(bucket);
+    return true;
+}
+
+void HistoryDownsampler::complete(HistorySample_t& bucket)
+{
+    bucket.Time = _start + _bucket * _interval;
+    bucket.Count = _count;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_lastMask & (1U << i)) {
+            bucket.Values[i] = _last[i];
+        } else {
+            bucket.Values[i] = static_cast<int32_t>(std::llround(static_cast<double>(_sums[i]) / _samples));
+        }
+    }
+    _samples = 0;
+}
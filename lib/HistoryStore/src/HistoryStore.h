@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Maximum number of values per sample
+#define HISTORY_MAX_SERIES 16U
+
+// Size of a segment file including its header. Matches the LittleFS block size.
+#define HISTORY_SEGMENT_SIZE 4096U
+
+// Pending records are written once they exceed this size, regardless of flush()
+#define HISTORY_PENDING_MAX 512U
+
+struct HistorySample_t {
+    uint32_t Time; // Unix time in seconds
+    uint8_t Count;
+    int32_t Values[HISTORY_MAX_SERIES];
+};
+
+struct HistorySegment_t {
+    uint32_t Number;
+    uint32_t Start; // Time of the first sample
+};
+
+// Append only time series store with one series set (e.g. one inverter)
+// per 48 bit id. Every series set is written to a ring of fixed size segment
+// files named <id>_<number>.seg in the base directory:
+//
+//   header:  'H' 'S' version count start(uint32 little endian)
+//   record:  length payload crc8(payload)
+//   payload: varint(time delta) zigzag varint(value delta) * count
+//
+// Deltas are relative to the previous record of the same segment, the first
+// record is relative to the segment start and zero. A record which is
+// truncated or fails the CRC ends the segment, writing continues in a new one.
+// If the number of segments of all ids exceeds the limit, the segment with
+// the oldest start time is deleted.
+//
+// Samples are collected in RAM and appended by flush(), so a power loss loses
+// at most the samples since the last flush.
+class HistoryStore {
+public:
+    // Scans the existing segments of the base directory, which is created if required
+    bool begin(const char* basePath, const uint32_t maxSegments);
+
+    // Samples older than or as old as the last sample of the id are ignored
+    bool append(const uint64_t id, const HistorySample_t& sample);
+
+    // Writes the pending records of all ids
+    void flush();
+
+    // Number of values per sample of the last segment, 0 if there is no data
+    uint8_t getSeriesCount(const uint64_t id);
+
+    // Segments of the id, ordered by time
+    std::vector<HistorySegment_t> getSegments(const uint64_t id);
+
+    uint32_t getSegmentCount();
+    uint32_t getMaxSegments() const;
+    const std::string& getBasePath() const;
+
+    std::string getSegmentPath(const uint64_t id, const uint32_t number) const;
+
+private:
+    struct Series_t {
+        std::vector<HistorySegment_t> Segments;
+
+        // State of the last segment
+        uint32_t Size = 0; // Including pending records
+        bool Sealed = true; // No more records can be appended to the last segment
+        uint8_t Count = 0;
+        uint32_t LastTime = 0;
+        int32_t Last[HISTORY_MAX_SERIES] = {};
+
+        std::vector<uint8_t> Pending;
+    };
+
+    void recover(const uint64_t id, Series_t& series);
+    bool startSegment(const uint64_t id, Series_t& series, const HistorySample_t& sample);
+    void flushSeries(const uint64_t id, Series_t& series);
+    void removeOldestSegment();
+    uint32_t getSegmentCountLocked() const;
+
+    std::mutex _mutex;
+    std::string _basePath;
+    uint32_t _maxSegments = 0;
+    std::map<uint64_t, Series_t> _series;
+};
+
+// Reads the samples of one id within a time range. Only one record of one
+// segment is kept in RAM. Segments deleted while reading are skipped.
+class HistoryReader {
+public:
+    HistoryReader(HistoryStore& store, const uint64_t id, const uint32_t start, const uint32_t end);
+    ~HistoryReader();
+    HistoryReader(const HistoryReader&) = delete;
+    HistoryReader& operator=(const HistoryReader&) = delete;
+
+    // Returns false if there are no more samples within the range
+    bool next(HistorySample_t& sample);
+
+private:
+    bool openSegment();
+    void closeSegment();
+
+    HistoryStore& _store;
+    uint64_t _id;
+    uint32_t _start;
+    uint32_t _end;
+
+    std::vector<HistorySegment_t> _segments;
+    size_t _segment = 0;
+
+    FILE* _file = nullptr;
+    char _fileBuffer[128];
+    HistorySample_t _last = {};
+};
+
+// Combines the samples of equally sized time buckets. Values are averaged,
+// except for cumulative series (e.g. yield) marked in lastMask which keep
+// their last value.
+class HistoryDownsampler {
+public:
+    HistoryDownsampler(const uint32_t start, const uint32_t interval, const uint32_t lastMask);
+
+    // Returns true and the completed bucket if the sample belongs to a later bucket
+    bool add(const HistorySample_t& sample, HistorySample_t& bucket);
+
+    // Returns true and the last bucket if it contains samples
+    bool finish(HistorySample_t& bucket);
+
+private:
+    void complete(HistorySample_t& bucket);
+
+    uint32_t _start;
+    uint32_t _interval;
+    uint32_t _lastMask;
+
+    uint32_t _bucket = 0;
+    uint32_t _samples = 0;
+    uint8_t _count = 0;
+    int64_t _sums[HISTORY_MAX_SERIES] = {};
+    int32_t _last[HISTORY_MAX_SERIES] = {};
+};
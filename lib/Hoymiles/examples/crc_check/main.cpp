@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+
+/*
+Compares the table driven crc8() and crc16() with the previous bit by bit
+implementation over random buffers, lengths and start values and reports
+the throughput of both.
+
+Build and run:
+    pio run -e native_crc_check
+    .pio/build/native_crc_check/program [buffers] [rounds]
+*/
+#include <crc.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Reference implementations as they were before the lookup tables
+static uint8_t crc8Bitwise(const uint8_t buf[], const uint8_t len)
+{
+    uint8_t crc = CRC8_INIT;
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc << 1) ^ ((crc & 0x80) ? CRC8_POLY : 0x00);
+        }
+    }
+    return crc;
+}
+
+static uint16_t crc16Bitwise(const uint8_t buf[], const uint8_t len, const uint16_t start)
+{
+    uint16_t crc = start;
+    uint8_t shift = 0;
+
+    for (uint8_t i = 0; i < len; i++) {
+        crc = crc ^ buf[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            shift = (crc & 0x0001);
+            crc = crc >> 1;
+            if (shift != 0)
+                crc = crc ^ 0xA001;
+        }
+    }
+    return crc;
+}
+
+template <typename Func>
+static double measure(const char* name, const std::vector<uint8_t>& data, const uint8_t len, const uint32_t rounds, Func func)
+{
+    volatile uint32_t sink = 0;
+    const size_t frames = data.size() / len;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (size_t f = 0; f < frames; f++) {
+            sink = sink + func(&data[f * len], len);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double bytes = static_cast<double>(frames) * len * rounds;
+    printf("%-20s %3u byte frames, %.1f MB/s\n", name, len, bytes / seconds / 1e6);
+    return seconds;
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t buffers = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+    const uint32_t rounds = argc > 2 ? strtoul(argv[2], nullptr, 10) : 20;
+
+    srand(1);
+
+    // Every length a uint8_t can express, random content and start values
+    uint8_t buf[255];
+    for (uint32_t i = 0; i < buffers; i++) {
+        const uint8_t len = rand() % 256;
+        const uint16_t start = i % 2 == 0 ? 0xffff : rand() % 0x10000;
+        for (uint8_t b = 0; b < len; b++) {
+            buf[b] = rand() % 256;
+        }
+
+        if (crc8(buf, len) != crc8Bitwise(buf, len) || crc16(buf, len, start) != crc16Bitwise(buf, len, start)) {
+            fprintf(stderr, "Buffer %u with %u bytes and start %04x differs\n", i, len, start);
+            return 1;
+        }
+    }
+
+    printf("%u random buffers identical\n", buffers);
+
+    // 64 KB of frames, small enough for the cache. 27 bytes is a full statistics fragment.
+    std::vector<uint8_t> data(64 * 1024);
+    for (auto& b : data) {
+        b = rand() % 256;
+    }
+
+    for (const uint8_t len : { 11, 27 }) {
+        const double crc8Table = measure("crc8", data, len, rounds, [](const uint8_t* b, const uint8_t l) { return crc8(b, l); });
+        const double crc8Bits = measure("crc8 (bitwise)", data, len, rounds, crc8Bitwise);
+        const double crc16Table = measure("crc16", data, len, rounds, [](const uint8_t* b, const uint8_t l) { return crc16(b, l); });
+        const double crc16Bits = measure("crc16 (bitwise)", data, len, rounds, [](const uint8_t* b, const uint8_t l) { return crc16Bitwise(b, l, 0xffff); });
+        printf("%3u byte frames: crc8 %.1fx, crc16 %.1fx faster\n", len, crc8Bits / crc8Table, crc16Bits / crc16Table);
+    }
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+
+/*
+Replays a recorded serial log against a fleet of simulated inverters and reports
+the poll/parse throughput of the Hoymiles library on the host.
+
+Build and run:
+    pio run -e native
+    .pio/build/native/program <recording.log> <inverter serial> [inverter count] [polls] [expected values]
+
+The recording is a serial log captured with the "hoymiles" log tag set to debug level.
+All simulated inverters share the type of the given serial.
+
+The decoded statistics of the first inverter are printed one field per line. If a
+file with the expected values is given, the program fails if they differ. The
+native_replay_check environment does this with the recording in fixtures/:
+    pio run -e native_replay_check
+*/
+#include <Arduino.h>
+#include <Hoymiles.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <esp_log.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#define DTU_SERIAL 0x199980122304
+
+// "<type> <channel> <field> <value> [unit]" per line, the value with the digits used for publishing
+static std::string getFieldValues(StatisticsParser& statistics)
+{
+    std::string values;
+    for (auto& t : statistics.getChannelTypes()) {
+        for (auto& c : statistics.getChannelsByType(t)) {
+            for (uint8_t f = FLD_UDC; f <= FLD_IAC_3; f++) {
+                const FieldId_t field = static_cast<FieldId_t>(f);
+                if (!statistics.hasChannelFieldValue(t, c, field)) {
+                    continue;
+                }
+
+                const char* unit = statistics.getChannelFieldUnit(t, c, field);
+                char line[96];
+                snprintf(line, sizeof(line), "%s %" PRIu8 " %s %s%s%s\n",
+                    statistics.getChannelTypeName(t), static_cast<uint8_t>(c),
+                    statistics.getChannelFieldName(t, c, field),
+                    statistics.getChannelFieldValueString(t, c, field).c_str(),
+                    unit[0] != '\0' ? " " : "", unit);
+                values += line;
+            }
+        }
+    }
+    return values;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <recording.log> <inverter serial> [inverter count] [polls] [expected values]\n", argv[0]);
+        return 1;
+    }
+
+    const uint64_t baseSerial = strtoull(argv[2], nullptr, 16);
+    const uint32_t inverterCount = argc > 3 ? strtoul(argv[3], nullptr, 10) : 1;
+    const uint32_t pollCount = argc > 4 ? strtoul(argv[4], nullptr, 10) : 1000;
+
+    esp_log_level_set("*", ESP_LOG_ERROR);
+
+    Hoymiles.init();
+
+    for (auto* radio : { Hoymiles.getRadioNrf(), Hoymiles.getRadioCmt() }) {
+        std::ifstream recording(argv[1]);
+        if (!recording) {
+            fprintf(stderr, "Unable to open %s\n", argv[1]);
+            return 1;
+        }
+        const size_t fragments = radio->loadRecording(recording);
+        if (fragments == 0) {
+            fprintf(stderr, "No fragments found in %s\n", argv[1]);
+            return 1;
+        }
+        radio->setDtuSerial(DTU_SERIAL);
+    }
+
+    for (uint32_t i = 0; i < inverterCount; i++) {
+        char name[MAX_NAME_LENGTH];
+        snprintf(name, sizeof(name), "Sim %" PRIu32, i);
+        if (Hoymiles.addInverter(name, baseSerial + i) == nullptr) {
+            fprintf(stderr, "Serial %s is not supported\n", argv[2]);
+            return 1;
+        }
+    }
+
+    uint32_t polls = 0;
+    uint32_t loops = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    while (polls < pollCount) {
+        Hoymiles.loop();
+        // Poll interval and radio timeouts are based on millis(). Use virtual time.
+        advanceMillis(1);
+        loops++;
+
+        polls = 0;
+        for (uint32_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+            polls += Hoymiles.getInverterByPos(i)->RadioStats.RxSuccess;
+        }
+    }
+
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+    auto inv = Hoymiles.getInverterByPos(0);
+    printf("%s: %.1f W AC, %.3f kWh total\n", inv->typeName().c_str(),
+        inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC),
+        inv->Statistics()->getChannelFieldValue(TYPE_INV, CH0, FLD_YT));
+    printf("%" PRIu32 " successful requests in %" PRIu32 " loops, %.3f s (%.0f requests/s)\n",
+        polls, loops, duration.count(), polls / duration.count());
+
+    const std::string values = getFieldValues(*inv->Statistics());
+    printf("%s", values.c_str());
+
+    if (argc > 5) {
+        std::ifstream expectedFile(argv[5]);
+        if (!expectedFile) {
+            fprintf(stderr, "Unable to open %s\n", argv[5]);
+            return 1;
+        }
+        std::stringstream expected;
+        expected << expectedFile.rdbuf();
+
+        if (expected.str() != values) {
+            fprintf(stderr, "Decoded values differ from %s, expected:\n%s", argv[5], expected.str().c_str());
+            return 1;
+        }
+        printf("Decoded values match %s\n", argv[5]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+
+/*
+Looks up every statistic field of an HM-1500 through the dense field index
+and through a linear search over the byte assignment as it was done before.
+Verifies that both find the same entries and reports the lookups per second
+of both, of getChannelFieldValue() and of copying one frame.
+
+Build and run:
+    pio run -e native_statistics_benchmark
+    .pio/build/native_statistics_benchmark/program [rounds]
+*/
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <inverters/HM_4CH.h>
+#include <vector>
+
+struct FieldKey_t {
+    ChannelType_t Type;
+    ChannelNum_t Channel;
+    FieldId_t Field;
+};
+
+// Previous implementation of getAssignmentByChannelField()
+static const byteAssign_t* findLinear(const byteAssign_t* assignment, const uint8_t size, const FieldKey_t& key)
+{
+    for (uint8_t i = 0; i < size; i++) {
+        if (assignment[i].type == key.Type && assignment[i].ch == key.Channel && assignment[i].fieldId == key.Field) {
+            return &assignment[i];
+        }
+    }
+    return nullptr;
+}
+
+template <typename Func>
+static double measure(const char* name, const uint32_t rounds, const std::vector<FieldKey_t>& keys, Func func)
+{
+    volatile uintptr_t sink = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (auto& key : keys) {
+            sink = sink + func(key);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double lookups = static_cast<double>(rounds) * keys.size() / seconds;
+    printf("%-24s %.1fM lookups/s\n", name, lookups / 1e6);
+    return lookups;
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t rounds = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+
+    HM_4CH inv(nullptr, 0x116182345678ULL);
+    inv.init();
+    auto stats = inv.Statistics();
+
+    // The byte assignment is one array, its first entry has the lowest address
+    std::vector<FieldKey_t> keys;
+    const byteAssign_t* assignment = nullptr;
+    const byteAssign_t* last = nullptr;
+    for (auto& type : stats->getChannelTypes()) {
+        for (auto& channel : stats->getChannelsByType(type)) {
+            for (uint8_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++) {
+                const FieldKey_t key = { type, channel, static_cast<FieldId_t>(f) };
+                const byteAssign_t* pos = stats->getAssignmentByChannelField(key.Type, key.Channel, key.Field);
+                if (pos == nullptr) {
+                    continue;
+                }
+                keys.push_back(key);
+                if (assignment == nullptr || pos < assignment) {
+                    assignment = pos;
+                }
+                if (last == nullptr || pos > last) {
+                    last = pos;
+                }
+            }
+        }
+    }
+    const uint8_t size = last - assignment + 1;
+
+    for (auto& key : keys) {
+        if (findLinear(assignment, size, key) != stats->getAssignmentByChannelField(key.Type, key.Channel, key.Field)) {
+            fprintf(stderr, "Lookup of field %d of channel %d differs\n", key.Field, key.Channel);
+            return 1;
+        }
+    }
+
+    printf("%zu fields of an HM-1500 identical\n", keys.size());
+
+    const double linear = measure("linear search", rounds, keys, [&](const FieldKey_t& key) {
+        return reinterpret_cast<uintptr_t>(findLinear(assignment, size, key));
+    });
+    const double dense = measure("dense index", rounds, keys, [&](const FieldKey_t& key) {
+        return reinterpret_cast<uintptr_t>(stats->getAssignmentByChannelField(key.Type, key.Channel, key.Field));
+    });
+    measure("getChannelFieldValue", rounds, keys, [&](const FieldKey_t& key) {
+        return static_cast<uintptr_t>(stats->getChannelFieldValue(key.Type, key.Channel, key.Field));
+    });
+
+    std::vector<float> values;
+    measure("getFieldValues (frames)", rounds / keys.size() + 1, keys, [&](const FieldKey_t&) {
+        return static_cast<uintptr_t>(stats->getFieldValues(values));
+    });
+
+    printf("dense index %.1fx faster than linear search\n", dense / linear);
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Bucket i contains all values <= First * 2^i
+template <int32_t First>
+struct LogBuckets {
+    static constexpr int32_t upperBound(const size_t bucket) { return First << bucket; }
+};
+
+// Bucket i contains all values <= First + Step * i
+template <int32_t First, int32_t Step>
+struct LinearBuckets {
+    static constexpr int32_t upperBound(const size_t bucket) { return First + Step * static_cast<int32_t>(bucket); }
+};
+
+// Fixed size histogram which does not allocate memory.
+// The last bucket contains all values above the upper bound of the
+// second last bucket (+Inf). Bucket counts are not cumulative.
+template <typename Buckets, size_t BucketCount>
+class Histogram {
+    static_assert(BucketCount > 1, "At least one bucket plus the +Inf bucket is required");
+
+public:
+    void add(const int32_t value)
+    {
+        size_t bucket = 0;
+        while (bucket < BucketCount - 1 && value > Buckets::upperBound(bucket)) {
+            bucket++;
+        }
+        _buckets[bucket]++;
+        _count++;
+        _sum += value;
+    }
+
+    uint32_t getCount() const { return _count; }
+    int64_t getSum() const { return _sum; }
+    uint32_t getBucket(const size_t bucket) const { return _buckets[bucket]; }
+
+    // Not defined for the last (+Inf) bucket
+    static constexpr int32_t getUpperBound(const size_t bucket) { return Buckets::upperBound(bucket); }
+    static constexpr size_t size() { return BucketCount; }
+
+private:
+    uint32_t _buckets[BucketCount] = {};
+    uint32_t _count = 0;
+    int64_t _sum = 0;
+};
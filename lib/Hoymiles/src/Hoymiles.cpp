@@ -17,6 +17,7 @@
 #include "inverters/HM_2CH.h"
 #include "inverters/HM_4CH.h"
 #include <Arduino.h>
+#include <cmath>
 #include <esp_log.h>
 
 #undef TAG
@@ -29,8 +30,13 @@ void HoymilesClass::init()
     _pollInterval = 0;
     _radioNrf.reset(new HoymilesRadio_NRF());
     _radioCmt.reset(new HoymilesRadio_CMT());
+#ifdef HOY_NATIVE
+    _radioNrf->init();
+    _radioCmt->init();
+#endif
 }
 
+#ifndef HOY_NATIVE
 void HoymilesClass::initNRF(SPIClass* initialisedSpiBus, const uint8_t pinCE, const uint8_t pinIRQ)
 {
     _radioNrf->init(initialisedSpiBus, pinCE, pinIRQ);
@@ -40,6 +46,7 @@ void HoymilesClass::initCMT(const int8_t pin_sdio, const int8_t pin_clk, const i
 {
     _radioCmt->init(pin_sdio, pin_clk, pin_cs, pin_fcs, pin_gpio2, pin_gpio3);
 }
+#endif
 
 void HoymilesClass::loop()
 {
@@ -47,107 +54,209 @@ void HoymilesClass::loop()
     _radioNrf->loop();
     _radioCmt->loop();
 
-    if (getNumInverters() == 0 || millis() - _lastPoll <= (_pollInterval * 1000)) {
-        return;
+    // Settings changed by other tasks are applied to the statistics here
+    for (auto& inv : _inverters) {
+        inv->Statistics()->decodePendingFields();
     }
 
-    static uint8_t inverterPos = 0;
+    // Both radios work independently from each other. Each one polls its own inverters
+    // so a NRF and a CMT inverter can be fetched at the same time.
+    scheduleRadio(_scheduleNrf, _radioNrf.get());
+    scheduleRadio(_scheduleCmt, _radioCmt.get());
 
-    std::shared_ptr<InverterAbstract> iv = getInverterByPos(inverterPos);
-    if ((iv == nullptr) || ((iv != nullptr) && (!iv->getRadio()->isInitialized()))) {
-        if (++inverterPos >= getNumInverters()) {
-            inverterPos = 0;
+    // Perform housekeeping of all inverters on day change
+    const int8_t currentWeekDay = Utils::getWeekDay();
+    static int8_t lastWeekDay = -1;
+    if (lastWeekDay == -1) {
+        lastWeekDay = currentWeekDay;
+    } else {
+        if (currentWeekDay != lastWeekDay) {
+
+            for (auto& inv : _inverters) {
+                inv->performDailyTask();
+            }
+
+            lastWeekDay = currentWeekDay;
         }
     }
+}
+
+void HoymilesClass::scheduleRadio(RadioSchedule_t& schedule, HoymilesRadio* radio)
+{
+    if (!radio->isInitialized() || millis() - schedule.lastPoll <= (_pollInterval * 1000)) {
+        return;
+    }
+
+    // Don't add further requests as long as the radio is busy with the previous ones
+    if (radio->getQueueSize() > HOY_RADIO_POLL_BUDGET) {
+        return;
+    }
 
-    if (iv != nullptr && iv->getRadio()->isInitialized()) {
+    std::shared_ptr<InverterAbstract> iv = _adaptivePolling ? getNextInverterAdaptive(radio) : getNextInverter(schedule, radio);
+    if (iv == nullptr) {
+        return;
+    }
 
-        if (iv->getZeroValuesIfUnreachable() && !iv->isReachable()) {
-            iv->Statistics()->zeroRuntimeData();
+    if (_adaptivePolling) {
+        updateBackoff(iv.get());
+    }
+
+    const bool polled = pollInverter(iv.get());
+
+    const uint32_t now = millis();
+    if (polled) {
+        schedule.lastPoll = now;
+        iv->PollState.EffectiveInterval = iv->PollState.LastPoll > 0 ? now - iv->PollState.LastPoll : 0;
+    }
+    iv->PollState.LastPoll = now;
+}
+
+std::shared_ptr<InverterAbstract> HoymilesClass::getNextInverter(RadioSchedule_t& schedule, const HoymilesRadio* radio)
+{
+    const size_t count = getNumInverters();
+    for (size_t i = 0; i < count; i++) {
+        if (schedule.inverterPos >= count) {
+            schedule.inverterPos = 0;
         }
 
-        if (iv->getEnablePolling() || iv->getEnableCommands()) {
-            ESP_LOGI(TAG, "Fetch inverter: %s", iv->serialString().c_str());
+        std::shared_ptr<InverterAbstract> iv = _inverters[schedule.inverterPos++];
+        if (iv->getRadio() == radio) {
+            return iv;
+        }
+    }
 
-            if (!iv->isReachable()) {
-                iv->sendChangeChannelRequest();
-            }
+    return nullptr;
+}
 
-            if (Utils::getTimeAvailable()) {
-                // Fetch statistics
-                iv->sendStatsRequest();
-
-                // Fetch event log
-                const bool force = iv->EventLog()->getLastAlarmRequestSuccess() == CMD_NOK;
-                iv->sendAlarmLogRequest(force);
-
-                // Fetch limit
-                if (((millis() - iv->SystemConfigPara()->getLastUpdateRequest() > HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL)
-                        && (millis() - iv->SystemConfigPara()->getLastUpdateCommand() > HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION))) {
-                    ESP_LOGI(TAG, "Request SystemConfigPara");
-                    iv->sendSystemConfigParaRequest();
-                }
-
-                // Fetch grid profile
-                if (iv->Statistics()->getLastUpdate() > 0 && (iv->GridProfile()->getLastUpdate() == 0 || !iv->GridProfile()->containsValidData())) {
-                    iv->sendGridOnProFileParaRequest();
-                }
-
-                // Fetch dev info (but first fetch stats)
-                if (iv->Statistics()->getLastUpdate() > 0) {
-                    const bool invalidDevInfo = !iv->DevInfo()->containsValidData()
-                        && iv->DevInfo()->getLastUpdateAll() > 0
-                        && iv->DevInfo()->getLastUpdateSimple() > 0;
-
-                    if (invalidDevInfo) {
-                        ESP_LOGW(TAG, "DevInfo: No Valid Data");
-                    }
-
-                    if ((iv->DevInfo()->getLastUpdateAll() == 0)
-                        || (iv->DevInfo()->getLastUpdateSimple() == 0)
-                        || invalidDevInfo) {
-                        ESP_LOGI(TAG, "Request device info");
-                        iv->sendDevInfoRequest();
-                    }
-                }
-            }
+std::shared_ptr<InverterAbstract> HoymilesClass::getNextInverterAdaptive(const HoymilesRadio* radio)
+{
+    const uint32_t now = millis();
 
-            // Set limit if required
-            if (iv->SystemConfigPara()->getLastLimitCommandSuccess() == CMD_NOK) {
-                ESP_LOGI(TAG, "Resend ActivePowerControl");
-                iv->resendActivePowerControlRequest();
-            }
+    std::shared_ptr<InverterAbstract> next = nullptr;
+    uint32_t nextWeight = 0;
 
-            // Set power status if required
-            if (iv->PowerCommand()->getLastPowerCommandSuccess() == CMD_NOK) {
-                ESP_LOGI(TAG, "Resend PowerCommand");
-                iv->resendPowerControlRequest();
-            }
+    for (auto& iv : _inverters) {
+        if (iv->getRadio() != radio) {
+            continue;
+        }
+
+        const uint32_t elapsed = now - iv->PollState.LastPoll;
 
-            ESP_LOGI(TAG, "Queue size - NRF: %" PRIu32 " CMT: %" PRIu32 "", _radioNrf->getQueueSize(), _radioCmt->getQueueSize());
-            _lastPoll = millis();
+        // Failed commands are resent with the next poll interval, regardless of the backoff
+        const uint8_t backoff = hasFailedCommand(iv.get()) ? 0 : iv->PollState.Backoff;
+
+        // Wait at least 2^Backoff poll intervals
+        if (iv->PollState.LastPoll > 0 && elapsed < ((_pollInterval * 1000) << backoff)) {
+            continue;
         }
 
-        if (++inverterPos >= getNumInverters()) {
-            inverterPos = 0;
+        // The inverter which waited longest in relation to its backoff comes first
+        const uint32_t weight = elapsed >> backoff;
+        if (next == nullptr || weight > nextWeight) {
+            next = iv;
+            nextWeight = weight;
         }
     }
 
-    // Perform housekeeping of all inverters on day change
-    const int8_t currentWeekDay = Utils::getWeekDay();
-    static int8_t lastWeekDay = -1;
-    if (lastWeekDay == -1) {
-        lastWeekDay = currentWeekDay;
+    return next;
+}
+
+void HoymilesClass::updateBackoff(InverterAbstract* iv)
+{
+    auto& state = iv->PollState;
+    const float power = iv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC);
+    const float delta = std::abs(power - state.LastPower);
+
+    if (hasFailedCommand(iv)) {
+        // Pending commands have to be resent as soon as possible
+        state.Backoff = 0;
+    } else if (!iv->isReachable()) {
+        state.Backoff = std::min<uint8_t>(state.Backoff + 1, HOY_ADAPTIVE_POLL_MAX_BACKOFF);
+    } else if (delta <= std::max(HOY_ADAPTIVE_POLL_POWER_DELTA, state.LastPower * HOY_ADAPTIVE_POLL_POWER_DELTA_REL)) {
+        state.Backoff = std::min<uint8_t>(state.Backoff + 1, HOY_ADAPTIVE_POLL_MAX_BACKOFF_STABLE);
     } else {
-        if (currentWeekDay != lastWeekDay) {
+        state.Backoff = 0;
+    }
 
-            for (auto& inv : _inverters) {
-                inv->performDailyTask();
+    state.LastPower = power;
+}
+
+bool HoymilesClass::hasFailedCommand(InverterAbstract* iv)
+{
+    return iv->SystemConfigPara()->getLastLimitCommandSuccess() == CMD_NOK
+        || iv->PowerCommand()->getLastPowerCommandSuccess() == CMD_NOK;
+}
+
+bool HoymilesClass::pollInverter(InverterAbstract* iv)
+{
+    if (iv->getZeroValuesIfUnreachable() && !iv->isReachable()) {
+        iv->Statistics()->zeroRuntimeData();
+    }
+
+    if (!iv->getEnablePolling() && !iv->getEnableCommands()) {
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Fetch inverter: %s", iv->serialString().c_str());
+
+    if (!iv->isReachable()) {
+        iv->sendChangeChannelRequest();
+    }
+
+    if (Utils::getTimeAvailable()) {
+        // Fetch statistics
+        iv->sendStatsRequest();
+
+        // Fetch event log
+        const bool force = iv->EventLog()->getLastAlarmRequestSuccess() == CMD_NOK;
+        iv->sendAlarmLogRequest(force);
+
+        // Fetch limit
+        if (((millis() - iv->SystemConfigPara()->getLastUpdateRequest() > HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL)
+                && (millis() - iv->SystemConfigPara()->getLastUpdateCommand() > HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION))) {
+            ESP_LOGI(TAG, "Request SystemConfigPara");
+            iv->sendSystemConfigParaRequest();
+        }
+
+        // Fetch grid profile
+        if (iv->Statistics()->getLastUpdate() > 0 && (iv->GridProfile()->getLastUpdate() == 0 || !iv->GridProfile()->containsValidData())) {
+            iv->sendGridOnProFileParaRequest();
+        }
+
+        // Fetch dev info (but first fetch stats)
+        if (iv->Statistics()->getLastUpdate() > 0) {
+            const bool invalidDevInfo = !iv->DevInfo()->containsValidData()
+                && iv->DevInfo()->getLastUpdateAll() > 0
+                && iv->DevInfo()->getLastUpdateSimple() > 0;
+
+            if (invalidDevInfo) {
+                ESP_LOGW(TAG, "DevInfo: No Valid Data");
             }
 
-            lastWeekDay = currentWeekDay;
+            if ((iv->DevInfo()->getLastUpdateAll() == 0)
+                || (iv->DevInfo()->getLastUpdateSimple() == 0)
+                || invalidDevInfo) {
+                ESP_LOGI(TAG, "Request device info");
+                iv->sendDevInfoRequest();
+            }
         }
     }
+
+    // Set limit if required
+    if (iv->SystemConfigPara()->getLastLimitCommandSuccess() == CMD_NOK) {
+        ESP_LOGI(TAG, "Resend ActivePowerControl");
+        iv->resendActivePowerControlRequest();
+    }
+
+    // Set power status if required
+    if (iv->PowerCommand()->getLastPowerCommandSuccess() == CMD_NOK) {
+        ESP_LOGI(TAG, "Resend PowerCommand");
+        iv->resendPowerControlRequest();
+    }
+
+    ESP_LOGI(TAG, "Queue size - NRF: %" PRIu32 " CMT: %" PRIu32 "", _radioNrf->getQueueSize(), _radioCmt->getQueueSize());
+
+    return true;
 }
 
 std::shared_ptr<InverterAbstract> HoymilesClass::addInverter(const char* name, const uint64_t serial)
@@ -182,7 +291,9 @@ std::shared_ptr<InverterAbstract> HoymilesClass::addInverter(const char* name, c
     if (i) {
         i->setName(name);
         i->init();
+        i->setUpdateCallback([this, serial]() { notifyInverterUpdate(serial); });
         _inverters.push_back(std::move(i));
+        notifyInverterUpdate(serial);
         return _inverters.back();
     }
 
@@ -233,9 +344,12 @@ void HoymilesClass::removeInverterBySerial(const uint64_t serial)
 {
     for (uint8_t i = 0; i < _inverters.size(); i++) {
         if (_inverters[i]->serial() == serial) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            _inverters[i]->getRadio()->removeCommands(_inverters[i].get());
-            _inverters.erase(_inverters.begin() + i);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _inverters[i]->getRadio()->removeCommands(_inverters[i].get());
+                _inverters.erase(_inverters.begin() + i);
+            }
+            notifyInverterUpdate(serial);
             return;
         }
     }
@@ -261,6 +375,18 @@ bool HoymilesClass::isAllRadioIdle() const
     return _radioNrf.get()->isIdle() && _radioCmt.get()->isIdle();
 }
 
+void HoymilesClass::registerInverterUpdateCallback(const std::function<void(const uint64_t serial)>& callback)
+{
+    _inverterUpdateCallbacks.push_back(callback);
+}
+
+void HoymilesClass::notifyInverterUpdate(const uint64_t serial) const
+{
+    for (auto& callback : _inverterUpdateCallbacks) {
+        callback(serial);
+    }
+}
+
 uint32_t HoymilesClass::PollInterval() const
 {
     return _pollInterval;
@@ -270,3 +396,13 @@ void HoymilesClass::setPollInterval(const uint32_t interval)
 {
     _pollInterval = interval;
 }
+
+bool HoymilesClass::getAdaptivePolling() const
+{
+    return _adaptivePolling;
+}
+
+void HoymilesClass::setAdaptivePolling(const bool enabled)
+{
+    _adaptivePolling = enabled;
+}
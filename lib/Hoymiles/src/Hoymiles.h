@@ -1,23 +1,41 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
-#include "HoymilesRadio_CMT.h"
-#include "HoymilesRadio_NRF.h"
 #include "inverters/InverterAbstract.h"
 #include "types.h"
-#include <Print.h>
-#include <SPI.h>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
+#ifdef HOY_NATIVE
+// Host builds replace both RF modules by a radio which replays recorded fragments
+#include "HoymilesRadio_Sim.h"
+using HoymilesRadio_NRF = HoymilesRadio_Sim;
+using HoymilesRadio_CMT = HoymilesRadio_Sim;
+#else
+#include "HoymilesRadio_CMT.h"
+#include "HoymilesRadio_NRF.h"
+#include <Print.h>
+#include <SPI.h>
+#endif
+
 #define HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL (2 * 60 * 1000) // 2 minutes
 #define HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION (4 * 60 * 1000) // at least 4 minutes between sending limit command and read request. Otherwise eventlog entry
+#define HOY_RADIO_POLL_BUDGET 8 // no new inverter is polled while more commands are queued for the radio
+
+#define HOY_ADAPTIVE_POLL_MAX_BACKOFF 4 // unreachable inverters are polled at least every 2^4 poll intervals
+#define HOY_ADAPTIVE_POLL_MAX_BACKOFF_STABLE 2 // inverters with a constant output are polled at least every 2^2 poll intervals
+#define HOY_ADAPTIVE_POLL_POWER_DELTA 5.0f // W, smaller changes of the AC power are considered as constant output
+#define HOY_ADAPTIVE_POLL_POWER_DELTA_REL 0.02f // Relative change of the AC power considered as constant output
 
 class HoymilesClass {
 public:
     void init();
+#ifndef HOY_NATIVE
     void initNRF(SPIClass* initialisedSpiBus, const uint8_t pinCE, const uint8_t pinIRQ);
     void initCMT(const int8_t pin_sdio, const int8_t pin_clk, const int8_t pin_cs, const int8_t pin_fcs, const int8_t pin_gpio2, const int8_t pin_gpio3);
+#endif
     void loop();
 
     std::shared_ptr<InverterAbstract> addInverter(const char* name, const uint64_t serial);
@@ -33,17 +51,48 @@ public:
     uint32_t PollInterval() const;
     void setPollInterval(const uint32_t interval);
 
+    // Poll unreachable inverters and inverters with a constant output less often
+    // and use the free poll intervals for inverters with a changing output
+    bool getAdaptivePolling() const;
+    void setAdaptivePolling(const bool enabled);
+
     bool isAllRadioIdle() const;
 
+    // Called with the serial of an inverter every time its statistics, reachability or polling
+    // state changed and when it is added or removed. Runs in the context of the caller.
+    void registerInverterUpdateCallback(const std::function<void(const uint64_t serial)>& callback);
+
 private:
+    // Round robin state of one radio
+    struct RadioSchedule_t {
+        size_t inverterPos = 0;
+        uint32_t lastPoll = 0;
+    };
+
+    void scheduleRadio(RadioSchedule_t& schedule, HoymilesRadio* radio);
+    std::shared_ptr<InverterAbstract> getNextInverter(RadioSchedule_t& schedule, const HoymilesRadio* radio);
+    std::shared_ptr<InverterAbstract> getNextInverterAdaptive(const HoymilesRadio* radio);
+    static void updateBackoff(InverterAbstract* iv);
+    // A failed limit or power command has to be resent
+    static bool hasFailedCommand(InverterAbstract* iv);
+    // Enqueues all requests required for the inverter. Returns false if polling and commands are disabled
+    bool pollInverter(InverterAbstract* iv);
+
+    void notifyInverterUpdate(const uint64_t serial) const;
+
     std::vector<std::shared_ptr<InverterAbstract>> _inverters;
     std::unique_ptr<HoymilesRadio_NRF> _radioNrf;
     std::unique_ptr<HoymilesRadio_CMT> _radioCmt;
 
+    std::vector<std::function<void(const uint64_t serial)>> _inverterUpdateCallbacks;
+
     std::mutex _mutex;
 
+    RadioSchedule_t _scheduleNrf;
+    RadioSchedule_t _scheduleCmt;
+
     uint32_t _pollInterval = 0;
-    uint32_t _lastPoll = 0;
+    bool _adaptivePolling = false;
 };
 
 extern HoymilesClass Hoymiles;
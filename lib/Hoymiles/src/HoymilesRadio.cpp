@@ -66,6 +66,7 @@ void HoymilesRadio::handleReceivedPackage()
             uint8_t verifyResult = inv->verifyAllFragments(*cmd);
             if (verifyResult == FRAGMENT_ALL_MISSING_RESEND) {
                 ESP_LOGW(TAG, "Nothing received, resend whole request");
+                _exchangeRetransmits++;
                 sendLastPacketAgain();
 
             } else if (verifyResult == FRAGMENT_ALL_MISSING_TIMEOUT) {
@@ -74,6 +75,7 @@ void HoymilesRadio::handleReceivedPackage()
                 if (inv->RadioStats.TxRequestData > 0) {
                     inv->RadioStats.RxFailNoAnswer++;
                 }
+                updateCommandStats(*cmd, *inv, false);
 
                 _commandQueue.pop();
                 _busyFlag = false;
@@ -84,6 +86,7 @@ void HoymilesRadio::handleReceivedPackage()
                 if (inv->RadioStats.TxRequestData > 0) {
                     inv->RadioStats.RxFailPartialAnswer++;
                 }
+                updateCommandStats(*cmd, *inv, false);
 
                 _commandQueue.pop();
                 _busyFlag = false;
@@ -94,6 +97,7 @@ void HoymilesRadio::handleReceivedPackage()
                 if (inv->RadioStats.TxRequestData > 0) {
                     inv->RadioStats.RxFailCorruptData++;
                 }
+                updateCommandStats(*cmd, *inv, false);
 
                 _commandQueue.pop();
                 _busyFlag = false;
@@ -103,6 +107,7 @@ void HoymilesRadio::handleReceivedPackage()
                 ESP_LOGI(TAG, "Request retransmit: %" PRIu8 "", verifyResult);
                 // Statistics: Count TX Re-Request Fragment
                 inv->RadioStats.TxReRequestFragment++;
+                _exchangeRetransmits++;
 
                 sendRetransmitPacket(verifyResult);
 
@@ -113,6 +118,7 @@ void HoymilesRadio::handleReceivedPackage()
                 if (inv->RadioStats.TxRequestData > 0) {
                     inv->RadioStats.RxSuccess++;
                 }
+                updateCommandStats(*cmd, *inv, true);
 
                 _commandQueue.pop();
                 _busyFlag = false;
@@ -134,6 +140,9 @@ void HoymilesRadio::handleReceivedPackage()
                 inv->clearRxFragmentBuffer();
                 // Statistics: TX Requests
                 inv->RadioStats.TxRequestData++;
+                updateQueueWaitStats(*cmd);
+                _exchangeStart = millis();
+                _exchangeRetransmits = 0;
 
                 sendEsbPacket(*cmd);
             } else {
@@ -159,6 +168,39 @@ uint8_t HoymilesRadio::countSimilarCommands(std::shared_ptr<CommandAbstract> cmd
     return _commandQueue.countSimilarCommands(cmd);
 }
 
+HoymilesRadio::QueueWaitStats_t HoymilesRadio::getQueueWaitStats(const CommandPriority priority) const
+{
+    return _queueWaitStats[static_cast<uint8_t>(priority)];
+}
+
+const HoymilesRadio::CommandStats_t& HoymilesRadio::getCommandStats(const CommandType type) const
+{
+    return _commandStats[static_cast<uint8_t>(type)];
+}
+
+void HoymilesRadio::updateQueueWaitStats(const CommandAbstract& cmd)
+{
+    auto& stats = _queueWaitStats[static_cast<uint8_t>(cmd.getPriority())];
+    const uint32_t wait = millis() - cmd.getQueueTime();
+
+    stats.Count++;
+    stats.TotalWait += wait;
+    stats.MaxWait = std::max(stats.MaxWait, wait);
+
+    _commandStats[static_cast<uint8_t>(cmd.getCommandType())].QueueWait.add(wait);
+}
+
+void HoymilesRadio::updateCommandStats(const CommandAbstract& cmd, const InverterAbstract& inv, const bool success)
+{
+    auto& stats = _commandStats[static_cast<uint8_t>(cmd.getCommandType())];
+
+    stats.Exchange.add(millis() - _exchangeStart);
+    stats.Retransmits.add(_exchangeRetransmits);
+    if (success) {
+        stats.Rssi.add(inv.getLastRssi());
+    }
+}
+
 bool HoymilesRadio::isIdle() const
 {
     return !_busyFlag;
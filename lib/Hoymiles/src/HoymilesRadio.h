@@ -2,11 +2,16 @@
 #pragma once
 
 #include "Arduino.h"
+#include "Histogram.h"
 #include "commands/CommandAbstract.h"
 #include "queue/CommandQueue.h"
 #include "types.h"
+#include <SpscQueue.h>
 #include <TimeoutHelper.h>
 
+// number of fragments hold in the receive buffer of the radios
+#define FRAGMENT_BUFFER_SIZE 32
+
 #ifdef HOY_DEBUG_QUEUE
 #include <esp_log.h>
 
@@ -20,6 +25,31 @@ static const char* TAG = "hoymiles";
 
 class HoymilesRadio {
 public:
+    // Time between adding a command to the queue and its first transmission
+    struct QueueWaitStats_t {
+        uint32_t Count;
+        uint32_t MaxWait; // ms
+        uint64_t TotalWait; // ms
+    };
+
+    // 8 ms ... 16.4 s
+    typedef Histogram<LogBuckets<8>, 13> LatencyHistogram_t;
+    // 0 ... 8 retransmits, one bucket each, so commands without retransmit are counted separately
+    typedef Histogram<LinearBuckets<0, 1>, 10> RetransmitHistogram_t;
+    // -90 dBm ... -30 dBm
+    typedef Histogram<LinearBuckets<-90, 10>, 8> RssiHistogram_t;
+
+    struct CommandStats_t {
+        // Time between adding the command to the queue and its first transmission (ms)
+        LatencyHistogram_t QueueWait;
+        // Time between the first transmission and the completion of the command (ms)
+        LatencyHistogram_t Exchange;
+        // Resent requests and re-requested fragments
+        RetransmitHistogram_t Retransmits;
+        // RSSI of successful commands (dBm)
+        RssiHistogram_t Rssi;
+    };
+
     serial_u DtuSerial() const;
     virtual void setDtuSerial(const uint64_t serial);
 
@@ -31,6 +61,9 @@ public:
     void removeCommands(InverterAbstract* inv);
     uint8_t countSimilarCommands(std::shared_ptr<CommandAbstract> cmd);
 
+    QueueWaitStats_t getQueueWaitStats(const CommandPriority priority) const;
+    const CommandStats_t& getCommandStats(const CommandType type) const;
+
     void enqueCommand(std::shared_ptr<CommandAbstract> cmd)
     {
         DEBUG_PRINT("Queue size before: %ld", _commandQueue.size());
@@ -90,4 +123,15 @@ protected:
     bool _busyFlag = false;
 
     TimeoutHelper _rxTimeout;
+
+private:
+    void updateQueueWaitStats(const CommandAbstract& cmd);
+    void updateCommandStats(const CommandAbstract& cmd, const InverterAbstract& inv, const bool success);
+
+    QueueWaitStats_t _queueWaitStats[COMMAND_PRIORITY_COUNT] = {};
+    CommandStats_t _commandStats[COMMAND_TYPE_COUNT] = {};
+
+    // State of the command currently in flight
+    uint32_t _exchangeStart = 0;
+    uint8_t _exchangeRetransmits = 0;
 };
@@ -2,6 +2,7 @@
 /*
  * Copyright (C) 2023-2025 Thomas Basler and others
  */
+#ifndef HOY_NATIVE
 #include "HoymilesRadio_CMT.h"
 #include "Hoymiles.h"
 #include "Utils.h"
@@ -133,7 +134,7 @@ void HoymilesRadio_CMT::loop()
     if (_packetReceived) {
         ESP_LOGV(TAG, "Interrupt received");
         while (_radio->available()) {
-            if (_rxBuffer.size() > FRAGMENT_BUFFER_SIZE) {
+            if (_rxBuffer.full()) {
                 ESP_LOGE(TAG, "CMT2300A: Buffer full");
                 _radio->flush_rx();
                 continue;
@@ -154,8 +155,9 @@ void HoymilesRadio_CMT::loop()
 
     } else {
         // Perform package parsing only if no packages are received
-        if (!_rxBuffer.empty()) {
-            fragment_t f = _rxBuffer.back();
+        // The packet is removed from the buffer even if it is corrupted
+        if (const auto rx = _rxBuffer.pop()) {
+            const fragment_t& f = *rx;
             if (checkFragmentCrc(f)) {
 
                 const serial_u dtuId = convertSerialToRadioId(_dtuSerial);
@@ -180,9 +182,6 @@ void HoymilesRadio_CMT::loop()
             } else {
                 ESP_LOGW(TAG, "Frame kaputt"); // ;-)
             }
-
-            // Remove paket from buffer even it was corrupted
-            _rxBuffer.pop();
         }
     }
 
@@ -287,3 +286,5 @@ void HoymilesRadio_CMT::sendEsbPacket(CommandAbstract& cmd)
     _busyFlag = true;
     _rxTimeout.set(cmd.getTimeout());
 }
+
+#endif
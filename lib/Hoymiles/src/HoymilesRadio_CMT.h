@@ -7,23 +7,12 @@
 #include <Arduino.h>
 #include <cmt2300wrapper.h>
 #include <memory>
-#include <queue>
 #include <vector>
 
-// number of fragments hold in buffer
-#define FRAGMENT_BUFFER_SIZE 30
-
 #ifndef HOYMILES_CMT_WORK_FREQ
 #define HOYMILES_CMT_WORK_FREQ 865000000
 #endif
 
-enum CountryModeId_t {
-    MODE_EU,
-    MODE_US,
-    MODE_BR,
-    CountryModeId_Max
-};
-
 struct CountryFrequencyDefinition_t {
     FrequencyBand_t Band;
     uint32_t Freq_Min;
@@ -80,7 +69,7 @@ private:
     bool _gpio2_configured = false;
     bool _gpio3_configured = false;
 
-    std::queue<fragment_t> _rxBuffer;
+    SpscQueue<fragment_t, FRAGMENT_BUFFER_SIZE> _rxBuffer;
     TimeoutHelper _txTimeout;
 
     uint32_t _inverterTargetFrequency = HOYMILES_CMT_WORK_FREQ;
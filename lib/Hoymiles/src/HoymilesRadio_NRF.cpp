@@ -2,6 +2,7 @@
 /*
  * Copyright (C) 2022-2025 Thomas Basler and others
  */
+#ifndef HOY_NATIVE
 #include "HoymilesRadio_NRF.h"
 #include "Hoymiles.h"
 #include "Utils.h"
@@ -55,7 +56,7 @@ void HoymilesRadio_NRF::loop()
     if (_packetReceived) {
         ESP_LOGV(TAG, "Interrupt received");
         while (_radio->available()) {
-            if (_rxBuffer.size() > FRAGMENT_BUFFER_SIZE) {
+            if (_rxBuffer.full()) {
                 ESP_LOGE(TAG, "NRF: Buffer full");
                 _radio->flush_rx();
                 continue;
@@ -73,8 +74,9 @@ void HoymilesRadio_NRF::loop()
 
     } else {
         // Perform package parsing only if no packages are received
-        if (!_rxBuffer.empty()) {
-            fragment_t f = _rxBuffer.back();
+        // The packet is removed from the buffer even if it is corrupted
+        if (const auto rx = _rxBuffer.pop()) {
+            const fragment_t& f = *rx;
             if (checkFragmentCrc(f)) {
                 std::shared_ptr<InverterAbstract> inv = Hoymiles.getInverterByFragment(f);
 
@@ -91,9 +93,6 @@ void HoymilesRadio_NRF::loop()
             } else {
                 ESP_LOGW(TAG, "Frame kaputt");
             }
-
-            // Remove paket from buffer even it was corrupted
-            _rxBuffer.pop();
         }
     }
 
@@ -197,3 +196,5 @@ void HoymilesRadio_NRF::sendEsbPacket(CommandAbstract& cmd)
     _busyFlag = true;
     _rxTimeout.set(cmd.getTimeout());
 }
+
+#endif
@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#ifdef HOY_NATIVE
+#include "HoymilesRadio_Sim.h"
+#include "Hoymiles.h"
+#include "Utils.h"
+#include "crc.h"
+#include <cstdlib>
+#include <cstring>
+#include <esp_log.h>
+#include <sstream>
+#include <string>
+
+#undef TAG
+static const char* TAG = "hoymiles";
+
+// Same channel raster as the CMT2300A uses (FH_OFFSET * CMT2300A_ONE_STEP_SIZE)
+#define SIM_CHANNEL_WIDTH 250000
+#define SIM_BASE_FREQ_860 860000000
+#define SIM_BASE_FREQ_900 900000000
+
+void HoymilesRadio_Sim::init()
+{
+    _dtuSerial.u64 = 0;
+    _isInitialized = true;
+}
+
+void HoymilesRadio_Sim::loop()
+{
+    if (!_isInitialized) {
+        return;
+    }
+
+    while (const auto rx = _rxBuffer.pop()) {
+        const fragment_t& f = *rx;
+
+        if (checkFragmentCrc(f)) {
+            std::shared_ptr<InverterAbstract> inv = Hoymiles.getInverterByFragment(f);
+
+            if (nullptr != inv) {
+                ESP_LOGD(TAG, "RX Sim --> %s | %" PRId8 " dBm",
+                    Utils::dumpArray(f.fragment, f.len).c_str(), f.rssi);
+
+                inv->addRxFragment(f.fragment, f.len, f.rssi);
+            } else {
+                ESP_LOGE(TAG, "Inverter Not found!");
+            }
+
+        } else {
+            ESP_LOGW(TAG, "Frame kaputt");
+        }
+    }
+
+    handleReceivedPackage();
+}
+
+size_t HoymilesRadio_Sim::loadRecording(std::istream& stream)
+{
+    uint8_t request[MAX_RF_PAYLOAD_SIZE] = {};
+    bool hasRequest = false;
+    size_t count = 0;
+
+    std::string line;
+    while (std::getline(stream, line)) {
+        const size_t arrow = line.find("-->");
+        if (arrow == std::string::npos) {
+            continue;
+        }
+
+        const bool isTx = line.find("TX ") < arrow;
+        const bool isRx = line.find("RX ") < arrow;
+        if (!isTx && !isRx) {
+            continue;
+        }
+
+        const size_t end = line.find('|', arrow);
+        std::istringstream hex(line.substr(arrow + 3, end == std::string::npos ? std::string::npos : end - arrow - 3));
+
+        uint8_t buf[MAX_RF_PAYLOAD_SIZE];
+        uint8_t len = 0;
+        std::string byte;
+        while (len < MAX_RF_PAYLOAD_SIZE && hex >> byte) {
+            buf[len++] = static_cast<uint8_t>(strtoul(byte.c_str(), nullptr, 16));
+        }
+
+        if (isTx) {
+            // Retransmit requests belong to the previous request
+            if (len > 10 && !(buf[0] == 0x15 && (buf[9] & 0x7f) != 0)) {
+                memcpy(request, buf, len);
+                hasRequest = true;
+            }
+        } else if (hasRequest && len > 10) {
+            addRecordedFragment(request, buf, len);
+            count++;
+        }
+    }
+
+    return count;
+}
+
+void HoymilesRadio_Sim::addRecordedFragment(const uint8_t request[], const uint8_t fragment[], const uint8_t len)
+{
+    fragment_t f = {};
+    f.len = std::min<uint8_t>(len, MAX_RF_PAYLOAD_SIZE);
+    memcpy(f.fragment, fragment, f.len);
+    f.rssi = -60;
+
+    // A recording usually contains several poll cycles. Keep the latest fragment per id.
+    auto& response = _responses[getResponseKey(request)];
+    for (auto& r : response) {
+        if (r.fragment[9] == f.fragment[9]) {
+            r = f;
+            return;
+        }
+    }
+    response.push_back(f);
+}
+
+void HoymilesRadio_Sim::clearRecording()
+{
+    _responses.clear();
+    _lastResponse = nullptr;
+}
+
+void HoymilesRadio_Sim::setFragmentDropInterval(const uint32_t interval)
+{
+    _dropInterval = interval;
+}
+
+uint32_t HoymilesRadio_Sim::getTxCount() const
+{
+    return _txCount;
+}
+
+uint32_t HoymilesRadio_Sim::getRxCount() const
+{
+    return _rxCount;
+}
+
+bool HoymilesRadio_Sim::isConnected() const
+{
+    return _isInitialized;
+}
+
+CountryModeId_t HoymilesRadio_Sim::getCountryMode() const
+{
+    return _countryMode;
+}
+
+void HoymilesRadio_Sim::setCountryMode(const CountryModeId_t mode)
+{
+    _countryMode = mode;
+}
+
+uint32_t HoymilesRadio_Sim::getInverterTargetFrequency() const
+{
+    return _inverterTargetFrequency;
+}
+
+void HoymilesRadio_Sim::setInverterTargetFrequency(const uint32_t frequency)
+{
+    _inverterTargetFrequency = frequency;
+}
+
+uint8_t HoymilesRadio_Sim::getChannelFromFrequency(const uint32_t frequency) const
+{
+    const uint32_t base = _countryMode == CountryModeId_t::MODE_EU ? SIM_BASE_FREQ_860 : SIM_BASE_FREQ_900;
+    if (frequency < base) {
+        return 0xFF; // ERROR
+    }
+    return (frequency - base) / SIM_CHANNEL_WIDTH;
+}
+
+uint16_t HoymilesRadio_Sim::getResponseKey(const uint8_t request[])
+{
+    // MultiDataCommands are distinguished by their data type
+    return (static_cast<uint16_t>(request[0]) << 8) | (request[0] == 0x15 ? request[10] : 0x00);
+}
+
+void HoymilesRadio_Sim::sendEsbPacket(CommandAbstract& cmd)
+{
+    cmd.incrementSendCount();
+
+    cmd.setRouterAddress(DtuSerial().u64);
+
+    const uint8_t* payload = cmd.getDataPayload();
+
+    ESP_LOGD(TAG, "TX %s Sim --> %s",
+        cmd.getCommandName().c_str(), cmd.dumpDataPayload().c_str());
+    _txCount++;
+
+    if (payload[0] == 0x15 && (payload[9] & 0x7f) != 0) {
+        // Re-request of a single fragment of the last response
+        if (_lastResponse != nullptr) {
+            for (const auto& f : *_lastResponse) {
+                if ((f.fragment[9] & 0x7f) == (payload[9] & 0x7f)) {
+                    queueFragment(f, cmd.getTargetAddress());
+                }
+            }
+        }
+    } else {
+        const auto it = _responses.find(getResponseKey(payload));
+        _lastResponse = it != _responses.end() ? &it->second : nullptr;
+
+        if (_lastResponse != nullptr) {
+            for (const auto& f : *_lastResponse) {
+                queueFragment(f, cmd.getTargetAddress());
+            }
+        }
+    }
+
+    _busyFlag = true;
+    // All answers are available immediately, no need to wait for the radio timeout
+    _rxTimeout.set(0);
+}
+
+void HoymilesRadio_Sim::queueFragment(const fragment_t& recorded, const uint64_t target)
+{
+    _rxCount++;
+    if (_dropInterval > 0 && (_rxCount % _dropInterval) == 0) {
+        return;
+    }
+
+    // Address the recorded fragment from the polled inverter to this dtu
+    fragment_t f = recorded;
+    serial_u s;
+    s.u64 = target;
+    f.fragment[1] = s.b[3];
+    f.fragment[2] = s.b[2];
+    f.fragment[3] = s.b[1];
+    f.fragment[4] = s.b[0];
+    f.fragment[5] = _dtuSerial.b[3];
+    f.fragment[6] = _dtuSerial.b[2];
+    f.fragment[7] = _dtuSerial.b[1];
+    f.fragment[8] = _dtuSerial.b[0];
+    f.fragment[f.len - 1] = crc8(f.fragment, f.len - 1);
+
+    if (!_rxBuffer.push(f)) {
+        ESP_LOGE(TAG, "Sim: Buffer full");
+    }
+}
+
+#endif
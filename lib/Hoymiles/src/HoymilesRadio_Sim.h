@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "HoymilesRadio.h"
+#include "commands/CommandAbstract.h"
+#include "types.h"
+#include <istream>
+#include <map>
+#include <vector>
+
+// Radio used for host (HOY_NATIVE) builds. Instead of talking to a RF module
+// every transmitted command is answered using a previously recorded fragment stream.
+class HoymilesRadio_Sim : public HoymilesRadio {
+public:
+    void init();
+    void loop();
+
+    // Reads a serial log captured with debug output enabled. Every "RX ... --> <hex>" line
+    // is stored as answer fragment of the last preceding "TX ... --> <hex>" request.
+    // Returns the amount of fragments loaded.
+    size_t loadRecording(std::istream& stream);
+    void addRecordedFragment(const uint8_t request[], const uint8_t fragment[], const uint8_t len);
+    void clearRecording();
+
+    // Drop every n-th transmitted fragment to exercise the retransmit path. 0 disables it.
+    void setFragmentDropInterval(const uint32_t interval);
+
+    uint32_t getTxCount() const;
+    uint32_t getRxCount() const;
+
+    bool isConnected() const;
+
+    // Counterparts of HoymilesRadio_CMT used by the HMS/HMT channel change requests
+    CountryModeId_t getCountryMode() const;
+    void setCountryMode(const CountryModeId_t mode);
+    uint32_t getInverterTargetFrequency() const;
+    void setInverterTargetFrequency(const uint32_t frequency);
+    uint8_t getChannelFromFrequency(const uint32_t frequency) const;
+
+private:
+    static uint16_t getResponseKey(const uint8_t request[]);
+
+    void sendEsbPacket(CommandAbstract& cmd);
+    void queueFragment(const fragment_t& recorded, const uint64_t target);
+
+    std::map<uint16_t, std::vector<fragment_t>> _responses;
+    const std::vector<fragment_t>* _lastResponse = nullptr;
+
+    SpscQueue<fragment_t, FRAGMENT_BUFFER_SIZE> _rxBuffer;
+
+    uint32_t _dropInterval = 0;
+    uint32_t _txCount = 0;
+    uint32_t _rxCount = 0;
+
+    CountryModeId_t _countryMode = CountryModeId_t::MODE_EU;
+    uint32_t _inverterTargetFrequency = 865000000;
+};
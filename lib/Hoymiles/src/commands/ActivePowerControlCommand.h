@@ -15,6 +15,7 @@ public:
     explicit ActivePowerControlCommand(InverterAbstract* inv, const uint64_t router_address = 0);
 
     virtual String getCommandName() const;
+    virtual CommandType getCommandType() const { return CommandType::ActivePowerControl; }
     virtual QueueInsertType getQueueInsertType() const { return QueueInsertType::RemoveOldest; }
     virtual bool areSameParameter(CommandAbstract* other);
 
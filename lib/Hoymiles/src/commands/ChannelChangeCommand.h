@@ -1,7 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
-#include "../HoymilesRadio_CMT.h"
+#include "../types.h"
 #include "CommandAbstract.h"
 
 class ChannelChangeCommand : public CommandAbstract {
@@ -9,6 +9,8 @@ public:
     explicit ChannelChangeCommand(InverterAbstract* inv, const uint64_t router_address = 0, const uint8_t channel = 0);
 
     virtual String getCommandName() const;
+    virtual CommandType getCommandType() const { return CommandType::ChannelChange; }
+    virtual CommandPriority getPriority() const { return CommandPriority::RealTime; }
 
     void setChannel(const uint8_t channel);
     uint8_t getChannel() const;
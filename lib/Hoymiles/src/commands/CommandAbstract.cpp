@@ -43,6 +43,7 @@ CommandAbstract::CommandAbstract(InverterAbstract* inv, const uint64_t router_ad
     setRouterAddress(router_address);
     setSendCount(0);
     setTimeout(0);
+    setQueueTime(0);
 }
 
 const uint8_t* CommandAbstract::getDataPayload()
@@ -108,6 +109,33 @@ uint8_t CommandAbstract::incrementSendCount()
     return _sendCount++;
 }
 
+void CommandAbstract::setQueueTime(const uint32_t time)
+{
+    _queueTime = time;
+}
+
+uint32_t CommandAbstract::getQueueTime() const
+{
+    return _queueTime;
+}
+
+const char* CommandAbstract::getCommandTypeName(const CommandType type)
+{
+    static const char* names[COMMAND_TYPE_COUNT] = {
+        "ActivePowerControl",
+        "AlarmData",
+        "ChannelChange",
+        "DevInfoAll",
+        "DevInfoSimple",
+        "GridOnProFilePara",
+        "PowerControl",
+        "RealTimeRunData",
+        "RequestFrame",
+        "SystemConfigPara",
+    };
+    return names[static_cast<uint8_t>(type)];
+}
+
 CommandAbstract* CommandAbstract::getRequestFrameCommand(const uint8_t frame_no)
 {
     return nullptr;
@@ -24,6 +24,34 @@ enum class QueueInsertType {
     ReplaceExistent,
 };
 
+// Commands of a higher priority (lower value) overtake queued commands of a lower priority
+enum class CommandPriority : uint8_t {
+    // Limit and power commands
+    Control = 0,
+
+    // Statistics and everything required to receive them
+    RealTime,
+
+    // Event log, system config, device info and grid profile
+    Config,
+};
+#define COMMAND_PRIORITY_COUNT 3
+
+// Used to collect statistics per command
+enum class CommandType : uint8_t {
+    ActivePowerControl = 0,
+    AlarmData,
+    ChannelChange,
+    DevInfoAll,
+    DevInfoSimple,
+    GridOnProFilePara,
+    PowerControl,
+    RealTimeRunData,
+    RequestFrame,
+    SystemConfigPara,
+};
+#define COMMAND_TYPE_COUNT 10
+
 class CommandAbstract {
 public:
     explicit CommandAbstract(InverterAbstract* inv, const uint64_t router_address = 0);
@@ -43,6 +71,8 @@ public:
     uint32_t getTimeout() const;
 
     virtual String getCommandName() const = 0;
+    virtual CommandType getCommandType() const = 0;
+    static const char* getCommandTypeName(const CommandType type);
 
     void setSendCount(const uint8_t count);
     uint8_t getSendCount() const;
@@ -63,11 +93,18 @@ public:
     virtual QueueInsertType getQueueInsertType() const { return QueueInsertType::RemoveNewest; }
     virtual bool areSameParameter(CommandAbstract* other);
 
+    virtual CommandPriority getPriority() const { return CommandPriority::Config; }
+
+    // Time when the command was added to the queue (millis)
+    void setQueueTime(const uint32_t time);
+    uint32_t getQueueTime() const;
+
 protected:
     uint8_t _payload[RF_LEN];
     uint8_t _payload_size;
     uint32_t _timeout;
     uint8_t _sendCount;
+    uint32_t _queueTime;
 
     uint64_t _targetAddress;
     uint64_t _routerAddress;
@@ -8,6 +8,8 @@ public:
     explicit RealTimeRunDataCommand(InverterAbstract* inv, const uint64_t router_address = 0, const time_t time = 0);
 
     virtual String getCommandName() const;
+    virtual CommandType getCommandType() const { return CommandType::RealTimeRunData; }
+    virtual CommandPriority getPriority() const { return CommandPriority::RealTime; }
 
     virtual bool handleResponse(const fragment_t fragment[], const uint8_t max_fragment_id);
     virtual void gotTimeout();
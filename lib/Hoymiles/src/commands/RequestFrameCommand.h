@@ -8,6 +8,7 @@ public:
     explicit RequestFrameCommand(InverterAbstract* inv, const uint64_t router_address = 0, uint8_t frame_no = 0);
 
     virtual String getCommandName() const;
+    virtual CommandType getCommandType() const { return CommandType::RequestFrame; }
 
     void setFrameNo(const uint8_t frame_no);
     uint8_t getFrameNo() const;
@@ -1,17 +1,61 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 /*
- * Copyright (C) 2022 Thomas Basler and others
+ * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "crc.h"
+#include <array>
+
+// The CRC8 and CRC16 (MODBUS) checksums are processed byte wise using lookup tables
+// which are generated at compile time. Define HOY_CRC_BITWISE to save the 768 bytes
+// of flash and calculate them bit by bit instead.
+
+static constexpr uint8_t crc8Byte(uint8_t crc)
+{
+    for (uint8_t b = 0; b < 8; b++) {
+        crc = (crc << 1) ^ ((crc & 0x80) ? CRC8_POLY : 0x00);
+    }
+    return crc;
+}
+
+static constexpr uint16_t crc16Byte(uint16_t crc)
+{
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x0001) ? ((crc >> 1) ^ CRC16_MODBUS_POLYNOM) : (crc >> 1);
+    }
+    return crc;
+}
+
+#ifndef HOY_CRC_BITWISE
+static constexpr std::array<uint8_t, 256> crc8Table = [] {
+    std::array<uint8_t, 256> table = {};
+    for (uint16_t i = 0; i < table.size(); i++) {
+        table[i] = crc8Byte(i);
+    }
+    return table;
+}();
+
+static constexpr std::array<uint16_t, 256> crc16Table = [] {
+    std::array<uint16_t, 256> table = {};
+    for (uint16_t i = 0; i < table.size(); i++) {
+        table[i] = crc16Byte(i);
+    }
+    return table;
+}();
+
+// Known entries of the polynomials to detect a broken table generation at compile time
+static_assert(crc8Table[0x01] == 0x01 && crc8Table[0x80] == 0x80 && crc8Table[0xff] == 0xff);
+static_assert(crc16Table[0x01] == 0xc0c1 && crc16Table[0x80] == 0xa001 && crc16Table[0xff] == 0x4040);
+#endif
 
 uint8_t crc8(const uint8_t buf[], const uint8_t len)
 {
     uint8_t crc = CRC8_INIT;
     for (uint8_t i = 0; i < len; i++) {
-        crc ^= buf[i];
-        for (uint8_t b = 0; b < 8; b++) {
-            crc = (crc << 1) ^ ((crc & 0x80) ? CRC8_POLY : 0x00);
-        }
+#ifdef HOY_CRC_BITWISE
+        crc = crc8Byte(crc ^ buf[i]);
+#else
+        crc = crc8Table[crc ^ buf[i]];
+#endif
     }
     return crc;
 }
@@ -19,16 +63,12 @@ uint8_t crc8(const uint8_t buf[], const uint8_t len)
 uint16_t crc16(const uint8_t buf[], const uint8_t len, const uint16_t start)
 {
     uint16_t crc = start;
-    uint8_t shift = 0;
-
     for (uint8_t i = 0; i < len; i++) {
-        crc = crc ^ buf[i];
-        for (uint8_t bit = 0; bit < 8; bit++) {
-            shift = (crc & 0x0001);
-            crc = crc >> 1;
-            if (shift != 0)
-                crc = crc ^ 0xA001;
-        }
+#ifdef HOY_CRC_BITWISE
+        crc = crc16Byte(crc ^ buf[i]);
+#else
+        crc = (crc >> 8) ^ crc16Table[(crc ^ buf[i]) & 0xff];
+#endif
     }
     return crc;
 }
@@ -47,4 +87,4 @@ uint16_t crc16nrf24(const uint8_t buf[], const uint16_t lenBits, const uint16_t
     }
 
     return crc;
-}
\ No newline at end of file
+}
@@ -4,7 +4,6 @@
  */
 #include "HMS_Abstract.h"
 #include "Hoymiles.h"
-#include "HoymilesRadio_CMT.h"
 #include "commands/ChannelChangeCommand.h"
 
 HMS_Abstract::HMS_Abstract(HoymilesRadio* radio, const uint64_t serial)
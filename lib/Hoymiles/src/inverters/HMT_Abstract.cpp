@@ -4,7 +4,6 @@
  */
 #include "HMT_Abstract.h"
 #include "Hoymiles.h"
-#include "HoymilesRadio_CMT.h"
 #include "commands/ChannelChangeCommand.h"
 #include "parser/AlarmLogParser.h"
 
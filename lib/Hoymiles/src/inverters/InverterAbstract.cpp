@@ -27,6 +27,8 @@ InverterAbstract::InverterAbstract(HoymilesRadio* radio, const uint64_t serial)
     _powerCommandParser.reset(new PowerCommandParser());
     _statisticsParser.reset(new StatisticsParser());
     _systemConfigParaParser.reset(new SystemConfigParaParser());
+
+    _statisticsParser->setUpdateCallback([this]() { notifyUpdate(); });
 }
 
 void InverterAbstract::init()
@@ -83,6 +85,8 @@ bool InverterAbstract::isReachable()
 void InverterAbstract::setEnablePolling(const bool enabled)
 {
     _enablePolling = enabled;
+    // Notify even if unchanged, the caller usually applies a changed configuration
+    notifyUpdate();
 }
 
 bool InverterAbstract::getEnablePolling() const
@@ -102,7 +106,11 @@ bool InverterAbstract::getEnableCommands() const
 
 void InverterAbstract::setReachableThreshold(const uint8_t threshold)
 {
+    if (_reachableThreshold == threshold) {
+        return;
+    }
     _reachableThreshold = threshold;
+    notifyUpdate();
 }
 
 uint8_t InverterAbstract::getReachableThreshold() const
@@ -185,6 +193,18 @@ SystemConfigParaParser* InverterAbstract::SystemConfigPara()
     return _systemConfigParaParser.get();
 }
 
+void InverterAbstract::setUpdateCallback(const std::function<void()>& callback)
+{
+    _updateCallback = callback;
+}
+
+void InverterAbstract::notifyUpdate() const
+{
+    if (_updateCallback) {
+        _updateCallback();
+    }
+}
+
 void InverterAbstract::clearRxFragmentBuffer()
 {
     memset(_rxFragmentBuffer, 0, MAX_RF_FRAGMENT_COUNT * sizeof(fragment_t));
@@ -12,6 +12,7 @@
 #include "types.h"
 #include <Arduino.h>
 #include <cstdint>
+#include <functional>
 #include <list>
 
 #define MAX_NAME_LENGTH 32
@@ -91,6 +92,21 @@ public:
         uint32_t RxFailCorruptData;
     } RadioStats = {};
 
+    // Maintained by the poll scheduler of HoymilesClass
+    struct {
+        // Time of the last poll (millis)
+        uint32_t LastPoll;
+
+        // Time between the last two polls in ms
+        uint32_t EffectiveInterval;
+
+        // AC power at the time of the last poll
+        float LastPower;
+
+        // Adaptive polling: Inverter is polled at most every 2^Backoff poll intervals
+        uint8_t Backoff;
+    } PollState = {};
+
     virtual bool sendStatsRequest() = 0;
     virtual bool sendAlarmLogRequest(const bool force = false) = 0;
     virtual bool sendDevInfoRequest() = 0;
@@ -115,6 +131,9 @@ public:
     StatisticsParser* Statistics();
     SystemConfigParaParser* SystemConfigPara();
 
+    // Called every time the statistics, the reachability or the polling state changed
+    void setUpdateCallback(const std::function<void()>& callback);
+
 protected:
     HoymilesRadio* _radio;
 
@@ -144,4 +163,7 @@ private:
     std::unique_ptr<PowerCommandParser> _powerCommandParser;
     std::unique_ptr<StatisticsParser> _statisticsParser;
     std::unique_ptr<SystemConfigParaParser> _systemConfigParaParser;
+
+    void notifyUpdate() const;
+    std::function<void()> _updateCallback;
 };
@@ -421,51 +421,66 @@ std::list<GridProfileSection_t> GridProfileParser::getProfile() const
 {
     std::list<GridProfileSection_t> l;
 
-    if (_gridProfileLength > 4) {
-        uint16_t pos = 4;
-        do {
-            const uint8_t section_id = _payloadGridProfile[pos];
-            const uint8_t section_version = _payloadGridProfile[pos + 1];
-            const int16_t section_start = getSectionStart(section_id, section_version);
-            const uint8_t section_size = getSectionSize(section_id, section_version);
-            pos += 2;
-
-            GridProfileSection_t section;
-            try {
-                section.SectionName = profileSection.at(section_id).data();
-            } catch (const std::out_of_range&) {
-                section.SectionName = "Unknown";
-                break;
-            }
-
-            if (section_start == -1) {
-                section.SectionName = "Unknown";
-                break;
-            }
-
-            for (uint8_t val_id = 0; val_id < section_size; val_id++) {
-                auto itemDefinition = itemDefinitions.at(_profileValues[section_start + val_id].ItemDefinition);
-
-                float value = static_cast<int16_t>((_payloadGridProfile[pos] << 8) | _payloadGridProfile[pos + 1]);
-                value /= itemDefinition.Divider;
-
-                GridProfileItem_t v;
-                v.Name = itemDefinition.Name.data();
-                v.Unit = itemDefinition.Unit.data();
-                v.Value = value;
-                section.items.push_back(v);
-
-                pos += 2;
-            }
-
-            l.push_back(section);
-
-        } while (pos < _gridProfileLength);
+    HOY_SEMAPHORE_TAKE();
+    uint16_t pos = GRID_PROFILE_SECTION_START;
+    GridProfileSection_t section;
+    while (parseSection(pos, section)) {
+        l.push_back(section);
     }
+    HOY_SEMAPHORE_GIVE();
 
     return l;
 }
 
+bool GridProfileParser::getSection(uint16_t& pos, GridProfileSection_t& section) const
+{
+    HOY_SEMAPHORE_TAKE();
+    const bool ret = parseSection(pos, section);
+    HOY_SEMAPHORE_GIVE();
+    return ret;
+}
+
+bool GridProfileParser::parseSection(uint16_t& pos, GridProfileSection_t& section) const
+{
+    if (pos + 2 > _gridProfileLength) {
+        return false;
+    }
+
+    const uint8_t section_id = _payloadGridProfile[pos];
+    const uint8_t section_version = _payloadGridProfile[pos + 1];
+    const int16_t section_start = getSectionStart(section_id, section_version);
+    const uint8_t section_size = getSectionSize(section_id, section_version);
+
+    try {
+        section.SectionName = profileSection.at(section_id).data();
+    } catch (const std::out_of_range&) {
+        return false;
+    }
+
+    if (section_start == -1 || pos + 2 + section_size * 2 > GRID_PROFILE_SIZE) {
+        return false;
+    }
+    pos += 2;
+
+    section.items.clear();
+    for (uint8_t val_id = 0; val_id < section_size; val_id++) {
+        auto itemDefinition = itemDefinitions.at(_profileValues[section_start + val_id].ItemDefinition);
+
+        float value = static_cast<int16_t>((_payloadGridProfile[pos] << 8) | _payloadGridProfile[pos + 1]);
+        value /= itemDefinition.Divider;
+
+        GridProfileItem_t v;
+        v.Name = itemDefinition.Name.data();
+        v.Unit = itemDefinition.Unit.data();
+        v.Value = value;
+        section.items.push_back(v);
+
+        pos += 2;
+    }
+
+    return true;
+}
+
 bool GridProfileParser::containsValidData() const
 {
     return _gridProfileLength > 6;
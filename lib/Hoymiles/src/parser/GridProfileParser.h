@@ -1,12 +1,17 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 #include "Parser.h"
+#include <array>
 #include <list>
+#include <vector>
 
 #define GRID_PROFILE_SIZE 141
 #define PROFILE_TYPE_COUNT 10
 #define SECTION_VALUE_COUNT 158
 
+// Byte position of the first section in the raw data
+#define GRID_PROFILE_SECTION_START 4
+
 typedef struct {
     uint8_t lIdx;
     uint8_t hIdx;
@@ -43,9 +48,15 @@ public:
 
     std::list<GridProfileSection_t> getProfile() const;
 
+    // Parses the section at pos and advances pos to the following one.
+    // Returns false if there is no further valid section.
+    bool getSection(uint16_t& pos, GridProfileSection_t& section) const;
+
     bool containsValidData() const;
 
 private:
+    bool parseSection(uint16_t& pos, GridProfileSection_t& section) const;
+
     static uint8_t getSectionSize(const uint8_t section_id, const uint8_t section_version);
     static int16_t getSectionStart(const uint8_t section_id, const uint8_t section_version);
 
@@ -8,15 +8,16 @@
 #undef TAG
 static const char* TAG = "hoymiles";
 
-static float calcTotalYieldTotal(StatisticsParser* iv, uint8_t arg0);
-static float calcTotalYieldDay(StatisticsParser* iv, uint8_t arg0);
-static float calcChUdc(StatisticsParser* iv, uint8_t arg0);
-static float calcTotalPowerDc(StatisticsParser* iv, uint8_t arg0);
-static float calcTotalEffiency(StatisticsParser* iv, uint8_t arg0);
-static float calcChIrradiation(StatisticsParser* iv, uint8_t arg0);
-static float calcTotalCurrentAc(StatisticsParser* iv, uint8_t arg0);
+static float calcTotalYieldTotal(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0);
+static float calcTotalYieldDay(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0);
+static float calcChUdc(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0);
+static float calcTotalPowerDc(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0);
+static float calcTotalEffiency(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0);
+static float calcChIrradiation(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0);
+static float calcTotalCurrentAc(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0);
 
-using func_t = float(StatisticsParser*, uint8_t);
+// values contains the fields decoded so far
+using func_t = float(StatisticsParser*, const std::vector<float>&, uint8_t);
 
 struct calcFunc_t {
     uint8_t funcId; // unique id
@@ -62,6 +63,7 @@ const FieldId_t dailyProductionFields[] = {
 StatisticsParser::StatisticsParser()
     : Parser()
 {
+    _assignmentIndex.fill(FIELD_INDEX_NONE);
     clearBuffer();
 }
 
@@ -70,12 +72,29 @@ void StatisticsParser::setByteAssignment(const byteAssign_t* byteAssignment, con
     _byteAssignment = byteAssignment;
     _byteAssignmentSize = size;
 
+    _assignmentIndex.fill(FIELD_INDEX_NONE);
+    _fieldOffsets.assign(_byteAssignmentSize, 0);
+    _decodedValues.assign(_byteAssignmentSize, 0);
+    _fieldValues[0].reset(new std::atomic<float>[_byteAssignmentSize]);
+    _fieldValues[1].reset(new std::atomic<float>[_byteAssignmentSize]);
+
     for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
+        const byteAssign_t& b = _byteAssignment[i];
+        if (b.type < CHANNEL_TYPE_COUNT && b.ch < CH_CNT && b.fieldId < FIELD_COUNT) {
+            uint8_t& index = _assignmentIndex[(b.type * CH_CNT + b.ch) * FIELD_COUNT + b.fieldId];
+            // Keep the first match like the previous linear search did
+            if (index == FIELD_INDEX_NONE) {
+                index = i;
+            }
+        }
+
         if (_byteAssignment[i].div == CMD_CALC) {
             continue;
         }
         _expectedByteCount = max<uint8_t>(_expectedByteCount, _byteAssignment[i].start + _byteAssignment[i].num);
     }
+
+    decodeFields();
 }
 
 uint8_t StatisticsParser::getExpectedByteCount()
@@ -103,8 +122,16 @@ void StatisticsParser::endAppendFragment()
 {
     Parser::endAppendFragment();
 
+    // Without correction the offsets are reset before decoding, so the frame is decoded once
     if (!_enableYieldDayCorrection) {
         resetYieldDayCorrection();
+    }
+
+    // Also applies offsets and string max powers set since the last decode
+    _decodePending = false;
+    decodeFields();
+
+    if (!_enableYieldDayCorrection) {
         return;
     }
 
@@ -121,79 +148,173 @@ void StatisticsParser::endAppendFragment()
             _lastYieldDay[static_cast<uint8_t>(c)] = getChannelFieldValue(TYPE_DC, c, FLD_YD);
         }
     }
+
+    // Applies a yield day offset set above, only decodes again after a yield day reset
+    decodePendingFields();
+}
+
+uint8_t StatisticsParser::getAssignmentIndex(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
+{
+    if (type >= CHANNEL_TYPE_COUNT || channel >= CH_CNT || fieldId >= FIELD_COUNT) {
+        return FIELD_INDEX_NONE;
+    }
+    return _assignmentIndex[(type * CH_CNT + channel) * FIELD_COUNT + fieldId];
 }
 
 const byteAssign_t* StatisticsParser::getAssignmentByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
 {
+    const uint8_t index = getAssignmentIndex(type, channel, fieldId);
+    if (index == FIELD_INDEX_NONE) {
+        return nullptr;
+    }
+    return &_byteAssignment[index];
+}
+
+void StatisticsParser::decodeFields()
+{
+    HOY_SEMAPHORE_TAKE();
+
+    // Static values first, the calculated values are based on them
     for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
-        if (_byteAssignment[i].type == type && _byteAssignment[i].ch == channel && _byteAssignment[i].fieldId == fieldId) {
-            return &_byteAssignment[i];
+        if (_byteAssignment[i].div != CMD_CALC) {
+            _decodedValues[i] = decodeField(i);
         }
     }
-    return nullptr;
+
+    for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
+        if (_byteAssignment[i].div == CMD_CALC) {
+            _decodedValues[i] = calcFunctions[_byteAssignment[i].start].func(this, _decodedValues, _byteAssignment[i].num);
+        }
+    }
+
+    // Still holding the semaphore, so a frame is completely published before the next one is decoded.
+    // Readers keep using the published buffer while the other one is written
+    const uint32_t sequence = _fieldValuesSequence.load(std::memory_order_relaxed);
+    _fieldValuesSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::atomic<float>* values = _fieldValues[(sequence / 2 + 1) % 2].get();
+    for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
+        values[i].store(_decodedValues[i], std::memory_order_relaxed);
+    }
+
+    _fieldValuesSequence.store(sequence + 2, std::memory_order_release);
+
+    HOY_SEMAPHORE_GIVE();
+
+    notifyUpdate();
 }
 
-fieldSettings_t* StatisticsParser::getSettingByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+float StatisticsParser::decodeField(const uint8_t index) const
 {
-    for (auto& i : _fieldSettings) {
-        if (i.type == type && i.ch == channel && i.fieldId == fieldId) {
-            return &i;
-        }
+    const byteAssign_t* pos = &_byteAssignment[index];
+
+    uint8_t ptr = pos->start;
+    const uint8_t end = ptr + pos->num;
+
+    uint32_t val = 0;
+    do {
+        val <<= 8;
+        val |= _payloadStatistic[ptr];
+    } while (++ptr != end);
+
+    float result;
+    if (pos->isSigned && pos->num == 2) {
+        result = static_cast<float>(static_cast<int16_t>(val));
+    } else if (pos->isSigned && pos->num == 4) {
+        result = static_cast<float>(static_cast<int32_t>(val));
+    } else {
+        result = static_cast<float>(val);
+    }
+
+    result /= static_cast<float>(pos->div);
+
+    if (_statisticLength > 0) {
+        result += _fieldOffsets[index];
     }
-    return nullptr;
+    return result;
 }
 
 float StatisticsParser::getChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
 {
-    const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
-    if (pos == nullptr) {
+    const uint8_t index = getAssignmentIndex(type, channel, fieldId);
+    if (index == FIELD_INDEX_NONE) {
         return 0;
     }
+    const uint32_t sequence = _fieldValuesSequence.load(std::memory_order_acquire);
+    return _fieldValues[(sequence / 2) % 2][index].load(std::memory_order_relaxed);
+}
 
-    uint8_t ptr = pos->start;
-    const uint8_t end = ptr + pos->num;
-    const uint16_t div = pos->div;
-
-    if (CMD_CALC != div) {
-        // Value is a static value
-        uint32_t val = 0;
-        HOY_SEMAPHORE_TAKE();
-        do {
-            val <<= 8;
-            val |= _payloadStatistic[ptr];
-        } while (++ptr != end);
-        HOY_SEMAPHORE_GIVE();
+uint32_t StatisticsParser::getFieldValues(std::vector<float>& values) const
+{
+    values.resize(_byteAssignmentSize);
 
-        float result;
-        if (pos->isSigned && pos->num == 2) {
-            result = static_cast<float>(static_cast<int16_t>(val));
-        } else if (pos->isSigned && pos->num == 4) {
-            result = static_cast<float>(static_cast<int32_t>(val));
-        } else {
-            result = static_cast<float>(val);
+    uint32_t sequence;
+    uint32_t current;
+    do {
+        sequence = _fieldValuesSequence.load(std::memory_order_acquire);
+        const std::atomic<float>* published = _fieldValues[(sequence / 2) % 2].get();
+        for (uint8_t i = 0; i < _byteAssignmentSize; i++) {
+            values[i] = published[i].load(std::memory_order_relaxed);
         }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        current = _fieldValuesSequence.load(std::memory_order_relaxed);
 
-        result /= static_cast<float>(div);
+        // The copied buffer is only written again once the following frame has been published
+    } while (current - (sequence & ~1U) > 2);
 
-        const fieldSettings_t* setting = getSettingByChannelField(type, channel, fieldId);
-        if (setting != nullptr && _statisticLength > 0) {
-            result += setting->offset;
-        }
-        return result;
-    } else {
-        // Value has to be calculated
-        return calcFunctions[pos->start].func(this, pos->num);
+    return sequence / 2;
+}
+
+float StatisticsParser::getChannelFieldValue(const std::vector<float>& values, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
+{
+    const uint8_t index = getAssignmentIndex(type, channel, fieldId);
+    if (index == FIELD_INDEX_NONE || index >= values.size()) {
+        return 0;
     }
+    return values[index];
+}
 
-    return 0;
+uint32_t StatisticsParser::getFieldValuesVersion() const
+{
+    return _fieldValuesSequence.load(std::memory_order_acquire) / 2;
+}
+
+void StatisticsParser::decodePendingFields()
+{
+    if (_decodePending.exchange(false)) {
+        decodeFields();
+    }
+}
+
+void StatisticsParser::setUpdateCallback(const std::function<void()>& callback)
+{
+    _updateCallback = callback;
+}
+
+void StatisticsParser::notifyUpdate() const
+{
+    if (_updateCallback) {
+        _updateCallback();
+    }
 }
 
 bool StatisticsParser::setChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, float value)
 {
-    const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
-    if (pos == nullptr) {
+    if (!writeField(type, channel, fieldId, value)) {
         return false;
     }
+    decodeFields();
+    return true;
+}
+
+bool StatisticsParser::writeField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, float value)
+{
+    const uint8_t index = getAssignmentIndex(type, channel, fieldId);
+    if (index == FIELD_INDEX_NONE) {
+        return false;
+    }
+    const byteAssign_t* pos = &_byteAssignment[index];
 
     uint8_t ptr = pos->start + pos->num - 1;
     const uint8_t end = pos->start;
@@ -203,10 +324,7 @@ bool StatisticsParser::setChannelFieldValue(const ChannelType_t type, const Chan
         return false;
     }
 
-    const fieldSettings_t* setting = getSettingByChannelField(type, channel, fieldId);
-    if (setting != nullptr) {
-        value -= setting->offset;
-    }
+    value -= _fieldOffsets[index];
     value *= static_cast<float>(div);
 
     uint32_t val = 0;
@@ -237,8 +355,7 @@ String StatisticsParser::getChannelFieldValueString(const ChannelType_t type, co
 
 bool StatisticsParser::hasChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
 {
-    const byteAssign_t* pos = getAssignmentByChannelField(type, channel, fieldId);
-    return pos != nullptr;
+    return getAssignmentIndex(type, channel, fieldId) != FIELD_INDEX_NONE;
 }
 
 const char* StatisticsParser::getChannelFieldUnit(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const
@@ -261,20 +378,21 @@ uint8_t StatisticsParser::getChannelFieldDigits(const ChannelType_t type, const
 
 float StatisticsParser::getChannelFieldOffset(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
 {
-    const fieldSettings_t* setting = getSettingByChannelField(type, channel, fieldId);
-    if (setting != nullptr) {
-        return setting->offset;
+    const uint8_t index = getAssignmentIndex(type, channel, fieldId);
+    if (index == FIELD_INDEX_NONE) {
+        return 0;
     }
-    return 0;
+    return _fieldOffsets[index];
 }
 
 void StatisticsParser::setChannelFieldOffset(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const float offset)
 {
-    fieldSettings_t* setting = getSettingByChannelField(type, channel, fieldId);
-    if (setting != nullptr) {
-        setting->offset = offset;
-    } else {
-        _fieldSettings.push_back({ type, channel, fieldId, offset });
+    const uint8_t index = getAssignmentIndex(type, channel, fieldId);
+    if (index != FIELD_INDEX_NONE && _fieldOffsets[index] != offset) {
+        HOY_SEMAPHORE_TAKE();
+        _fieldOffsets[index] = offset;
+        HOY_SEMAPHORE_GIVE();
+        _decodePending = true;
     }
 }
 
@@ -311,19 +429,27 @@ uint16_t StatisticsParser::getStringMaxPower(const uint8_t channel) const
 
 void StatisticsParser::setStringMaxPower(const uint8_t channel, const uint16_t power)
 {
-    if (channel < sizeof(_stringMaxPower) / sizeof(_stringMaxPower[0])) {
+    if (channel < sizeof(_stringMaxPower) / sizeof(_stringMaxPower[0]) && _stringMaxPower[channel] != power) {
+        HOY_SEMAPHORE_TAKE();
         _stringMaxPower[channel] = power;
+        HOY_SEMAPHORE_GIVE();
+        _decodePending = true;
     }
 }
 
 void StatisticsParser::resetRxFailureCount()
 {
+    if (_rxFailureCount == 0) {
+        return;
+    }
     _rxFailureCount = 0;
+    notifyUpdate();
 }
 
 void StatisticsParser::incrementRxFailureCount()
 {
     _rxFailureCount++;
+    notifyUpdate();
 }
 
 uint32_t StatisticsParser::getRxFailureCount() const
@@ -374,11 +500,12 @@ void StatisticsParser::zeroFields(const FieldId_t* fields)
         for (auto& c : getChannelsByType(t)) {
             for (uint8_t i = 0; i < (sizeof(runtimeFields) / sizeof(runtimeFields[0])); i++) {
                 if (hasChannelFieldValue(t, c, fields[i])) {
-                    setChannelFieldValue(t, c, fields[i], 0);
+                    writeField(t, c, fields[i], 0);
                 }
             }
         }
     }
+    decodeFields();
     setLastUpdateFromInternal(millis());
 }
 
@@ -391,49 +518,49 @@ void StatisticsParser::resetYieldDayCorrection()
     }
 }
 
-static float calcTotalYieldTotal(StatisticsParser* iv, uint8_t arg0)
+static float calcTotalYieldTotal(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0)
 {
     float yield = 0;
     for (auto& channel : iv->getChannelsByType(TYPE_DC)) {
-        yield += iv->getChannelFieldValue(TYPE_DC, channel, FLD_YT);
+        yield += iv->getChannelFieldValue(values, TYPE_DC, channel, FLD_YT);
     }
     return yield;
 }
 
-static float calcTotalYieldDay(StatisticsParser* iv, uint8_t arg0)
+static float calcTotalYieldDay(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0)
 {
     float yield = 0;
     for (auto& channel : iv->getChannelsByType(TYPE_DC)) {
-        yield += iv->getChannelFieldValue(TYPE_DC, channel, FLD_YD);
+        yield += iv->getChannelFieldValue(values, TYPE_DC, channel, FLD_YD);
     }
     return yield;
 }
 
 // arg0 = channel of source
-static float calcChUdc(StatisticsParser* iv, uint8_t arg0)
+static float calcChUdc(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0)
 {
-    return iv->getChannelFieldValue(TYPE_DC, static_cast<ChannelNum_t>(arg0), FLD_UDC);
+    return iv->getChannelFieldValue(values, TYPE_DC, static_cast<ChannelNum_t>(arg0), FLD_UDC);
 }
 
-static float calcTotalPowerDc(StatisticsParser* iv, uint8_t arg0)
+static float calcTotalPowerDc(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0)
 {
     float dcPower = 0;
     for (auto& channel : iv->getChannelsByType(TYPE_DC)) {
-        dcPower += iv->getChannelFieldValue(TYPE_DC, channel, FLD_PDC);
+        dcPower += iv->getChannelFieldValue(values, TYPE_DC, channel, FLD_PDC);
     }
     return dcPower;
 }
 
-static float calcTotalEffiency(StatisticsParser* iv, uint8_t arg0)
+static float calcTotalEffiency(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0)
 {
     float acPower = 0;
     for (auto& channel : iv->getChannelsByType(TYPE_AC)) {
-        acPower += iv->getChannelFieldValue(TYPE_AC, channel, FLD_PAC);
+        acPower += iv->getChannelFieldValue(values, TYPE_AC, channel, FLD_PAC);
     }
 
     float dcPower = 0;
     for (auto& channel : iv->getChannelsByType(TYPE_DC)) {
-        dcPower += iv->getChannelFieldValue(TYPE_DC, channel, FLD_PDC);
+        dcPower += iv->getChannelFieldValue(values, TYPE_DC, channel, FLD_PDC);
     }
 
     if (dcPower > 0) {
@@ -443,20 +570,20 @@ static float calcTotalEffiency(StatisticsParser* iv, uint8_t arg0)
 }
 
 // arg0 = channel
-static float calcChIrradiation(StatisticsParser* iv, uint8_t arg0)
+static float calcChIrradiation(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0)
 {
     if (nullptr != iv) {
         if (iv->getStringMaxPower(arg0) > 0)
-            return iv->getChannelFieldValue(TYPE_DC, static_cast<ChannelNum_t>(arg0), FLD_PDC) / iv->getStringMaxPower(arg0) * 100.0f;
+            return iv->getChannelFieldValue(values, TYPE_DC, static_cast<ChannelNum_t>(arg0), FLD_PDC) / iv->getStringMaxPower(arg0) * 100.0f;
     }
     return 0.0;
 }
 
-static float calcTotalCurrentAc(StatisticsParser* iv, uint8_t arg0)
+static float calcTotalCurrentAc(StatisticsParser* iv, const std::vector<float>& values, uint8_t arg0)
 {
     float acCurrent = 0;
-    acCurrent += iv->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_1);
-    acCurrent += iv->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_2);
-    acCurrent += iv->getChannelFieldValue(TYPE_AC, CH0, FLD_IAC_3);
+    acCurrent += iv->getChannelFieldValue(values, TYPE_AC, CH0, FLD_IAC_1);
+    acCurrent += iv->getChannelFieldValue(values, TYPE_AC, CH0, FLD_IAC_2);
+    acCurrent += iv->getChannelFieldValue(values, TYPE_AC, CH0, FLD_IAC_3);
     return acCurrent;
 }
@@ -1,8 +1,13 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 #include "Parser.h"
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <functional>
 #include <list>
+#include <memory>
+#include <vector>
 
 #define STATISTIC_PACKET_SIZE (7 * 16)
 
@@ -95,13 +100,6 @@ typedef struct {
     uint8_t digits; // number of valid digits after the decimal point
 } byteAssign_t;
 
-typedef struct {
-    ChannelType_t type;
-    ChannelNum_t ch; // channel 0 - 5
-    FieldId_t fieldId; // field id
-    float offset; // offset (positive/negative) to be applied on the fetched value
-} fieldSettings_t;
-
 class StatisticsParser : public Parser {
 public:
     StatisticsParser();
@@ -115,9 +113,17 @@ public:
     uint8_t getExpectedByteCount();
 
     const byteAssign_t* getAssignmentByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
-    fieldSettings_t* getSettingByChannelField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
 
+    // Returns the value decoded from the last received frame. Does not block.
+    // Several calls may return values of different frames, use getFieldValues() to read one frame.
     float getChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+
+    // Copies all values of one complete frame. Does not block, retries if two
+    // frames were decoded while copying. Returns the version of the copied values.
+    uint32_t getFieldValues(std::vector<float>& values) const;
+
+    // Returns the value of a field within values copied by getFieldValues()
+    float getChannelFieldValue(const std::vector<float>& values, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
     String getChannelFieldValueString(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
     bool hasChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
     const char* getChannelFieldUnit(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
@@ -127,12 +133,23 @@ public:
     bool setChannelFieldValue(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, float value);
 
     float getChannelFieldOffset(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+    // The offset and the string max power are applied by the next decodePendingFields()
     void setChannelFieldOffset(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const float offset);
 
     std::list<ChannelType_t> getChannelTypes() const;
     const char* getChannelTypeName(const ChannelType_t type) const;
     std::list<ChannelNum_t> getChannelsByType(const ChannelType_t type) const;
 
+    // Incremented every time the decoded field values change
+    uint32_t getFieldValuesVersion() const;
+
+    // Decodes the fields again if an offset or a string max power changed since the
+    // last decode. Called from the loop of the radios, so they are only decoded there.
+    void decodePendingFields();
+
+    // Called after the field values have been decoded again or the rx failure count changed
+    void setUpdateCallback(const std::function<void()>& callback);
+
     uint16_t getStringMaxPower(const uint8_t channel) const;
     void setStringMaxPower(const uint8_t channel, const uint16_t power);
 
@@ -155,16 +172,45 @@ public:
     void setYieldDayCorrection(const bool enabled);
 
 private:
+    static constexpr uint8_t FIELD_INDEX_NONE = 0xff;
+    static constexpr uint8_t CHANNEL_TYPE_COUNT = sizeof(channelsTypes) / sizeof(channelsTypes[0]);
+    static constexpr uint8_t FIELD_COUNT = sizeof(fields) / sizeof(fields[0]);
+
+    // Returns the position of the field in _byteAssignment or FIELD_INDEX_NONE
+    uint8_t getAssignmentIndex(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) const;
+
+    // Decodes all fields from the raw payload into _fieldValues
+    void decodeFields();
+    float decodeField(const uint8_t index) const;
+    bool writeField(const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, float value);
+
     void zeroFields(const FieldId_t* fields);
 
+    void notifyUpdate() const;
+
     uint8_t _payloadStatistic[STATISTIC_PACKET_SIZE] = {};
     uint8_t _statisticLength = 0;
-    uint16_t _stringMaxPower[CH_CNT];
+    uint16_t _stringMaxPower[CH_CNT] = {};
 
-    const byteAssign_t* _byteAssignment;
-    uint8_t _byteAssignmentSize;
+    const byteAssign_t* _byteAssignment = nullptr;
+    uint8_t _byteAssignmentSize = 0;
     uint8_t _expectedByteCount = 0;
-    std::list<fieldSettings_t> _fieldSettings;
+
+    // type x channel x field --> position in _byteAssignment
+    std::array<uint8_t, CHANNEL_TYPE_COUNT * CH_CNT * FIELD_COUNT> _assignmentIndex;
+    // offset (positive/negative) to be applied on the fetched value, one per _byteAssignment entry
+    std::vector<float> _fieldOffsets;
+    // values of the frame being decoded, only used by decodeFields()
+    std::vector<float> _decodedValues;
+    // decoded values, one per _byteAssignment entry. A frame is written into the
+    // buffer which is not published and published by incrementing the sequence.
+    std::unique_ptr<std::atomic<float>[]> _fieldValues[2];
+    // Odd while a frame is written into _fieldValues[(_fieldValuesSequence / 2 + 1) % 2],
+    // even when the frame in _fieldValues[(_fieldValuesSequence / 2) % 2] is complete
+    std::atomic<uint32_t> _fieldValuesSequence { 0 };
+    // Set by the setters of values used by decodeFields()
+    std::atomic<bool> _decodePending { false };
+    std::function<void()> _updateCallback;
 
     uint32_t _rxFailureCount = 0;
     uint32_t _lastUpdateFromInternal = 0;
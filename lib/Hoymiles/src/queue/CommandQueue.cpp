@@ -4,8 +4,57 @@
  */
 #include "CommandQueue.h"
 #include "../inverters/InverterAbstract.h"
+#include <Arduino.h>
 #include <algorithm>
 
+void CommandQueue::push(std::shared_ptr<CommandAbstract> cmd)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const uint32_t now = millis();
+    cmd->setQueueTime(now);
+
+    // A channel change only applies to the command directly after it. If it is the last
+    // queued command of this inverter, it is moved together with the new command.
+    std::shared_ptr<CommandAbstract> channelChange;
+    for (size_t i = _queue.size(); i > 0; i--) {
+        const auto& queued = _queue[i - 1];
+        if (queued->getTargetAddress() != cmd->getTargetAddress()) {
+            continue;
+        }
+        if (queued->getCommandType() == CommandType::ChannelChange && cmd->getCommandType() != CommandType::ChannelChange) {
+            if (i == 1) {
+                // Possibly in progress, so the new command has to follow right away
+                _queue.insert(_queue.begin() + 1, cmd);
+                return;
+            }
+            channelChange = queued;
+            _queue.erase(_queue.begin() + (i - 1));
+        }
+        break;
+    }
+
+    size_t pos = _queue.size();
+    while (pos > 1) {
+        const auto& prev = _queue[pos - 1];
+        if (prev->getPriority() <= cmd->getPriority()
+            || now - prev->getQueueTime() > HOY_QUEUE_STARVATION_TIMEOUT) {
+            break;
+        }
+        pos--;
+    }
+
+    // Never separate the channel change of another inverter from its command
+    if (pos > 0 && pos < _queue.size() && _queue[pos - 1]->getCommandType() == CommandType::ChannelChange) {
+        pos++;
+    }
+
+    _queue.insert(_queue.begin() + pos, cmd);
+    if (channelChange != nullptr) {
+        _queue.insert(_queue.begin() + pos, channelChange);
+    }
+}
+
 void CommandQueue::removeAllEntriesForInverter(InverterAbstract* inv)
 {
     std::lock_guard<std::mutex> lock(_mutex);
@@ -31,6 +80,8 @@ void CommandQueue::replaceEntries(std::shared_ptr<CommandAbstract> cmd)
 {
     std::lock_guard<std::mutex> lock(_mutex);
 
+    cmd->setQueueTime(millis());
+
     std::replace_if(_queue.begin() + 1, _queue.end(),
         [&](const auto& v) {
             return cmd.get()->getQueueInsertType() == QueueInsertType::ReplaceExistent
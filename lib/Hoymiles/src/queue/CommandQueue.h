@@ -5,10 +5,19 @@
 #include <ThreadSafeQueue.h>
 #include <memory>
 
+// ms, commands which waited longer are no longer overtaken by commands of a higher priority
+#define HOY_QUEUE_STARVATION_TIMEOUT 10000
+
 class InverterAbstract;
 
 class CommandQueue : public ThreadSafeQueue<std::shared_ptr<CommandAbstract>> {
 public:
+    // Inserts the command behind all commands of the same or a higher priority.
+    // The first entry is never overtaken because it is possibly in progress.
+    // A channel change is kept directly in front of the following command of its
+    // inverter and takes over the position of that command.
+    void push(std::shared_ptr<CommandAbstract> cmd);
+
     void removeAllEntriesForInverter(InverterAbstract* inv);
     void removeDuplicatedEntries(std::shared_ptr<CommandAbstract> cmd);
     void replaceEntries(std::shared_ptr<CommandAbstract> cmd);
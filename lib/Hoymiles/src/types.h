@@ -19,3 +19,10 @@ typedef struct {
     int8_t rssi;
     bool wasReceived;
 } fragment_t;
+
+enum CountryModeId_t {
+    MODE_EU,
+    MODE_US,
+    MODE_BR,
+    CountryModeId_Max
+};
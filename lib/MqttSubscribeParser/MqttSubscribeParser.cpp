@@ -3,42 +3,153 @@
  * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "MqttSubscribeParser.h"
+#include <cstring>
+
+// Returns the length of the topic level starting at level
+static size_t level_length(const char* level)
+{
+    const char* end = strchr(level, '/');
+    return end != nullptr ? end - level : strlen(level);
+}
+
+// Returns the start of the next topic level or nullptr after the last level
+static const char* next_level(const char* level)
+{
+    const char* end = strchr(level, '/');
+    return end != nullptr ? end + 1 : nullptr;
+}
 
 void MqttSubscribeParser::register_callback(const std::string& topic, uint8_t qos, const OnMessageCallback& cb)
 {
+    if (!is_valid_sub(topic)) {
+        return;
+    }
+
+    node_t* node = &_root;
+    for (const char* level = topic.c_str(); level != nullptr; level = next_level(level)) {
+        auto& child = node->children[std::string(level, level_length(level))];
+        if (!child) {
+            child = std::make_unique<node_t>();
+        }
+        node = child.get();
+    }
+
     cb_filter_t cbf;
     cbf.topic = topic;
     cbf.qos = qos;
     cbf.cb = cb;
-    _callbacks.push_back(cbf);
+    node->callbacks.push_back(cbf);
 }
 
 void MqttSubscribeParser::unregister_callback(const std::string& topic)
 {
-    for (auto it = _callbacks.begin(); it != _callbacks.end();) {
-        if ((*it).topic == topic) {
-            it = _callbacks.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    remove(_root, topic.c_str());
 }
 
 void MqttSubscribeParser::handle_message(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len)
 {
-    bool result = false;
-    for (const auto& cb : _callbacks) {
-        if (mosquitto_topic_matches_sub(cb.topic.c_str(), topic, &result) == MOSQ_ERR_SUCCESS) {
-            if (result) {
+    // Wildcards are not allowed in the topic of a message
+    if (topic == nullptr || topic[0] == 0 || strpbrk(topic, "+#") != nullptr) {
+        return;
+    }
+
+    match(_root, topic, true, properties, topic, payload, len);
+}
+
+std::vector<cb_filter_t> MqttSubscribeParser::get_callbacks()
+{
+    std::vector<cb_filter_t> callbacks;
+    collect(_root, callbacks);
+    return callbacks;
+}
+
+void MqttSubscribeParser::match(const node_t& node, const char* level, const bool first,
+    const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len)
+{
+    // "#" also matches the parent level, e.g. "a/#" matches "a"
+    auto multi = node.children.find("#");
+
+    if (level == nullptr) {
+        for (const auto& cb : node.callbacks) {
+            cb.cb(properties, topic, payload, len);
+        }
+        if (multi != node.children.end()) {
+            for (const auto& cb : multi->second->callbacks) {
+                cb.cb(properties, topic, payload, len);
+            }
+        }
+        return;
+    }
+
+    const size_t length = level_length(level);
+    const char* next = next_level(level);
+
+    // Wildcards in the first level do not match topics starting with "$"
+    if (!first || level[0] != '$') {
+        if (multi != node.children.end()) {
+            for (const auto& cb : multi->second->callbacks) {
                 cb.cb(properties, topic, payload, len);
             }
         }
+
+        auto single = node.children.find("+");
+        if (single != node.children.end()) {
+            match(*single->second, next, false, properties, topic, payload, len);
+        }
+    }
+
+    auto child = node.children.find(std::string_view(level, length));
+    if (child != node.children.end()) {
+        match(*child->second, next, false, properties, topic, payload, len);
     }
 }
 
-std::vector<cb_filter_t> MqttSubscribeParser::get_callbacks()
+// Removes all subscriptions of the remaining topic levels below node and prunes empty nodes.
+// Returns true if node became empty.
+bool MqttSubscribeParser::remove(node_t& node, const char* level)
 {
-    return _callbacks;
+    if (level == nullptr) {
+        node.callbacks.clear();
+    } else {
+        auto child = node.children.find(std::string_view(level, level_length(level)));
+        if (child != node.children.end() && remove(*child->second, next_level(level))) {
+            node.children.erase(child);
+        }
+    }
+
+    return node.callbacks.empty() && node.children.empty();
+}
+
+void MqttSubscribeParser::collect(const node_t& node, std::vector<cb_filter_t>& callbacks)
+{
+    callbacks.insert(callbacks.end(), node.callbacks.begin(), node.callbacks.end());
+    for (const auto& child : node.children) {
+        collect(*child.second, callbacks);
+    }
+}
+
+// "+" and "#" have to fill a whole level and "#" has to be the last level
+bool MqttSubscribeParser::is_valid_sub(const std::string& topic)
+{
+    if (topic.empty()) {
+        return false;
+    }
+
+    for (const char* level = topic.c_str(); level != nullptr; level = next_level(level)) {
+        const size_t length = level_length(level);
+        for (size_t i = 0; i < length; i++) {
+            if (level[i] == '+' || level[i] == '#') {
+                if (length != 1) {
+                    return false;
+                }
+                if (level[i] == '#' && next_level(level) != nullptr) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
 }
 
 /* Does a topic match a subscription? */
@@ -3,7 +3,11 @@
 
 #include <cstdint>
 #include <espMqttClient.h>
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 typedef std::function<void(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len)> OnMessageCallback;
@@ -14,20 +18,41 @@ struct cb_filter_t {
     OnMessageCallback cb;
 };
 
+// Dispatches received messages to the callbacks of all matching subscriptions.
+// Subscriptions are stored in a trie with one node per topic level, so the
+// cost of a lookup depends on the depth of the topic and not on the number
+// of subscriptions.
 class MqttSubscribeParser {
 public:
+    // Invalid subscriptions (e.g. "a/b+" or "a/#/b") are ignored
     void register_callback(const std::string& topic, uint8_t qos, const OnMessageCallback& cb);
     void unregister_callback(const std::string& topic);
     void handle_message(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len);
     std::vector<cb_filter_t> get_callbacks();
 
-private:
-    int mosquitto_topic_matches_sub(const char* sub, const char* topic, bool* result);
-
-    std::vector<cb_filter_t> _callbacks;
+    // Does a topic match a subscription? Reference implementation of mosquitto.
+    static int mosquitto_topic_matches_sub(const char* sub, const char* topic, bool* result);
 
     enum mosq_err_t {
         MOSQ_ERR_SUCCESS = 0,
         MOSQ_ERR_INVAL = 3,
     };
+
+private:
+    struct node_t {
+        // Key is the topic level, including the "+" and "#" wildcards
+        std::map<std::string, std::unique_ptr<node_t>, std::less<>> children;
+
+        // Subscriptions ending at this level
+        std::vector<cb_filter_t> callbacks;
+    };
+
+    static bool is_valid_sub(const std::string& topic);
+    static bool remove(node_t& node, const char* level);
+    static void collect(const node_t& node, std::vector<cb_filter_t>& callbacks);
+
+    void match(const node_t& node, const char* level, const bool first,
+        const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len);
+
+    node_t _root;
 };
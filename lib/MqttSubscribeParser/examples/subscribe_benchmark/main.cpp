@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+
+/*
+Compares the dispatch time of MqttSubscribeParser with a linear scan over
+all subscriptions using mosquitto_topic_matches_sub, as implemented before
+the trie. Random subscriptions and topics are matched by both first to
+verify that the trie matches exactly the same subscriptions.
+
+Build and run:
+    pio run -e native_subscribe_benchmark
+    .pio/build/native_subscribe_benchmark/program [max subscriptions] [messages]
+*/
+#include <MqttSubscribeParser.h>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+static const char* const commands[] = {
+    "limit_persistent_relative",
+    "limit_persistent_absolute",
+    "limit_nonpersistent_relative",
+    "limit_nonpersistent_absolute",
+    "power",
+    "restart",
+    "reset_rf_stats",
+};
+
+// Dispatch as implemented before the trie
+static uint32_t dispatchLinear(const std::vector<std::string>& subscriptions, const char* topic)
+{
+    uint32_t matches = 0;
+    bool result = false;
+    for (const auto& sub : subscriptions) {
+        if (MqttSubscribeParser::mosquitto_topic_matches_sub(sub.c_str(), topic, &result) == MqttSubscribeParser::MOSQ_ERR_SUCCESS && result) {
+            matches++;
+        }
+    }
+    return matches;
+}
+
+// Random topics built from a few levels, including empty levels and "$".
+// Subscriptions are always valid, the reference implementation does not
+// reject every invalid subscription.
+static std::string randomTopic(std::mt19937& rng, const bool wildcards)
+{
+    static const char* const levels[] = { "a", "b", "", "$s" };
+
+    std::string topic;
+    const int depth = 1 + rng() % 4;
+    for (int i = 0; i < depth; i++) {
+        if (i > 0) {
+            topic += '/';
+        }
+        if (wildcards && rng() % 3 == 0) {
+            topic += (i == depth - 1 && rng() % 2 == 0) ? "#" : "+";
+        } else {
+            topic += levels[rng() % 4];
+        }
+    }
+    return topic;
+}
+
+static bool verify(const uint32_t rounds)
+{
+    std::mt19937 rng(42);
+    const espMqttClientTypes::MessageProperties properties = {};
+
+    for (uint32_t r = 0; r < rounds; r++) {
+        const std::string sub = randomTopic(rng, true);
+        const std::string topic = randomTopic(rng, false);
+
+        MqttSubscribeParser parser;
+        uint32_t matches = 0;
+        parser.register_callback(sub, 0, [&](const espMqttClientTypes::MessageProperties&, const char*, const uint8_t*, size_t) { matches++; });
+        parser.handle_message(properties, topic.c_str(), nullptr, 0);
+
+        const uint32_t expected = dispatchLinear({ sub }, topic.c_str());
+        if (matches != expected) {
+            fprintf(stderr, "Subscription '%s' and topic '%s': %" PRIu32 " matches instead of %" PRIu32 "\n",
+                sub.c_str(), topic.c_str(), matches, expected);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool run(const uint32_t subscriptionCount, const uint32_t messageCount)
+{
+    const espMqttClientTypes::MessageProperties properties = {};
+
+    // One subscription per inverter and command plus the wildcard
+    // subscriptions registered by MqttHandleInverter
+    std::vector<std::string> subscriptions;
+    for (const char* command : commands) {
+        subscriptions.push_back(std::string("solar/+/cmd/") + command);
+    }
+    for (uint32_t i = 0; subscriptions.size() < subscriptionCount; i++) {
+        char serial[16];
+        snprintf(serial, sizeof(serial), "%012" PRIx64, static_cast<uint64_t>(0x116100000000ULL + i / 7));
+        subscriptions.push_back(std::string("solar/") + serial + "/cmd/" + commands[i % 7]);
+    }
+
+    std::vector<std::string> topics;
+    std::mt19937 rng(1);
+    for (uint32_t i = 0; i < 64; i++) {
+        char serial[16];
+        snprintf(serial, sizeof(serial), "%012" PRIx64, static_cast<uint64_t>(0x116100000000ULL + rng() % (subscriptionCount / 7 + 1)));
+        topics.push_back(std::string("solar/") + serial + "/cmd/" + commands[rng() % 7]);
+    }
+
+    MqttSubscribeParser parser;
+    uint32_t trieMatches = 0;
+    for (const auto& sub : subscriptions) {
+        parser.register_callback(sub, 0, [&](const espMqttClientTypes::MessageProperties&, const char*, const uint8_t*, size_t) { trieMatches++; });
+    }
+
+    uint32_t linearMatches = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < messageCount; i++) {
+        linearMatches += dispatchLinear(subscriptions, topics[i % topics.size()].c_str());
+    }
+    const std::chrono::duration<double> linear = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < messageCount; i++) {
+        parser.handle_message(properties, topics[i % topics.size()].c_str(), nullptr, 0);
+    }
+    const std::chrono::duration<double> trie = std::chrono::steady_clock::now() - start;
+
+    printf("%6zu subscriptions: linear %9.2f us per message, trie %6.2f us per message\n",
+        subscriptions.size(), linear.count() * 1e6 / messageCount, trie.count() * 1e6 / messageCount);
+
+    if (linearMatches != trieMatches) {
+        fprintf(stderr, "Linear scan matched %" PRIu32 " and trie %" PRIu32 " subscriptions\n", linearMatches, trieMatches);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t maxSubscriptions = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000;
+    const uint32_t messageCount = argc > 2 ? strtoul(argv[2], nullptr, 10) : 2000;
+
+    if (maxSubscriptions < 7 || messageCount == 0) {
+        fprintf(stderr, "At least 7 subscriptions and one message are required\n");
+        return 1;
+    }
+
+    if (!verify(100000)) {
+        return 1;
+    }
+
+    for (uint32_t count = 7; count <= maxSubscriptions; count *= 10) {
+        if (!run(count, messageCount)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
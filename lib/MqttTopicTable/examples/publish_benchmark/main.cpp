@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+
+/*
+Compares the heap allocations and CPU time of one MQTT publish cycle of
+MqttHandleInverter when topics are assembled from Strings for every value
+and when they are taken from a MqttTopicTable and assembled in a
+MqttPublishBuffer. Publishing itself is replaced by a checksum, so only the
+topic and payload handling is measured. Both variants have to produce the
+same topics and payloads. The cycle publishing one aggregated JSON document
+per inverter is measured as well.
+
+Build and run:
+    pio run -e native_mqtt_benchmark
+    .pio/build/native_mqtt_benchmark/program <inverter serial> [inverter count] [cycles]
+
+Note that the host std::string uses a larger small string buffer than the
+Arduino String, so short topics and payloads allocate less often here than
+on the ESP32.
+*/
+#include <Arduino.h>
+#include <Hoymiles.h>
+#include <MqttPublishBuffer.h>
+#include <MqttTopicTable.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <esp_log.h>
+#include <new>
+
+static std::atomic<uint64_t> allocations { 0 };
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* p = malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+#define MQTT_PREFIX "solar/"
+
+static const FieldId_t publishFields[] = {
+    FLD_UDC, FLD_IDC, FLD_PDC, FLD_YD, FLD_YT, FLD_UAC, FLD_IAC,
+    FLD_PAC, FLD_F, FLD_T, FLD_PF, FLD_EFF, FLD_IRR, FLD_Q
+};
+
+// Order independent checksum of all published topics and payloads
+struct Sink {
+    uint64_t checksum = 0;
+    uint32_t count = 0;
+
+    void publish(const char* topic, const char* payload)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (const char* c = topic; *c != '\0'; c++) {
+            hash = (hash ^ static_cast<uint8_t>(*c)) * 1099511628211ULL;
+        }
+        hash = (hash ^ '=') * 1099511628211ULL;
+        for (const char* c = payload; *c != '\0'; c++) {
+            hash = (hash ^ static_cast<uint8_t>(*c)) * 1099511628211ULL;
+        }
+        checksum += hash;
+        count++;
+    }
+};
+
+// Publish cycle as implemented before the topic table
+static void publishStrings(Sink& sink)
+{
+    const String prefix = MQTT_PREFIX;
+
+    auto publish = [&](const String& subtopic, const String& payload) {
+        String topic = prefix;
+        topic += subtopic;
+
+        String value = payload;
+        value.trim();
+
+        sink.publish(topic.c_str(), value.c_str());
+    };
+
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+
+        const String subtopic = inv->serialString();
+
+        publish(subtopic + "/name", inv->name());
+        publish(subtopic + "/radio/tx_request", String(inv->RadioStats.TxRequestData));
+        publish(subtopic + "/radio/tx_re_request", String(inv->RadioStats.TxReRequestFragment));
+        publish(subtopic + "/radio/rx_success", String(inv->RadioStats.RxSuccess));
+        publish(subtopic + "/radio/rx_fail_nothing", String(inv->RadioStats.RxFailNoAnswer));
+        publish(subtopic + "/radio/rx_fail_partial", String(inv->RadioStats.RxFailPartialAnswer));
+        publish(subtopic + "/radio/rx_fail_corrupt", String(inv->RadioStats.RxFailCorruptData));
+        publish(subtopic + "/radio/rssi", String(inv->getLastRssi()));
+        publish(subtopic + "/status/limit_relative", String(inv->SystemConfigPara()->getLimitPercent()));
+        publish(subtopic + "/status/reachable", String(inv->isReachable()));
+        publish(subtopic + "/status/producing", String(inv->isProducing()));
+        publish(subtopic + "/status/last_update", String(0));
+
+        for (auto& t : inv->Statistics()->getChannelTypes()) {
+            for (auto& c : inv->Statistics()->getChannelsByType(t)) {
+                if (t == TYPE_DC) {
+                    publish(inv->serialString() + "/" + String(static_cast<uint8_t>(c) + 1) + "/name", "Panel");
+                }
+                for (auto f : publishFields) {
+                    if (!inv->Statistics()->hasChannelFieldValue(t, c, f)) {
+                        continue;
+                    }
+
+                    String chanName;
+                    if (t == TYPE_INV && f == FLD_PDC) {
+                        chanName = "powerdc";
+                    } else {
+                        chanName = inv->Statistics()->getChannelFieldName(t, c, f);
+                        chanName.toLowerCase();
+                    }
+
+                    String chanNum;
+                    if (t == TYPE_DC) {
+                        chanNum = String(static_cast<uint8_t>(c) + 1);
+                    } else {
+                        chanNum = String(c);
+                    }
+
+                    publish(inv->serialString() + "/" + chanNum + "/" + chanName, inv->Statistics()->getChannelFieldValueString(t, c, f));
+                }
+            }
+        }
+    }
+}
+
+// Publish cycle of MqttHandleInverter using the topic table
+static void publishTable(Sink& sink, MqttTopicTable* tables, MqttPublishBuffer& buffer)
+{
+    buffer.setPrefix(MQTT_PREFIX);
+
+    auto publish = [&](const char* subtopic, const char* payload) {
+        sink.publish(buffer.setTopic(subtopic), payload);
+    };
+
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+
+        auto& topics = tables[i];
+        if (topics.getSerial() != inv->serial()) {
+            topics.build(*inv, publishFields, sizeof(publishFields) / sizeof(FieldId_t));
+        }
+
+        publish(topics.getTopic(InverterTopic::Name), buffer.setPayload(inv->name()));
+        publish(topics.getTopic(InverterTopic::RadioTxRequest), buffer.setPayload(static_cast<int64_t>(inv->RadioStats.TxRequestData)));
+        publish(topics.getTopic(InverterTopic::RadioTxReRequest), buffer.setPayload(static_cast<int64_t>(inv->RadioStats.TxReRequestFragment)));
+        publish(topics.getTopic(InverterTopic::RadioRxSuccess), buffer.setPayload(static_cast<int64_t>(inv->RadioStats.RxSuccess)));
+        publish(topics.getTopic(InverterTopic::RadioRxFailNothing), buffer.setPayload(static_cast<int64_t>(inv->RadioStats.RxFailNoAnswer)));
+        publish(topics.getTopic(InverterTopic::RadioRxFailPartial), buffer.setPayload(static_cast<int64_t>(inv->RadioStats.RxFailPartialAnswer)));
+        publish(topics.getTopic(InverterTopic::RadioRxFailCorrupt), buffer.setPayload(static_cast<int64_t>(inv->RadioStats.RxFailCorruptData)));
+        publish(topics.getTopic(InverterTopic::RadioRssi), buffer.setPayload(static_cast<int64_t>(inv->getLastRssi())));
+        publish(topics.getTopic(InverterTopic::StatusLimitRelative), buffer.setPayload(inv->SystemConfigPara()->getLimitPercent(), 2));
+        publish(topics.getTopic(InverterTopic::StatusReachable), buffer.setPayload(static_cast<int64_t>(inv->isReachable())));
+        publish(topics.getTopic(InverterTopic::StatusProducing), buffer.setPayload(static_cast<int64_t>(inv->isProducing())));
+        publish(topics.getTopic(InverterTopic::StatusLastUpdate), buffer.setPayload(static_cast<int64_t>(0)));
+
+        for (auto& channelName : topics.getChannelNames()) {
+            publish(topics.getTopic(channelName), buffer.setPayload("Panel"));
+        }
+
+        for (auto& field : topics.getFields()) {
+            publish(topics.getTopic(field), buffer.setPayload(
+                                                inv->Statistics()->getChannelFieldValue(field.Type, field.Channel, field.Field),
+                                                inv->Statistics()->getChannelFieldDigits(field.Type, field.Channel, field.Field)));
+        }
+    }
+}
+
+// Publish cycle of MqttHandleInverter with the aggregated JSON document only
+static void publishJson(Sink& sink, MqttTopicTable* tables, MqttPublishBuffer& buffer)
+{
+    buffer.setPrefix(MQTT_PREFIX);
+
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+
+        auto& topics = tables[i];
+        if (topics.getSerial() != inv->serial()) {
+            topics.build(*inv, publishFields, sizeof(publishFields) / sizeof(FieldId_t));
+        }
+
+        buffer.beginDocument(MqttDocumentFormat::Json);
+        buffer.addDocumentValue(topics.getKey(InverterTopic::StatusLastUpdate), static_cast<int64_t>(0));
+        buffer.addDocumentValue(topics.getKey(InverterTopic::StatusReachable), static_cast<int64_t>(inv->isReachable()));
+        buffer.addDocumentValue(topics.getKey(InverterTopic::StatusProducing), static_cast<int64_t>(inv->isProducing()));
+        for (auto& field : topics.getFields()) {
+            buffer.addDocumentValue(topics.getKey(field),
+                inv->Statistics()->getChannelFieldValue(field.Type, field.Channel, field.Field),
+                inv->Statistics()->getChannelFieldDigits(field.Type, field.Channel, field.Field));
+        }
+
+        sink.publish(buffer.setTopic(topics.getTopic(InverterTopic::Json)), buffer.endDocument());
+    }
+}
+
+template <typename Cycle>
+static Sink run(const char* name, const uint32_t cycles, Cycle cycle)
+{
+    // Warm up, the topic table and the reused buffers are built here
+    Sink result;
+    cycle(result);
+
+    Sink sink;
+    const uint64_t allocationsStart = allocations;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < cycles; i++) {
+        cycle(sink);
+    }
+
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    const double cycleAllocations = static_cast<double>(allocations - allocationsStart) / cycles;
+
+    printf("%-8s %" PRIu32 " publishes per cycle, %.1f allocations per cycle, %.2f us per cycle\n",
+        name, result.count, cycleAllocations, duration.count() * 1e6 / cycles);
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <inverter serial> [inverter count] [cycles]\n", argv[0]);
+        return 1;
+    }
+
+    const uint64_t baseSerial = strtoull(argv[1], nullptr, 16);
+    const uint32_t inverterCount = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+    const uint32_t cycleCount = argc > 3 ? strtoul(argv[3], nullptr, 10) : 10000;
+
+    if (inverterCount == 0 || inverterCount > 255 || cycleCount == 0) {
+        fprintf(stderr, "Invalid inverter or cycle count\n");
+        return 1;
+    }
+
+    esp_log_level_set("*", ESP_LOG_ERROR);
+
+    Hoymiles.init();
+
+    for (uint32_t i = 0; i < inverterCount; i++) {
+        char name[MAX_NAME_LENGTH];
+        snprintf(name, sizeof(name), "Sim %" PRIu32, i);
+        if (Hoymiles.addInverter(name, baseSerial + i) == nullptr) {
+            fprintf(stderr, "Serial %s is not supported\n", argv[1]);
+            return 1;
+        }
+    }
+
+    std::vector<MqttTopicTable> tables(inverterCount);
+    MqttPublishBuffer buffer;
+
+    const Sink strings = run("strings", cycleCount, [](Sink& sink) { publishStrings(sink); });
+    const Sink table = run("table", cycleCount, [&](Sink& sink) { publishTable(sink, tables.data(), buffer); });
+    run("json", cycleCount, [&](Sink& sink) { publishJson(sink, tables.data(), buffer); });
+
+    if (strings.count != table.count || strings.checksum != table.checksum) {
+        fprintf(stderr, "Published topics or payloads differ\n");
+        return 1;
+    }
+
+    return 0;
+}
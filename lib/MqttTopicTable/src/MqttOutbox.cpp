@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "MqttOutbox.h"
+#include <algorithm>
+#include <cstring>
+
+void MqttOutbox::setBudget(const size_t bytes)
+{
+    _budget = bytes;
+    makeRoom(0, MqttPriority::High);
+}
+
+size_t MqttOutbox::getBudget() const
+{
+    return _budget;
+}
+
+void MqttOutbox::setCoalesce(const bool coalesce)
+{
+    _coalesce = coalesce;
+}
+
+bool MqttOutbox::push(const char* topic, const char* payload, const uint8_t qos, const bool retain, const MqttPriority priority)
+{
+    const uint32_t topicHash = hashTopic(topic);
+    const size_t bytes = sizeof(Message_t) + strlen(topic) + strlen(payload);
+
+    // Only replaced once the new message is accepted
+    auto previous = _messages.end();
+    if (_coalesce) {
+        for (auto it = _messages.begin(); it != _messages.end(); ++it) {
+            if (it->TopicHash == topicHash && it->Topic == topic) {
+                previous = it;
+                break;
+            }
+        }
+    }
+
+    if (!hasRoom(bytes, priority, previous)) {
+        _dropped++;
+        addDropped(topicHash, priority);
+        return false;
+    }
+
+    if (previous != _messages.end()) {
+        _bytes -= getMessageBytes(*previous);
+        _messages.erase(previous);
+        _coalesced++;
+    }
+
+    makeRoom(bytes, priority);
+
+    _messages.push_back({ topicHash, topic, payload, qos, retain, priority });
+    _bytes += bytes;
+    return true;
+}
+
+const MqttOutbox::Message_t* MqttOutbox::front() const
+{
+    if (_messages.empty()) {
+        return nullptr;
+    }
+    return &_messages.front();
+}
+
+void MqttOutbox::pop()
+{
+    if (_messages.empty()) {
+        return;
+    }
+    _bytes -= getMessageBytes(_messages.front());
+    _inFlight.push_back({ _messages.front().TopicHash, _messages.front().Priority });
+    _messages.pop_front();
+}
+
+void MqttOutbox::clear()
+{
+    _messages.clear();
+    _messages.shrink_to_fit();
+    _bytes = 0;
+    _inFlight.clear();
+}
+
+void MqttOutbox::setInFlight(const size_t queued)
+{
+    // The client sends its queue in order, so only the newest messages can be left.
+    // Its queue also holds messages which did not pass the outbox, so this may keep a few too many.
+    while (_inFlight.size() > queued) {
+        _inFlight.pop_front();
+    }
+}
+
+void MqttOutbox::dropInFlight()
+{
+    for (const auto& message : _inFlight) {
+        addDropped(message.TopicHash, message.Priority);
+        _dropped++;
+    }
+    _inFlight.clear();
+}
+
+size_t MqttOutbox::size() const
+{
+    return _messages.size();
+}
+
+size_t MqttOutbox::getBytes() const
+{
+    return _bytes;
+}
+
+uint32_t MqttOutbox::getDropped() const
+{
+    return _dropped;
+}
+
+uint32_t MqttOutbox::getCoalesced() const
+{
+    return _coalesced;
+}
+
+bool MqttOutbox::takeDroppedTopics(const MqttPriority priority, std::vector<uint32_t>& topics)
+{
+    auto& dropped = _droppedTopics[static_cast<uint8_t>(priority)];
+
+    // The capacity is handed back and forth, so it is only allocated once
+    topics.clear();
+    topics.swap(dropped.Hashes);
+    std::sort(topics.begin(), topics.end());
+
+    const bool complete = !dropped.Overflow;
+    dropped.Overflow = false;
+    return complete;
+}
+
+uint32_t MqttOutbox::hashTopic(const char* topic, uint32_t hash)
+{
+    for (const char* c = topic; *c != '\0'; c++) {
+        hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619UL;
+    }
+    return hash;
+}
+
+size_t MqttOutbox::getMessageBytes(const Message_t& message)
+{
+    return sizeof(Message_t) + message.Topic.length() + message.Payload.length();
+}
+
+// Whether the given amount of bytes fits into the budget once the replaced
+// message and all messages makeRoom() may drop are removed
+bool MqttOutbox::hasRoom(const size_t bytes, const MqttPriority priority, const std::deque<Message_t>::const_iterator replaced) const
+{
+    if (_budget == 0) {
+        return true;
+    }
+
+    if (bytes > _budget) {
+        return false;
+    }
+
+    size_t available = _budget > _bytes ? _budget - _bytes : 0;
+    for (auto it = _messages.begin(); it != _messages.end() && available < bytes; ++it) {
+        if (it == replaced || it->Priority <= priority) {
+            available += getMessageBytes(*it);
+        }
+    }
+
+    return available >= bytes;
+}
+
+// Drops queued messages until the given amount of bytes fits into the budget
+bool MqttOutbox::makeRoom(const size_t bytes, const MqttPriority priority)
+{
+    if (_budget == 0) {
+        return true;
+    }
+
+    if (bytes > _budget) {
+        return false;
+    }
+
+    while (_bytes + bytes > _budget) {
+        // Oldest message of the lowest priority
+        auto victim = _messages.end();
+        for (auto it = _messages.begin(); it != _messages.end(); ++it) {
+            if (it->Priority <= priority && (victim == _messages.end() || it->Priority < victim->Priority)) {
+                victim = it;
+            }
+        }
+
+        if (victim == _messages.end()) {
+            return false;
+        }
+
+        _bytes -= getMessageBytes(*victim);
+        addDropped(victim->TopicHash, victim->Priority);
+        _messages.erase(victim);
+        _dropped++;
+    }
+
+    return true;
+}
+
+void MqttOutbox::addDropped(const uint32_t topicHash, const MqttPriority priority)
+{
+    auto& dropped = _droppedTopics[static_cast<uint8_t>(priority)];
+    if (std::find(dropped.Hashes.begin(), dropped.Hashes.end(), topicHash) != dropped.Hashes.end()) {
+        return;
+    }
+
+    if (dropped.Hashes.size() >= MQTT_OUTBOX_DROPPED_TOPICS_MAX) {
+        dropped.Overflow = true;
+        return;
+    }
+    dropped.Hashes.push_back(topicHash);
+}
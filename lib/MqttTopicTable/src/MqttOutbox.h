@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Topics of dropped messages recorded per priority until they are taken
+#define MQTT_OUTBOX_DROPPED_TOPICS_MAX 256
+
+enum class MqttPriority : uint8_t {
+    Low,
+    Normal,
+    High,
+};
+
+// Messages waiting to be handed over to the MQTT client. The memory used by
+// all queued messages is limited to a byte budget. If a new message does not
+// fit, queued messages of the same or a lower priority are dropped, the
+// oldest message of the lowest priority first. If that is not enough, the
+// new message is dropped instead.
+// With coalescing enabled, a queued message is dropped once a newer message
+// of the same topic is accepted.
+// The topics of dropped messages are recorded, so their publishers can send
+// just these again instead of everything. This includes messages which were
+// handed over to the client but were still in its queue when the connection
+// was lost.
+class MqttOutbox {
+public:
+    struct Message_t {
+        uint32_t TopicHash; // compared before the topic when coalescing
+        std::string Topic;
+        std::string Payload;
+        uint8_t Qos;
+        bool Retain;
+        MqttPriority Priority;
+    };
+
+    // 0 disables the budget. Messages exceeding a lower budget are dropped.
+    void setBudget(const size_t bytes);
+    size_t getBudget() const;
+
+    void setCoalesce(const bool coalesce);
+
+    // Returns false if the message was dropped
+    bool push(const char* topic, const char* payload, const uint8_t qos, const bool retain, const MqttPriority priority);
+
+    // Oldest message, nullptr if the outbox is empty
+    const Message_t* front() const;
+    // Removes the oldest message once the client accepted it
+    void pop();
+    void clear();
+
+    // The client still queues the given number of messages, the ones handed over before were sent
+    void setInFlight(const size_t queued);
+    // The connection was lost, the messages still queued by the client are recorded as dropped
+    void dropInFlight();
+
+    size_t size() const;
+
+    // Approximate heap usage of all queued messages
+    size_t getBytes() const;
+
+    uint32_t getDropped() const;
+    uint32_t getCoalesced() const;
+
+    // Sorted hashes of the topics of the given priority which were dropped since the
+    // last call. Returns false if more than MQTT_OUTBOX_DROPPED_TOPICS_MAX different
+    // topics were dropped, the list is incomplete then.
+    bool takeDroppedTopics(const MqttPriority priority, std::vector<uint32_t>& topics);
+
+    // FNV-1a, pass the hash of a prefix to continue it with the topic
+    static uint32_t hashTopic(const char* topic, uint32_t hash = 2166136261UL);
+
+private:
+    struct DroppedTopics_t {
+        std::vector<uint32_t> Hashes;
+        bool Overflow = false;
+    };
+
+    struct InFlight_t {
+        uint32_t TopicHash;
+        MqttPriority Priority;
+    };
+
+    static size_t getMessageBytes(const Message_t& message);
+    bool hasRoom(const size_t bytes, const MqttPriority priority, const std::deque<Message_t>::const_iterator replaced) const;
+    bool makeRoom(const size_t bytes, const MqttPriority priority);
+    void addDropped(const uint32_t topicHash, const MqttPriority priority);
+
+    std::deque<Message_t> _messages;
+    size_t _bytes = 0;
+
+    // Handed over to the client, but maybe not sent yet. Oldest first.
+    std::deque<InFlight_t> _inFlight;
+    size_t _budget = 0;
+    bool _coalesce = false;
+
+    uint32_t _dropped = 0;
+    uint32_t _coalesced = 0;
+
+    DroppedTopics_t _droppedTopics[static_cast<uint8_t>(MqttPriority::High) + 1];
+};
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "MqttPublishBuffer.h"
+#include <cctype>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+void MqttPublishBuffer::setPrefix(const char* prefix)
+{
+    _topic.assign(prefix);
+    _prefixLength = _topic.length();
+}
+
+const char* MqttPublishBuffer::setTopic(const char* subtopic)
+{
+    _topic.resize(_prefixLength);
+    _topic.append(subtopic);
+    return _topic.c_str();
+}
+
+const char* MqttPublishBuffer::setPayload(const char* payload)
+{
+    const char* begin = payload;
+    while (isspace(static_cast<unsigned char>(*begin))) {
+        begin++;
+    }
+
+    const char* end = begin + strlen(begin);
+    while (end > begin && isspace(static_cast<unsigned char>(*(end - 1)))) {
+        end--;
+    }
+
+    _payload.assign(begin, end);
+    return _payload.c_str();
+}
+
+const char* MqttPublishBuffer::setPayload(const float value, const uint8_t digits)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    _payload.assign(buffer);
+    return _payload.c_str();
+}
+
+const char* MqttPublishBuffer::setPayload(const int64_t value)
+{
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%" PRId64, value);
+    _payload.assign(buffer);
+    return _payload.c_str();
+}
+
+const char* MqttPublishBuffer::getPayload() const
+{
+    return _payload.c_str();
+}
+
+void MqttPublishBuffer::beginDocument(const MqttDocumentFormat format)
+{
+    _format = format;
+    _documentValues = 0;
+    _payload.clear();
+    if (_format == MqttDocumentFormat::Json) {
+        _payload.push_back('{');
+    }
+}
+
+void MqttPublishBuffer::addDocumentValue(const char* key, const float value, const uint8_t digits)
+{
+    char buffer[32];
+    if (std::isfinite(value)) {
+        snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    } else {
+        strcpy(buffer, _format == MqttDocumentFormat::Json ? "null" : "");
+    }
+    appendDocumentValue(key, buffer);
+}
+
+void MqttPublishBuffer::addDocumentValue(const char* key, const int64_t value)
+{
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%" PRId64, value);
+    appendDocumentValue(key, buffer);
+}
+
+const char* MqttPublishBuffer::endDocument()
+{
+    if (_format == MqttDocumentFormat::Json) {
+        _payload.push_back('}');
+    }
+    return _payload.c_str();
+}
+
+void MqttPublishBuffer::appendDocumentValue(const char* key, const char* value)
+{
+    if (_documentValues++ > 0) {
+        _payload.push_back(',');
+    }
+
+    switch (_format) {
+    case MqttDocumentFormat::Json:
+        _payload.push_back('"');
+        _payload.append(key);
+        _payload.append("\":");
+        _payload.append(value);
+        break;
+    case MqttDocumentFormat::Csv:
+        _payload.append(value);
+        break;
+    case MqttDocumentFormat::CsvHeader:
+        _payload.append(key);
+        break;
+    }
+}
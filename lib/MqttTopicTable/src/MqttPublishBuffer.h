@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+enum class MqttDocumentFormat : uint8_t {
+    Json, // {"key":value,...}
+    Csv, // value,...
+    CsvHeader, // key,...
+};
+
+// Assembles topic and payload of a publish in buffers which are reused for
+// every publish. Once both buffers reached their final size no further
+// allocation takes place.
+class MqttPublishBuffer {
+public:
+    void setPrefix(const char* prefix);
+
+    // Returns prefix + subtopic
+    const char* setTopic(const char* subtopic);
+
+    // Leading and trailing whitespace is removed
+    const char* setPayload(const char* payload);
+    const char* setPayload(const float value, const uint8_t digits);
+    const char* setPayload(const int64_t value);
+    const char* getPayload() const;
+
+    // Assembles a document of several values in the payload buffer.
+    // Keys are not escaped. Values which are not finite are written as
+    // null (JSON) or left empty (CSV).
+    void beginDocument(const MqttDocumentFormat format);
+    void addDocumentValue(const char* key, const float value, const uint8_t digits);
+    void addDocumentValue(const char* key, const int64_t value);
+    const char* endDocument();
+
+private:
+    void appendDocumentValue(const char* key, const char* value);
+
+    std::string _topic;
+    size_t _prefixLength = 0;
+    std::string _payload;
+
+    MqttDocumentFormat _format = MqttDocumentFormat::Json;
+    uint16_t _documentValues = 0;
+};
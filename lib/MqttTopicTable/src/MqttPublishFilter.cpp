@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "MqttPublishFilter.h"
+#include <cmath>
+#include <cstdlib>
+
+void MqttPublishFilter::setEnabled(const bool enabled)
+{
+    _enabled = enabled;
+}
+
+bool MqttPublishFilter::getEnabled() const
+{
+    return _enabled;
+}
+
+void MqttPublishFilter::setDeadband(const uint16_t steps, const float relative)
+{
+    _deadbandSteps = steps;
+    _deadbandRelative = relative;
+}
+
+void MqttPublishFilter::setMaxAge(const uint32_t maxAge)
+{
+    _maxAge = maxAge;
+}
+
+bool MqttPublishFilter::check(MqttPublishState_t& state, const char* payload, const uint32_t now) const
+{
+    if (!_enabled) {
+        return true;
+    }
+
+    const uint32_t payloadHash = hash(payload);
+    if (state.Published && state.Hash == payloadHash && !isExpired(state, now)) {
+        return false;
+    }
+
+    state.Published = true;
+    state.Time = now;
+    state.Hash = payloadHash;
+    return true;
+}
+
+bool MqttPublishFilter::checkChanged(MqttPublishState_t& state, const char* payload, const uint32_t now)
+{
+    const uint32_t payloadHash = hash(payload);
+    if (state.Published && state.Hash == payloadHash) {
+        return false;
+    }
+
+    state.Published = true;
+    state.Time = now;
+    state.Hash = payloadHash;
+    return true;
+}
+
+bool MqttPublishFilter::check(MqttPublishState_t& state, const float value, const uint8_t digits, const uint32_t now) const
+{
+    if (!_enabled) {
+        return true;
+    }
+
+    if (state.Published && !isSignificant(state.Value, value, digits) && !isExpired(state, now)) {
+        return false;
+    }
+
+    state.Published = true;
+    state.Time = now;
+    state.Value = value;
+    return true;
+}
+
+uint32_t MqttPublishFilter::hash(const char* payload)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261UL;
+    for (const char* c = payload; *c != '\0'; c++) {
+        hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619UL;
+    }
+    return hash;
+}
+
+bool MqttPublishFilter::isExpired(const MqttPublishState_t& state, const uint32_t now) const
+{
+    return _maxAge > 0 && now - state.Time >= _maxAge;
+}
+
+bool MqttPublishFilter::isSignificant(const float last, const float value, const uint8_t digits) const
+{
+    if (std::isnan(last) || std::isnan(value)) {
+        return std::isnan(last) != std::isnan(value);
+    }
+
+    // Compare the published representation, changes below the last digit are never published
+    const double scale = std::pow(10.0, digits);
+    const int64_t steps = std::llabs(std::llround(value * scale) - std::llround(last * scale));
+    if (steps <= _deadbandSteps) {
+        return false;
+    }
+
+    return std::fabs(value - last) > std::fabs(last) * _deadbandRelative / 100;
+}
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+
+// Last published value of a topic
+struct MqttPublishState_t {
+    bool Published = false;
+    uint32_t Time = 0; // millis() of the last publish
+    uint32_t Hash = 0; // of the last payload, if it was not a number
+    float Value = 0; // last value, if it was a number
+};
+
+// Decides whether a value has to be published if only changes are published.
+// A value is published if it changed beyond the deadband or if its last
+// publish is older than the max age.
+class MqttPublishFilter {
+public:
+    void setEnabled(const bool enabled);
+    bool getEnabled() const;
+
+    // steps: Number of steps of the last published digit a value may change without being published
+    // relative: Change in percent of the last published value a value may change without being published
+    void setDeadband(const uint16_t steps, const float relative);
+
+    // in ms, 0 to disable the heartbeat
+    void setMaxAge(const uint32_t maxAge);
+
+    // Return true if the value has to be published. The state is only used
+    // and updated if the filter is enabled.
+    bool check(MqttPublishState_t& state, const char* payload, const uint32_t now) const;
+    bool check(MqttPublishState_t& state, const float value, const uint8_t digits, const uint32_t now) const;
+
+    // Return true if the payload differs from the last one of the state, regardless
+    // of the enabled state and the max age. For payloads which are published once.
+    static bool checkChanged(MqttPublishState_t& state, const char* payload, const uint32_t now);
+
+private:
+    static uint32_t hash(const char* payload);
+    bool isExpired(const MqttPublishState_t& state, const uint32_t now) const;
+    bool isSignificant(const float last, const float value, const uint8_t digits) const;
+
+    bool _enabled = false;
+    uint16_t _deadbandSteps = 0;
+    float _deadbandRelative = 0;
+    uint32_t _maxAge = 0;
+};
@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "MqttTopicTable.h"
+#include "MqttOutbox.h"
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+static const char* const inverterTopics[INVERTER_TOPIC_COUNT] = {
+    "name",
+    "radio/tx_request",
+    "radio/tx_re_request",
+    "radio/rx_success",
+    "radio/rx_fail_nothing",
+    "radio/rx_fail_partial",
+    "radio/rx_fail_corrupt",
+    "radio/rssi",
+    "device/bootloaderversion",
+    "device/fwbuildversion",
+    "device/fwbuilddatetime",
+    "device/hwpartnumber",
+    "device/hwversion",
+    "status/limit_relative",
+    "status/limit_absolute",
+    "status/reachable",
+    "status/producing",
+    "status/last_update",
+    "json",
+    "csv",
+    "csv/columns",
+};
+
+void MqttTopicTable::build(InverterAbstract& inv, const FieldId_t* fields, const size_t fieldCount)
+{
+    clear();
+
+    const String& serial = inv.serialString();
+    auto statistics = inv.Statistics();
+    _keyOffset = serial.length() + 1;
+
+    for (uint8_t t = 0; t < INVERTER_TOPIC_COUNT; t++) {
+        _topics[t] = addTopic(serial, -1, inverterTopics[t]);
+        _states[t] = {};
+    }
+
+    for (auto& t : statistics->getChannelTypes()) {
+        for (auto& c : statistics->getChannelsByType(t)) {
+            const uint8_t channelNumber = getChannelNumber(t, c);
+
+            if (t == TYPE_DC) {
+                _channelNames.push_back({ c, addTopic(serial, channelNumber, "name"), {} });
+            }
+
+            for (size_t f = 0; f < fieldCount; f++) {
+                if (!statistics->hasChannelFieldValue(t, c, fields[f])) {
+                    continue;
+                }
+                _fields.push_back({ t, c, fields[f], addTopic(serial, channelNumber, getFieldName(*statistics, t, c, fields[f])), {} });
+            }
+        }
+    }
+
+    _buffer.shrink_to_fit();
+    _fields.shrink_to_fit();
+    _channelNames.shrink_to_fit();
+
+    // Set last, a partially built table must not match the inverter
+    _serial = inv.serial();
+}
+
+void MqttTopicTable::clear()
+{
+    _serial = 0;
+    _buffer.clear();
+    _fields.clear();
+    _channelNames.clear();
+}
+
+uint64_t MqttTopicTable::getSerial() const
+{
+    return _serial;
+}
+
+const char* MqttTopicTable::getTopic(const InverterTopic topic) const
+{
+    return &_buffer[_topics[static_cast<uint8_t>(topic)]];
+}
+
+const char* MqttTopicTable::getTopic(const Field_t& field) const
+{
+    return &_buffer[field.Topic];
+}
+
+const char* MqttTopicTable::getTopic(const ChannelName_t& channelName) const
+{
+    return &_buffer[channelName.Topic];
+}
+
+const char* MqttTopicTable::getKey(const InverterTopic topic) const
+{
+    return getTopic(topic) + _keyOffset;
+}
+
+const char* MqttTopicTable::getKey(const Field_t& field) const
+{
+    return getTopic(field) + _keyOffset;
+}
+
+MqttPublishState_t& MqttTopicTable::getState(const InverterTopic topic)
+{
+    return _states[static_cast<uint8_t>(topic)];
+}
+
+void MqttTopicTable::resetStates(const char* prefix, const std::vector<uint32_t>& topicHashes)
+{
+    if (_serial == 0 || topicHashes.empty()) {
+        return;
+    }
+
+    const uint32_t prefixHash = MqttOutbox::hashTopic(prefix);
+    auto isListed = [&](const char* topic) {
+        return std::binary_search(topicHashes.begin(), topicHashes.end(), MqttOutbox::hashTopic(topic, prefixHash));
+    };
+
+    for (uint8_t t = 0; t < INVERTER_TOPIC_COUNT; t++) {
+        if (isListed(&_buffer[_topics[t]])) {
+            _states[t] = {};
+        }
+    }
+
+    for (auto& field : _fields) {
+        if (isListed(getTopic(field))) {
+            field.State = {};
+        }
+    }
+
+    for (auto& channelName : _channelNames) {
+        if (isListed(getTopic(channelName))) {
+            channelName.State = {};
+        }
+    }
+}
+
+std::vector<MqttTopicTable::Field_t>& MqttTopicTable::getFields()
+{
+    return _fields;
+}
+
+std::vector<MqttTopicTable::ChannelName_t>& MqttTopicTable::getChannelNames()
+{
+    return _channelNames;
+}
+
+const char* MqttTopicTable::getFieldName(const StatisticsParser& statistics, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+{
+    if (type == TYPE_INV && fieldId == FLD_PDC) {
+        return "powerdc";
+    }
+    return statistics.getChannelFieldName(type, channel, fieldId);
+}
+
+uint8_t MqttTopicTable::getChannelNumber(const ChannelType_t type, const ChannelNum_t channel)
+{
+    if (type == TYPE_DC) {
+        // TODO(tbnobody)
+        return static_cast<uint8_t>(channel) + 1;
+    }
+    return channel;
+}
+
+// Appends "<serial>/[<channelNumber>/]<name>" in lower case and returns its offset
+uint16_t MqttTopicTable::addTopic(const String& serial, const int16_t channelNumber, const char* name)
+{
+    const uint16_t offset = _buffer.size();
+
+    _buffer.insert(_buffer.end(), serial.c_str(), serial.c_str() + serial.length());
+    _buffer.push_back('/');
+
+    if (channelNumber >= 0) {
+        char number[8];
+        const int len = snprintf(number, sizeof(number), "%" PRId16 "/", channelNumber);
+        _buffer.insert(_buffer.end(), number, number + len);
+    }
+
+    for (const char* c = name; *c != '\0'; c++) {
+        _buffer.push_back(static_cast<char>(tolower(static_cast<unsigned char>(*c))));
+    }
+    _buffer.push_back('\0');
+
+    return offset;
+}
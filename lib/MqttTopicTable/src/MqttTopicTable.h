@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "MqttPublishFilter.h"
+#include <Hoymiles.h>
+#include <vector>
+
+enum class InverterTopic : uint8_t {
+    Name,
+    RadioTxRequest,
+    RadioTxReRequest,
+    RadioRxSuccess,
+    RadioRxFailNothing,
+    RadioRxFailPartial,
+    RadioRxFailCorrupt,
+    RadioRssi,
+    DeviceBootloaderVersion,
+    DeviceFwBuildVersion,
+    DeviceFwBuildDateTime,
+    DeviceHwPartNumber,
+    DeviceHwVersion,
+    StatusLimitRelative,
+    StatusLimitAbsolute,
+    StatusReachable,
+    StatusProducing,
+    StatusLastUpdate,
+    Json,
+    Csv,
+    CsvColumns,
+};
+#define INVERTER_TOPIC_COUNT 21
+
+// All subtopics (without prefix) published for one inverter. The topics are
+// built once and stored back to back in a single buffer, so publishing
+// does not have to assemble or allocate them again.
+// Every topic also keeps the state of its last publish.
+class MqttTopicTable {
+public:
+    struct Field_t {
+        ChannelType_t Type;
+        ChannelNum_t Channel;
+        FieldId_t Field;
+        uint16_t Topic;
+        MqttPublishState_t State;
+    };
+
+    struct ChannelName_t {
+        ChannelNum_t Channel;
+        uint16_t Topic;
+        MqttPublishState_t State;
+    };
+
+    // Only fields which are provided by the inverter are added.
+    // All publish states are reset.
+    void build(InverterAbstract& inv, const FieldId_t* fields, const size_t fieldCount);
+    void clear();
+
+    // Serial of the inverter the table was built for, 0 if empty
+    uint64_t getSerial() const;
+
+    const char* getTopic(const InverterTopic topic) const;
+    const char* getTopic(const Field_t& field) const;
+    const char* getTopic(const ChannelName_t& channelName) const;
+
+    // Topic without the leading "<serial>/", used as key in documents
+    const char* getKey(const InverterTopic topic) const;
+    const char* getKey(const Field_t& field) const;
+
+    MqttPublishState_t& getState(const InverterTopic topic);
+
+    // Resets the publish states of all topics whose hash (see MqttOutbox::hashTopic)
+    // including the prefix is in the sorted list, so only these are published again
+    void resetStates(const char* prefix, const std::vector<uint32_t>& topicHashes);
+
+    std::vector<Field_t>& getFields();
+    std::vector<ChannelName_t>& getChannelNames();
+
+    static const char* getFieldName(const StatisticsParser& statistics, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId);
+    static uint8_t getChannelNumber(const ChannelType_t type, const ChannelNum_t channel);
+
+private:
+    uint16_t addTopic(const String& serial, const int16_t channelNumber, const char* name);
+
+    uint64_t _serial = 0;
+    uint16_t _keyOffset = 0;
+    std::vector<char> _buffer;
+    uint16_t _topics[INVERTER_TOPIC_COUNT] = {};
+    MqttPublishState_t _states[INVERTER_TOPIC_COUNT];
+    std::vector<Field_t> _fields;
+    std::vector<ChannelName_t> _channelNames;
+};
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+
+/*
+Passes items from one producer thread to one consumer thread through SpscQueue
+and ThreadSafeQueue. Verifies that every item arrives exactly once and in order
+and reports the throughput of both queues.
+
+Build and run:
+    pio run -e native_queue_benchmark
+    .pio/build/native_queue_benchmark/program [items] [rounds]
+*/
+#include <SpscQueue.h>
+#include <ThreadSafeQueue.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+// Roughly the size of a received radio fragment
+struct item_t {
+    uint32_t seq;
+    uint8_t payload[36];
+};
+
+template <typename Push, typename Pop>
+static bool run(const char* name, const uint32_t items, Push push, Pop pop)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // Set by the consumer on a failed verification, the queue may stay full then
+    std::atomic<bool> stop { false };
+
+    std::thread producer([&]() {
+        item_t item = {};
+        for (uint32_t i = 0; i < items; i++) {
+            item.seq = i;
+            item.payload[0] = static_cast<uint8_t>(i);
+            while (!push(item)) {
+                if (stop) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    bool ok = true;
+    uint32_t expected = 0;
+    while (expected < items) {
+        const auto item = pop();
+        if (!item) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item->seq != expected || item->payload[0] != static_cast<uint8_t>(expected)) {
+            fprintf(stderr, "%s: expected item %u, got %u\n", name, expected, item->seq);
+            ok = false;
+            stop = true;
+            break;
+        }
+        expected++;
+    }
+
+    producer.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-16s %u items, %.3f s (%.0f items/s)%s\n", name, items, seconds, items / seconds, ok ? "" : " FAILED");
+
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t items = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000000;
+    const uint32_t rounds = argc > 2 ? strtoul(argv[2], nullptr, 10) : 3;
+
+    bool ok = true;
+    for (uint32_t r = 0; r < rounds; r++) {
+        // Small capacity to exercise the full and empty paths as often as possible
+        SpscQueue<item_t, 32> spsc;
+        ok &= run("SpscQueue", items, [&](const item_t& i) { return spsc.push(i); }, [&]() { return spsc.pop(); });
+
+        ThreadSafeQueue<item_t> mutexQueue;
+        auto mutexPush = [&](const item_t& i) {
+            // Same bound as above, the queue itself is unbounded
+            if (mutexQueue.size() >= 32) {
+                return false;
+            }
+            mutexQueue.push(i);
+            return true;
+        };
+        ok &= run("ThreadSafeQueue", items, mutexPush, [&]() { return mutexQueue.pop(); });
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+// Fixed capacity queue for exactly one producer and one consumer.
+// Does not allocate and does not lock, so push() may be called from an
+// interrupt while pop() is called from a task (or the other way round).
+// Capacity has to be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+
+public:
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue<T, Capacity>&) = delete;
+    SpscQueue& operator=(const SpscQueue<T, Capacity>&) = delete;
+
+    // Producer side. Returns false and drops the item if the queue is full.
+    bool push(const T& item)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= Capacity) {
+            return false;
+        }
+        _buffer[head & (Capacity - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    std::optional<T> pop()
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return {};
+        }
+        T tmp = _buffer[tail & (Capacity - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return tmp;
+    }
+
+    // Consumer side. Removes all items.
+    void clear()
+    {
+        _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Exact if called from the producer or consumer, a snapshot otherwise
+    size_t size() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    bool full() const
+    {
+        return size() >= Capacity;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return Capacity;
+    }
+
+private:
+    std::array<T, Capacity> _buffer = {};
+
+    // Both indices increase monotonically and wrap around at SIZE_MAX.
+    // head is only written by the producer, tail only by the consumer.
+    std::atomic<size_t> _head { 0 };
+    std::atomic<size_t> _tail { 0 };
+};
@@ -0,0 +1,18 @@
+# Runs the native replay tool against the fixture recording after linking and
+# fails the build if the decoded values differ from the expected ones.
+# (see lib/Hoymiles/examples/native_replay)
+
+Import("env")
+
+from os.path import join
+
+fixtures = join(env.subst("$PROJECT_DIR"), "lib", "Hoymiles", "examples", "native_replay", "fixtures")
+
+env.AddPostAction("$PROGPATH", env.VerboseAction(" ".join([
+    '"$PROGPATH"',
+    '"%s"' % join(fixtures, "hm600.log"),
+    "114123451998",  # inverter serial
+    "1",  # inverter count
+    "20",  # polls
+    '"%s"' % join(fixtures, "hm600.expected"),
+]), "Checking decoded values of the replay fixture"))
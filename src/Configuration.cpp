@@ -8,17 +8,119 @@
 #include "defaults.h"
 #include <ArduinoJson.h>
 #include <LittleFS.h>
+#include <atomic>
+#include <cstddef>
 #include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <memory>
+#include <new>
+#include <utility>
 #include <nvs_flash.h>
 
 #undef TAG
 static const char* TAG = "configuration";
 
-CONFIG_T config;
+// Readers use the published buffer, writers edit the other one and publish it afterwards
+static CONFIG_T sConfig[2];
+static std::atomic<CONFIG_T*> sCurrent { &sConfig[0] };
 
-static std::condition_variable sWriterCv;
+// Serializes the writers
 static std::mutex sWriterMutex;
-static unsigned sWriterCount = 0;
+
+// Number of publishes and the number the scheduler passed since. The previous
+// buffer is not reused until the scheduler passed the last publish.
+static std::atomic<uint32_t> sPublished { 0 };
+static std::atomic<uint32_t> sQuiescent { 0 };
+static std::condition_variable sQuiescentCv;
+static std::mutex sQuiescentMutex;
+static TaskHandle_t sSchedulerTask = nullptr;
+
+#define CONFIG_IMAGE_MAGIC 0x4746434fUL // "OCFG"
+
+struct ConfigImageHeader_t {
+    uint32_t Magic;
+    uint32_t Layout;
+    uint32_t Size;
+    uint32_t Crc;
+};
+
+// Offset and size of a member, so reordering fields of the same size changes the layout as well
+#define CONFIG_MEMBER(m) offsetof(CONFIG_T, m), sizeof(std::declval<CONFIG_T&>().m)
+#define INVERTER_MEMBER(m) offsetof(INVERTER_CONFIG_T, m), sizeof(std::declval<INVERTER_CONFIG_T&>().m)
+#define CHANNEL_MEMBER(m) offsetof(CHANNEL_CONFIG_T, m), sizeof(std::declval<CHANNEL_CONFIG_T&>().m)
+
+// Changes whenever CONFIG_VERSION or the offset or size of a member of CONFIG_T changes.
+// It does not depend on the firmware build, so an image survives every update which keeps
+// the layout, regardless whether it was flashed by OTA, esptool or pio. An image of a
+// different layout is not loaded, the configuration is imported from CONFIG_FILENAME instead.
+// Bump CONFIG_VERSION for changes which keep all offsets and sizes (e.g. int32_t to float).
+static constexpr uint32_t getConfigLayout()
+{
+    const uint32_t values[] = {
+        CONFIG_VERSION,
+        sizeof(CONFIG_T),
+        CONFIG_MEMBER(Cfg.Version), CONFIG_MEMBER(Cfg.SaveCount),
+
+        CONFIG_MEMBER(WiFi.Ssid), CONFIG_MEMBER(WiFi.Password),
+        CONFIG_MEMBER(WiFi.Ip), CONFIG_MEMBER(WiFi.Netmask), CONFIG_MEMBER(WiFi.Gateway),
+        CONFIG_MEMBER(WiFi.Dns1), CONFIG_MEMBER(WiFi.Dns2), CONFIG_MEMBER(WiFi.Dhcp),
+        CONFIG_MEMBER(WiFi.Hostname), CONFIG_MEMBER(WiFi.ApTimeout),
+
+        CONFIG_MEMBER(Mdns.Enabled),
+
+        CONFIG_MEMBER(Syslog.Enabled), CONFIG_MEMBER(Syslog.Hostname), CONFIG_MEMBER(Syslog.Port),
+
+        CONFIG_MEMBER(Ntp.Server), CONFIG_MEMBER(Ntp.Timezone), CONFIG_MEMBER(Ntp.TimezoneDescr),
+        CONFIG_MEMBER(Ntp.Longitude), CONFIG_MEMBER(Ntp.Latitude), CONFIG_MEMBER(Ntp.SunsetType),
+
+        CONFIG_MEMBER(Mqtt.Enabled), CONFIG_MEMBER(Mqtt.Hostname), CONFIG_MEMBER(Mqtt.Port),
+        CONFIG_MEMBER(Mqtt.ClientId), CONFIG_MEMBER(Mqtt.Username), CONFIG_MEMBER(Mqtt.Password),
+        CONFIG_MEMBER(Mqtt.Topic), CONFIG_MEMBER(Mqtt.Retain), CONFIG_MEMBER(Mqtt.PublishInterval),
+        CONFIG_MEMBER(Mqtt.CleanSession),
+        CONFIG_MEMBER(Mqtt.Lwt.Topic), CONFIG_MEMBER(Mqtt.Lwt.Value_Online),
+        CONFIG_MEMBER(Mqtt.Lwt.Value_Offline), CONFIG_MEMBER(Mqtt.Lwt.Qos),
+        CONFIG_MEMBER(Mqtt.Hass.Enabled), CONFIG_MEMBER(Mqtt.Hass.Retain), CONFIG_MEMBER(Mqtt.Hass.Topic),
+        CONFIG_MEMBER(Mqtt.Hass.IndividualPanels), CONFIG_MEMBER(Mqtt.Hass.Expire),
+        CONFIG_MEMBER(Mqtt.ChangeOnly.Enabled), CONFIG_MEMBER(Mqtt.ChangeOnly.DeadbandSteps),
+        CONFIG_MEMBER(Mqtt.ChangeOnly.DeadbandRelative), CONFIG_MEMBER(Mqtt.ChangeOnly.MaxAge),
+        CONFIG_MEMBER(Mqtt.Aggregated.Format), CONFIG_MEMBER(Mqtt.Aggregated.FieldTopics),
+        CONFIG_MEMBER(Mqtt.Outbox.Budget), CONFIG_MEMBER(Mqtt.Outbox.Coalesce),
+        CONFIG_MEMBER(Mqtt.Tls.Enabled), CONFIG_MEMBER(Mqtt.Tls.RootCaCert), CONFIG_MEMBER(Mqtt.Tls.CertLogin),
+        CONFIG_MEMBER(Mqtt.Tls.ClientCert), CONFIG_MEMBER(Mqtt.Tls.ClientKey),
+
+        CONFIG_MEMBER(Dtu.Serial), CONFIG_MEMBER(Dtu.PollInterval), CONFIG_MEMBER(Dtu.PollAdaptive),
+        CONFIG_MEMBER(Dtu.Nrf.PaLevel),
+        CONFIG_MEMBER(Dtu.Cmt.PaLevel), CONFIG_MEMBER(Dtu.Cmt.Frequency), CONFIG_MEMBER(Dtu.Cmt.CountryMode),
+
+        CONFIG_MEMBER(Security.Password), CONFIG_MEMBER(Security.AllowReadonly),
+
+        CONFIG_MEMBER(Display.PowerSafe), CONFIG_MEMBER(Display.ScreenSaver), CONFIG_MEMBER(Display.Rotation),
+        CONFIG_MEMBER(Display.Contrast), CONFIG_MEMBER(Display.Locale),
+        CONFIG_MEMBER(Display.Diagram.Duration), CONFIG_MEMBER(Display.Diagram.Mode),
+
+        CONFIG_MEMBER(Led_Single), CONFIG_MEMBER(Led_Single[0].Brightness),
+
+        CONFIG_MEMBER(Inverter),
+        INVERTER_MEMBER(Serial), INVERTER_MEMBER(Name), INVERTER_MEMBER(Order),
+        INVERTER_MEMBER(Poll_Enable), INVERTER_MEMBER(Poll_Enable_Night),
+        INVERTER_MEMBER(Command_Enable), INVERTER_MEMBER(Command_Enable_Night),
+        INVERTER_MEMBER(ReachableThreshold), INVERTER_MEMBER(ZeroRuntimeDataIfUnrechable),
+        INVERTER_MEMBER(ZeroYieldDayOnMidnight), INVERTER_MEMBER(ClearEventlogOnMidnight),
+        INVERTER_MEMBER(YieldDayCorrection), INVERTER_MEMBER(channel),
+        CHANNEL_MEMBER(MaxChannelPower), CHANNEL_MEMBER(Name), CHANNEL_MEMBER(YieldTotalOffset),
+
+        CONFIG_MEMBER(Dev_PinMapping),
+
+        CONFIG_MEMBER(Logging.Default), CONFIG_MEMBER(Logging.Modules),
+        CONFIG_MEMBER(Logging.Modules[0].Name), CONFIG_MEMBER(Logging.Modules[0].Level),
+    };
+
+    uint32_t hash = 2166136261UL;
+    for (auto value : values) {
+        hash = (hash ^ value) * 16777619UL;
+    }
+    return hash;
+}
 
 void ConfigurationClass::init(Scheduler& scheduler)
 {
@@ -27,16 +129,86 @@ void ConfigurationClass::init(Scheduler& scheduler)
     _loopTask.setIterations(TASK_FOREVER);
     _loopTask.enable();
 
-    memset(&config, 0x0, sizeof(config));
+    // setup() and the scheduler run in the same task
+    sSchedulerTask = xTaskGetCurrentTaskHandle();
+
+    memset(sConfig, 0x0, sizeof(sConfig));
 }
 
 bool ConfigurationClass::write()
 {
+    // Other writers wait until the image is complete
+    auto guard = getWriteGuard();
+    auto& config = guard.getConfig();
+
+    config.Cfg.SaveCount++;
+
+    ConfigImageHeader_t header;
+    header.Magic = CONFIG_IMAGE_MAGIC;
+    header.Layout = getConfigLayout();
+    header.Size = sizeof(CONFIG_T);
+    header.Crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&config), sizeof(CONFIG_T));
+
+    // The previous image stays valid until the new one is complete
+    File f = LittleFS.open(CONFIG_IMAGE_TMP_FILENAME, "w");
+    if (!f) {
+        return false;
+    }
+
+    const bool success = f.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) == sizeof(header)
+        && f.write(reinterpret_cast<const uint8_t*>(&config), sizeof(CONFIG_T)) == sizeof(CONFIG_T);
+    f.close();
+
+    if (!success || !LittleFS.rename(CONFIG_IMAGE_TMP_FILENAME, CONFIG_IMAGE_FILENAME)) {
+        ESP_LOGE(TAG, "Failed to write %s", CONFIG_IMAGE_FILENAME);
+        LittleFS.remove(CONFIG_IMAGE_TMP_FILENAME);
+        return false;
+    }
+
+    return true;
+}
+
+bool ConfigurationClass::readImage(CONFIG_T& config)
+{
+    File f = LittleFS.open(CONFIG_IMAGE_FILENAME, "r", false);
+    if (!f) {
+        return false;
+    }
+
+    ConfigImageHeader_t header;
+    if (f.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) != sizeof(header)
+        || header.Magic != CONFIG_IMAGE_MAGIC || header.Layout != getConfigLayout() || header.Size != sizeof(CONFIG_T)) {
+        ESP_LOGW(TAG, "Incompatible configuration image");
+        return false;
+    }
+
+    // Read into a copy, so a corrupt image does not touch the current configuration
+    std::unique_ptr<CONFIG_T> image(new (std::nothrow) CONFIG_T);
+    if (!image) {
+        ESP_LOGE(TAG, "Out of memory while reading the configuration image");
+        return false;
+    }
+
+    if (f.read(reinterpret_cast<uint8_t*>(image.get()), sizeof(CONFIG_T)) != sizeof(CONFIG_T)
+        || esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(image.get()), sizeof(CONFIG_T)) != header.Crc) {
+        ESP_LOGW(TAG, "Corrupt configuration image");
+        return false;
+    }
+
+    memcpy(&config, image.get(), sizeof(CONFIG_T));
+    return true;
+}
+
+bool ConfigurationClass::writeJson()
+{
+    // Blocks the writers, so the exported snapshot does not change meanwhile
+    std::lock_guard<std::mutex> lock(sWriterMutex);
+    const CONFIG_T& config = get();
+
     File f = LittleFS.open(CONFIG_FILENAME, "w");
     if (!f) {
         return false;
     }
-    config.Cfg.SaveCount++;
 
     JsonDocument doc;
 
@@ -104,9 +276,24 @@ bool ConfigurationClass::write()
     mqtt_hass["individual_panels"] = config.Mqtt.Hass.IndividualPanels;
     mqtt_hass["expire"] = config.Mqtt.Hass.Expire;
 
+    JsonObject mqtt_change_only = mqtt["change_only"].to<JsonObject>();
+    mqtt_change_only["enabled"] = config.Mqtt.ChangeOnly.Enabled;
+    mqtt_change_only["deadband_steps"] = config.Mqtt.ChangeOnly.DeadbandSteps;
+    mqtt_change_only["deadband_relative"] = config.Mqtt.ChangeOnly.DeadbandRelative;
+    mqtt_change_only["max_age"] = config.Mqtt.ChangeOnly.MaxAge;
+
+    JsonObject mqtt_aggregated = mqtt["aggregated"].to<JsonObject>();
+    mqtt_aggregated["format"] = config.Mqtt.Aggregated.Format;
+    mqtt_aggregated["field_topics"] = config.Mqtt.Aggregated.FieldTopics;
+
+    JsonObject mqtt_outbox = mqtt["outbox"].to<JsonObject>();
+    mqtt_outbox["budget"] = config.Mqtt.Outbox.Budget;
+    mqtt_outbox["coalesce"] = config.Mqtt.Outbox.Coalesce;
+
     JsonObject dtu = doc["dtu"].to<JsonObject>();
     dtu["serial"] = config.Dtu.Serial;
     dtu["poll_interval"] = config.Dtu.PollInterval;
+    dtu["poll_adaptive"] = config.Dtu.PollAdaptive;
     dtu["nrf_pa_level"] = config.Dtu.Nrf.PaLevel;
     dtu["cmt_pa_level"] = config.Dtu.Cmt.PaLevel;
     dtu["cmt_frequency"] = config.Dtu.Cmt.Frequency;
@@ -183,6 +370,45 @@ bool ConfigurationClass::write()
 }
 
 bool ConfigurationClass::read()
+{
+    bool imported = false;
+    uint64_t dtuId = 0;
+
+    {
+        auto guard = getWriteGuard();
+        auto& config = guard.getConfig();
+
+        if (!readImage(config)) {
+            ESP_LOGI(TAG, "Importing configuration from %s", CONFIG_FILENAME);
+            if (!readJson(config)) {
+                return false;
+            }
+            imported = true;
+        }
+
+        // Check for default DTU serial
+        if (config.Dtu.Serial == DTU_SERIAL) {
+            dtuId = Utils::generateDtuSerial();
+            config.Dtu.Serial = dtuId;
+        }
+    }
+
+    if (imported || dtuId != 0) {
+        write();
+    }
+
+    if (dtuId != 0) {
+        ESP_LOGI(TAG, "DTU serial check: Generated new serial based on ESP chip id: %0" PRIx32 "%08" PRIx32 "",
+            static_cast<uint32_t>((dtuId >> 32) & 0xFFFFFFFF),
+            static_cast<uint32_t>(dtuId & 0xFFFFFFFF));
+    } else {
+        ESP_LOGI(TAG, "DTU serial check: Using existing serial");
+    }
+
+    return true;
+}
+
+bool ConfigurationClass::readJson(CONFIG_T& config)
 {
     File f = LittleFS.open(CONFIG_FILENAME, "r", false);
     Utils::skipBom(f);
@@ -294,9 +520,24 @@ bool ConfigurationClass::read()
     config.Mqtt.Hass.IndividualPanels = mqtt_hass["individual_panels"] | MQTT_HASS_INDIVIDUALPANELS;
     strlcpy(config.Mqtt.Hass.Topic, mqtt_hass["topic"] | MQTT_HASS_TOPIC, sizeof(config.Mqtt.Hass.Topic));
 
+    JsonObject mqtt_change_only = mqtt["change_only"];
+    config.Mqtt.ChangeOnly.Enabled = mqtt_change_only["enabled"] | MQTT_CHANGE_ONLY;
+    config.Mqtt.ChangeOnly.DeadbandSteps = mqtt_change_only["deadband_steps"] | MQTT_CHANGE_ONLY_DEADBAND_STEPS;
+    config.Mqtt.ChangeOnly.DeadbandRelative = mqtt_change_only["deadband_relative"] | MQTT_CHANGE_ONLY_DEADBAND_RELATIVE;
+    config.Mqtt.ChangeOnly.MaxAge = mqtt_change_only["max_age"] | MQTT_CHANGE_ONLY_MAX_AGE;
+
+    JsonObject mqtt_aggregated = mqtt["aggregated"];
+    config.Mqtt.Aggregated.Format = mqtt_aggregated["format"] | MQTT_AGGREGATED_FORMAT;
+    config.Mqtt.Aggregated.FieldTopics = mqtt_aggregated["field_topics"] | MQTT_AGGREGATED_FIELD_TOPICS;
+
+    JsonObject mqtt_outbox = mqtt["outbox"];
+    config.Mqtt.Outbox.Budget = mqtt_outbox["budget"] | MQTT_OUTBOX_BUDGET;
+    config.Mqtt.Outbox.Coalesce = mqtt_outbox["coalesce"] | MQTT_OUTBOX_COALESCE;
+
     JsonObject dtu = doc["dtu"];
     config.Dtu.Serial = dtu["serial"] | DTU_SERIAL;
     config.Dtu.PollInterval = dtu["poll_interval"] | DTU_POLL_INTERVAL;
+    config.Dtu.PollAdaptive = dtu["poll_adaptive"] | DTU_POLL_ADAPTIVE;
     config.Dtu.Nrf.PaLevel = dtu["nrf_pa_level"] | DTU_NRF_PA_LEVEL;
     config.Dtu.Cmt.PaLevel = dtu["cmt_pa_level"] | DTU_CMT_PA_LEVEL;
     config.Dtu.Cmt.Frequency = dtu["cmt_frequency"] | DTU_CMT_FREQUENCY;
@@ -360,27 +601,27 @@ bool ConfigurationClass::read()
 
     f.close();
 
-    // Check for default DTU serial
-    if (config.Dtu.Serial == DTU_SERIAL) {
-        const uint64_t dtuId = Utils::generateDtuSerial();
-        config.Dtu.Serial = dtuId;
-        write();
-        ESP_LOGI(TAG, "DTU serial check: Generated new serial based on ESP chip id: %0" PRIx32 "%08" PRIx32 "",
-            static_cast<uint32_t>((dtuId >> 32) & 0xFFFFFFFF),
-            static_cast<uint32_t>(dtuId & 0xFFFFFFFF));
-    } else {
-        ESP_LOGI(TAG, "DTU serial check: Using existing serial");
-    }
-
     return true;
 }
 
 void ConfigurationClass::migrate()
+{
+    {
+        auto guard = getWriteGuard();
+        if (!migrateJson(guard.getConfig())) {
+            return;
+        }
+    }
+
+    write();
+}
+
+bool ConfigurationClass::migrateJson(CONFIG_T& config)
 {
     File f = LittleFS.open(CONFIG_FILENAME, "r", false);
     if (!f) {
         ESP_LOGE(TAG, "Failed to open file, cancel migration");
-        return;
+        return false;
     }
 
     Utils::skipBom(f);
@@ -391,11 +632,11 @@ void ConfigurationClass::migrate()
     const DeserializationError error = deserializeJson(doc, f);
     if (error) {
         ESP_LOGE(TAG, "Failed to read file, cancel migration: %s", error.c_str());
-        return;
+        return false;
     }
 
     if (!Utils::checkJsonAlloc(doc, __FUNCTION__, __LINE__)) {
-        return;
+        return false;
     }
 
     if (config.Cfg.Version < 0x00011700) {
@@ -464,13 +705,12 @@ void ConfigurationClass::migrate()
     f.close();
 
     config.Cfg.Version = CONFIG_VERSION;
-    write();
-    read();
+    return true;
 }
 
-CONFIG_T const& ConfigurationClass::get()
+CONFIG_T const& ConfigurationClass::get() const
 {
-    return config;
+    return *sCurrent.load(std::memory_order_acquire);
 }
 
 ConfigurationClass::WriteGuard ConfigurationClass::getWriteGuard()
@@ -478,8 +718,10 @@ ConfigurationClass::WriteGuard ConfigurationClass::getWriteGuard()
     return WriteGuard();
 }
 
-INVERTER_CONFIG_T* ConfigurationClass::getFreeInverterSlot()
+INVERTER_CONFIG_T* ConfigurationClass::WriteGuard::getFreeInverterSlot()
 {
+    CONFIG_T& config = *_config;
+
     for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
         if (config.Inverter[i].Serial == 0) {
             return &config.Inverter[i];
@@ -489,8 +731,10 @@ INVERTER_CONFIG_T* ConfigurationClass::getFreeInverterSlot()
     return nullptr;
 }
 
-INVERTER_CONFIG_T* ConfigurationClass::getInverterConfig(const uint64_t serial)
+const INVERTER_CONFIG_T* ConfigurationClass::getInverterConfig(const uint64_t serial) const
 {
+    const CONFIG_T& config = get();
+
     for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
         if (config.Inverter[i].Serial == serial) {
             return &config.Inverter[i];
@@ -500,8 +744,10 @@ INVERTER_CONFIG_T* ConfigurationClass::getInverterConfig(const uint64_t serial)
     return nullptr;
 }
 
-void ConfigurationClass::deleteInverterById(const uint8_t id)
+void ConfigurationClass::WriteGuard::deleteInverterById(const uint8_t id)
 {
+    CONFIG_T& config = *_config;
+
     config.Inverter[id].Serial = 0ULL;
     strlcpy(config.Inverter[id].Name, "", sizeof(config.Inverter[id].Name));
     config.Inverter[id].Order = 0;
@@ -524,6 +770,8 @@ void ConfigurationClass::deleteInverterById(const uint8_t id)
 
 int8_t ConfigurationClass::getIndexForLogModule(const String& moduleName) const
 {
+    const CONFIG_T& config = get();
+
     for (uint8_t i = 0; i < LOG_MODULE_COUNT; i++) {
         if (strcmp(config.Logging.Modules[i].Name, moduleName.c_str()) == 0) {
             return i;
@@ -535,33 +783,42 @@ int8_t ConfigurationClass::getIndexForLogModule(const String& moduleName) const
 
 void ConfigurationClass::loop()
 {
-    std::unique_lock<std::mutex> lock(sWriterMutex);
-    if (sWriterCount == 0) {
+    // Readers of the scheduler are done with the previous buffer now
+    const uint32_t published = sPublished.load();
+    if (sQuiescent.load() == published) {
         return;
     }
 
-    sWriterCv.notify_all();
-    sWriterCv.wait(lock, [] { return sWriterCount == 0; });
+    {
+        std::lock_guard<std::mutex> lock(sQuiescentMutex);
+        sQuiescent = published;
+    }
+    sQuiescentCv.notify_all();
 }
 
-CONFIG_T& ConfigurationClass::WriteGuard::getConfig()
+ConfigurationClass::WriteGuard::WriteGuard()
+    : _lock(sWriterMutex)
 {
-    return config;
+    // The scheduler itself is not reading while it writes
+    if (xTaskGetCurrentTaskHandle() != sSchedulerTask) {
+        std::unique_lock<std::mutex> lock(sQuiescentMutex);
+        sQuiescentCv.wait(lock, [] { return sQuiescent.load() == sPublished.load(); });
+    }
+
+    const CONFIG_T* current = sCurrent.load(std::memory_order_acquire);
+    _config = current == &sConfig[0] ? &sConfig[1] : &sConfig[0];
+    memcpy(_config, current, sizeof(CONFIG_T));
 }
 
-ConfigurationClass::WriteGuard::WriteGuard()
-    : _lock(sWriterMutex)
+CONFIG_T& ConfigurationClass::WriteGuard::getConfig()
 {
-    sWriterCount++;
-    sWriterCv.wait(_lock);
+    return *_config;
 }
 
 ConfigurationClass::WriteGuard::~WriteGuard()
 {
-    sWriterCount--;
-    if (sWriterCount == 0) {
-        sWriterCv.notify_all();
-    }
+    sCurrent.store(_config, std::memory_order_release);
+    sPublished++;
 }
 
 ConfigurationClass Configuration;
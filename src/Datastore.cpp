@@ -1,6 +1,6 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 /*
- * Copyright (C) 2023-2024 Thomas Basler and others
+ * Copyright (C) 2023-2025 Thomas Basler and others
  */
 #include "Datastore.h"
 #include "Configuration.h"
@@ -15,17 +15,99 @@ DatastoreClass::DatastoreClass()
 
 void DatastoreClass::init(Scheduler& scheduler)
 {
+    Hoymiles.registerInverterUpdateCallback(std::bind(&DatastoreClass::onInverterUpdate, this, std::placeholders::_1));
+
+    // Inverters added before the callback was registered
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        if (inv != nullptr) {
+            onInverterUpdate(inv->serial());
+        }
+    }
+
     scheduler.addTask(_loopTask);
     _loopTask.enable();
 }
 
+void DatastoreClass::onInverterUpdate(const uint64_t serial)
+{
+    // Can be called from any task. Only remember the inverter, the work is done in the loop
+    std::lock_guard<std::mutex> lock(_dirtyMutex);
+    _dirtyInverters.insert(serial);
+}
+
 void DatastoreClass::loop()
 {
-    if (!Hoymiles.isAllRadioIdle()) {
-        _loopTask.forceNextIteration();
+    std::set<uint64_t> dirtyInverters;
+    {
+        std::lock_guard<std::mutex> lock(_dirtyMutex);
+        dirtyInverters.swap(_dirtyInverters);
+    }
+
+    if (dirtyInverters.empty()) {
+        return;
+    }
+
+    for (auto serial : dirtyInverters) {
+        updateContribution(serial);
+    }
+
+    updateTotals();
+}
+
+void DatastoreClass::updateContribution(const uint64_t serial)
+{
+    auto inv = Hoymiles.getInverterBySerial(serial);
+    auto cfg = Configuration.getInverterConfig(serial);
+    if (inv == nullptr || cfg == nullptr) {
+        _contributions.erase(serial);
         return;
     }
 
+    InverterContribution_t c = {};
+
+    c.isPollEnabled = inv->getEnablePolling();
+    c.isProducing = inv->isProducing();
+    c.isReachable = inv->isReachable();
+
+    // All values of the same frame
+    auto stats = inv->Statistics();
+    stats->getFieldValues(_fieldValues);
+
+    for (auto& ch : stats->getChannelsByType(TYPE_INV)) {
+        if (cfg->Poll_Enable) {
+            c.acYieldTotal += stats->getChannelFieldValue(_fieldValues, TYPE_INV, ch, FLD_YT);
+            c.acYieldDay += stats->getChannelFieldValue(_fieldValues, TYPE_INV, ch, FLD_YD);
+
+            c.acYieldTotalDigits = max<unsigned int>(c.acYieldTotalDigits, stats->getChannelFieldDigits(TYPE_INV, ch, FLD_YT));
+            c.acYieldDayDigits = max<unsigned int>(c.acYieldDayDigits, stats->getChannelFieldDigits(TYPE_INV, ch, FLD_YD));
+        }
+    }
+
+    for (auto& ch : stats->getChannelsByType(TYPE_AC)) {
+        if (c.isPollEnabled) {
+            c.acPower += stats->getChannelFieldValue(_fieldValues, TYPE_AC, ch, FLD_PAC);
+            c.acPowerDigits = max<unsigned int>(c.acPowerDigits, stats->getChannelFieldDigits(TYPE_AC, ch, FLD_PAC));
+        }
+    }
+
+    for (auto& ch : stats->getChannelsByType(TYPE_DC)) {
+        if (c.isPollEnabled) {
+            c.dcPower += stats->getChannelFieldValue(_fieldValues, TYPE_DC, ch, FLD_PDC);
+            c.dcPowerDigits = max<unsigned int>(c.dcPowerDigits, stats->getChannelFieldDigits(TYPE_DC, ch, FLD_PDC));
+
+            if (stats->getStringMaxPower(ch) > 0) {
+                c.dcPowerIrradiation += stats->getChannelFieldValue(_fieldValues, TYPE_DC, ch, FLD_PDC);
+                c.dcIrradiationInstalled += stats->getStringMaxPower(ch);
+            }
+        }
+    }
+
+    _contributions[serial] = c;
+}
+
+void DatastoreClass::updateTotals()
+{
     uint8_t isProducing = 0;
     uint8_t isReachable = 0;
     uint8_t pollEnabledCount = 0;
@@ -50,65 +132,34 @@ void DatastoreClass::loop()
     _isAllEnabledProducing = true;
     _isAllEnabledReachable = true;
 
-    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-        auto inv = Hoymiles.getInverterByPos(i);
-        if (inv == nullptr) {
-            continue;
-        }
-
-        auto cfg = Configuration.getInverterConfig(inv->serial());
-        if (cfg == nullptr) {
-            continue;
-        }
-
-        if (inv->getEnablePolling()) {
+    for (auto& [serial, c] : _contributions) {
+        if (c.isPollEnabled) {
             pollEnabledCount++;
         }
 
-        if (inv->isProducing()) {
+        if (c.isProducing) {
             isProducing++;
-        } else {
-            if (inv->getEnablePolling()) {
-                _isAllEnabledProducing = false;
-            }
+        } else if (c.isPollEnabled) {
+            _isAllEnabledProducing = false;
         }
 
-        if (inv->isReachable()) {
+        if (c.isReachable) {
             isReachable++;
-        } else {
-            if (inv->getEnablePolling()) {
-                _isAllEnabledReachable = false;
-            }
+        } else if (c.isPollEnabled) {
+            _isAllEnabledReachable = false;
         }
 
-        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_INV)) {
-            if (cfg->Poll_Enable) {
-                _totalAcYieldTotalEnabled += inv->Statistics()->getChannelFieldValue(TYPE_INV, c, FLD_YT);
-                _totalAcYieldDayEnabled += inv->Statistics()->getChannelFieldValue(TYPE_INV, c, FLD_YD);
-
-                _totalAcYieldTotalDigits = max<unsigned int>(_totalAcYieldTotalDigits, inv->Statistics()->getChannelFieldDigits(TYPE_INV, c, FLD_YT));
-                _totalAcYieldDayDigits = max<unsigned int>(_totalAcYieldDayDigits, inv->Statistics()->getChannelFieldDigits(TYPE_INV, c, FLD_YD));
-            }
-        }
-
-        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_AC)) {
-            if (inv->getEnablePolling()) {
-                _totalAcPowerEnabled += inv->Statistics()->getChannelFieldValue(TYPE_AC, c, FLD_PAC);
-                _totalAcPowerDigits = max<unsigned int>(_totalAcPowerDigits, inv->Statistics()->getChannelFieldDigits(TYPE_AC, c, FLD_PAC));
-            }
-        }
-
-        for (auto& c : inv->Statistics()->getChannelsByType(TYPE_DC)) {
-            if (inv->getEnablePolling()) {
-                _totalDcPowerEnabled += inv->Statistics()->getChannelFieldValue(TYPE_DC, c, FLD_PDC);
-                _totalDcPowerDigits = max<unsigned int>(_totalDcPowerDigits, inv->Statistics()->getChannelFieldDigits(TYPE_DC, c, FLD_PDC));
-
-                if (inv->Statistics()->getStringMaxPower(c) > 0) {
-                    _totalDcPowerIrradiation += inv->Statistics()->getChannelFieldValue(TYPE_DC, c, FLD_PDC);
-                    _totalDcIrradiationInstalled += inv->Statistics()->getStringMaxPower(c);
-                }
-            }
-        }
+        _totalAcYieldTotalEnabled += c.acYieldTotal;
+        _totalAcYieldDayEnabled += c.acYieldDay;
+        _totalAcPowerEnabled += c.acPower;
+        _totalDcPowerEnabled += c.dcPower;
+        _totalDcPowerIrradiation += c.dcPowerIrradiation;
+        _totalDcIrradiationInstalled += c.dcIrradiationInstalled;
+
+        _totalAcYieldTotalDigits = max<unsigned int>(_totalAcYieldTotalDigits, c.acYieldTotalDigits);
+        _totalAcYieldDayDigits = max<unsigned int>(_totalAcYieldDayDigits, c.acYieldDayDigits);
+        _totalAcPowerDigits = max<unsigned int>(_totalAcPowerDigits, c.acPowerDigits);
+        _totalDcPowerDigits = max<unsigned int>(_totalDcPowerDigits, c.dcPowerDigits);
     }
 
     _isAtLeastOneProducing = isProducing > 0;
@@ -116,6 +167,8 @@ void DatastoreClass::loop()
     _isAtLeastOnePollEnabled = pollEnabledCount > 0;
 
     _totalDcIrradiation = _totalDcIrradiationInstalled > 0 ? _totalDcPowerIrradiation / _totalDcIrradiationInstalled * 100.0f : 0;
+
+    _generation++;
 }
 
 float DatastoreClass::getTotalAcYieldTotalEnabled()
@@ -213,3 +266,8 @@ bool DatastoreClass::getIsAtLeastOnePollEnabled()
     std::lock_guard<std::mutex> lock(_mutex);
     return _isAtLeastOnePollEnabled;
 }
+
+uint32_t DatastoreClass::getGeneration() const
+{
+    return _generation;
+}
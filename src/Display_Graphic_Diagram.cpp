@@ -1,10 +1,12 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 /*
- * Copyright (C) 2023-2024 Thomas Basler and others
+ * Copyright (C) 2023-2025 Thomas Basler and others
  */
 #include "Display_Graphic_Diagram.h"
 #include "Configuration.h"
 #include "Datastore.h"
+#include "History.h"
+#include <Hoymiles.h>
 #include <algorithm>
 
 DisplayGraphicDiagramClass::DisplayGraphicDiagramClass()
@@ -21,12 +23,21 @@ void DisplayGraphicDiagramClass::init(Scheduler& scheduler, U8G2* display)
     _averageTask.enable();
 
     scheduler.addTask(_dataPointTask);
-    updatePeriod();
+    applyPeriod();
     _dataPointTask.enable();
 }
 
 void DisplayGraphicDiagramClass::averageLoop()
 {
+    if (_periodChanged.exchange(false)) {
+        applyPeriod();
+    }
+
+    struct tm timeinfo;
+    if (!_seeded && getLocalTime(&timeinfo, 5)) {
+        seedFromHistory(std::time(nullptr));
+    }
+
     const float currentWatts = Datastore.getTotalAcPowerEnabled(); // get the current AC production
     _iRunningAverage += currentWatts;
     _iRunningAverageCnt++;
@@ -34,34 +45,146 @@ void DisplayGraphicDiagramClass::averageLoop()
 
 void DisplayGraphicDiagramClass::dataPointLoop()
 {
-    if (_graphValuesCount >= std::size(_graphValues)) {
-        for (uint8_t i = 0; i < std::size(_graphValues) - 1; i++) {
-            _graphValues[i] = _graphValues[i + 1];
-        }
-        _graphValuesCount = std::size(_graphValues) - 1;
+    if (_periodChanged.exchange(false)) {
+        applyPeriod();
     }
+
     if (_iRunningAverageCnt != 0) {
-        _graphValues[_graphValuesCount++] = _iRunningAverage / _iRunningAverageCnt;
+        addGraphValue(_iRunningAverage / _iRunningAverageCnt);
         _iRunningAverage = 0;
         _iRunningAverageCnt = 0;
     }
 }
 
-uint32_t DisplayGraphicDiagramClass::getSecondsPerDot()
+void DisplayGraphicDiagramClass::addGraphValue(const float value)
 {
-    return Configuration.get().Display.Diagram.Duration / _chartWidth;
+    if (_graphValuesCount < MAX_DATAPOINTS) {
+        _graphValues[(_graphValuesHead + _graphValuesCount++) % MAX_DATAPOINTS] = value;
+        _graphValuesMax = std::max(_graphValuesMax, value);
+        return;
+    }
+
+    // Replace the oldest value. The maximum only has to be searched if it was removed.
+    const float removed = _graphValues[_graphValuesHead];
+    _graphValues[_graphValuesHead] = value;
+    _graphValuesHead = (_graphValuesHead + 1) % MAX_DATAPOINTS;
+
+    if (value >= _graphValuesMax) {
+        _graphValuesMax = value;
+    } else if (removed >= _graphValuesMax) {
+        _graphValuesMax = std::max(0.0f, *std::max_element(_graphValues.begin(), _graphValues.end()));
+    }
+}
+
+float DisplayGraphicDiagramClass::getGraphValue(const uint8_t index) const
+{
+    return _graphValues[(_graphValuesHead + index) % MAX_DATAPOINTS];
+}
+
+void DisplayGraphicDiagramClass::seedFromHistory(const uint32_t now)
+{
+    if (_seedInverter == 0) {
+        _seedPeriod = getSecondsPerValue();
+        _seedSlots = MAX_DATAPOINTS - _graphValuesCount;
+        if (_seedPeriod == 0 || _seedSlots == 0) {
+            _seeded = true;
+            return;
+        }
+
+        // The slots end where the existing data points start
+        _seedStart = now - (_graphValuesCount + _seedSlots) * _seedPeriod;
+        _seedTotals.fill(0);
+        _seedPresent.fill(false);
+
+        History.flush();
+    }
+
+    if (_seedInverter < Hoymiles.getNumInverters()) {
+        auto inv = Hoymiles.getInverterByPos(_seedInverter++);
+        if (!inv->getEnablePolling()) {
+            return;
+        }
+
+        std::array<float, MAX_DATAPOINTS> sums = {};
+        std::array<uint16_t, MAX_DATAPOINTS> counts = {};
+
+        HistoryReader reader(History.getStore(), inv->serial(), _seedStart, _seedStart + _seedSlots * _seedPeriod - 1);
+        HistorySample_t sample;
+        while (reader.next(sample)) {
+            const uint8_t slot = (sample.Time - _seedStart) / _seedPeriod;
+            sums[slot] += sample.Values[0] * HistoryClass::getSeriesScale(0);
+            counts[slot]++;
+        }
+
+        for (uint8_t slot = 0; slot < _seedSlots; slot++) {
+            if (counts[slot] > 0) {
+                _seedTotals[slot] += sums[slot] / counts[slot];
+                _seedPresent[slot] = true;
+            }
+        }
+        return;
+    }
+
+    _seeded = true;
+    _seedInverter = 0;
+
+    // Like the live data points, the diagram starts with the first slot which has data
+    uint8_t first = 0;
+    while (first < _seedSlots && !_seedPresent[first]) {
+        first++;
+    }
+    if (first == _seedSlots) {
+        return;
+    }
+
+    // Data points added while the history was read are kept, the oldest
+    // seeded ones are dropped if they do not fit anymore
+    std::array<float, MAX_DATAPOINTS> existing;
+    const uint8_t existingCount = _graphValuesCount;
+    for (uint8_t i = 0; i < existingCount; i++) {
+        existing[i] = getGraphValue(i);
+    }
+
+    _graphValuesHead = 0;
+    _graphValuesCount = 0;
+    _graphValuesMax = 0;
+
+    for (uint8_t slot = first; slot < _seedSlots; slot++) {
+        addGraphValue(_seedTotals[slot]);
+    }
+    for (uint8_t i = 0; i < existingCount; i++) {
+        addGraphValue(existing[i]);
+    }
+}
+
+uint32_t DisplayGraphicDiagramClass::getSecondsPerValue()
+{
+    return Configuration.get().Display.Diagram.Duration / MAX_DATAPOINTS;
 }
 
 void DisplayGraphicDiagramClass::updatePeriod()
+{
+    // Called by the web server, the data points are only accessed by the loops
+    _periodChanged = true;
+}
+
+void DisplayGraphicDiagramClass::applyPeriod()
 {
     //  Calculate seconds per datapoint
     _dataPointTask.setInterval(Configuration.get().Display.Diagram.Duration * TASK_SECOND / MAX_DATAPOINTS);
+
+    // The existing data points belong to the previous period
+    _graphValuesHead = 0;
+    _graphValuesCount = 0;
+    _graphValuesMax = 0;
+    _iRunningAverage = 0;
+    _iRunningAverageCnt = 0;
+    _seeded = false;
+    _seedInverter = 0;
 }
 
 void DisplayGraphicDiagramClass::redraw(uint8_t screenSaverOffsetX, uint8_t xPos, uint8_t yPos, uint8_t width, uint8_t height, bool isFullscreen)
 {
-    _chartWidth = width;
-
     // screenSaverOffsetX expected to be in range 0..6
     const uint8_t graphPosX = xPos + ((screenSaverOffsetX > 3) ? 1 : 0);
     const uint8_t graphPosY = yPos + ((screenSaverOffsetX > 3) ? 1 : 0);
@@ -83,7 +206,7 @@ void DisplayGraphicDiagramClass::redraw(uint8_t screenSaverOffsetX, uint8_t xPos
 
     // draw AC value
     char fmtText[7];
-    const float maxWatts = *std::max_element(_graphValues.begin(), _graphValues.end());
+    const float maxWatts = _graphValuesMax;
     if (maxWatts > 999) {
         snprintf(fmtText, sizeof(fmtText), "%2.1fkW", maxWatts / 1000);
     } else {
@@ -103,7 +226,6 @@ void DisplayGraphicDiagramClass::redraw(uint8_t screenSaverOffsetX, uint8_t xPos
 
     // draw chart
     const float scaleFactorY = maxWatts / static_cast<float>(height);
-    const float scaleFactorX = static_cast<float>(MAX_DATAPOINTS) / static_cast<float>(_chartWidth);
 
     if (maxWatts > 0 && isFullscreen) {
         // draw y axis ticks
@@ -117,20 +239,54 @@ void DisplayGraphicDiagramClass::redraw(uint8_t screenSaverOffsetX, uint8_t xPos
         }
     }
 
-    uint8_t xAxisTicks = 1;
-    for (uint8_t i = 1; i < _graphValuesCount; i++) {
-        // draw one tick per hour to the x-axis
-        if (i * getSecondsPerDot() > (3600u * xAxisTicks)) {
-            _display->drawPixel((graphPosX + 1 + i) * scaleFactorX, graphPosY + height);
-            xAxisTicks++;
-        }
+    // draw one tick per hour to the x-axis
+    const uint32_t secondsPerValue = getSecondsPerValue();
+    for (uint32_t tick = 3600; secondsPerValue > 0 && tick < _graphValuesCount * secondsPerValue; tick += 3600) {
+        _display->drawPixel(graphPosX + tick / secondsPerValue * width / MAX_DATAPOINTS, graphPosY + height);
+    }
+
+    if (scaleFactorY == 0 || width == 0) {
+        return;
+    }
 
-        if (scaleFactorY == 0 || scaleFactorX == 0) {
+    auto toY = [&](const float value) -> uint8_t {
+        return horizontal_line_y - std::max<int16_t>(0, value / scaleFactorY - 0.5);
+    };
+
+    // The full period is spread over the width. If a column covers several data points
+    // their minimum and maximum are drawn, so peaks are not lost by the decimation.
+    // Columns without data points (width > MAX_DATAPOINTS) are bridged by a line.
+    uint8_t index = 0;
+    bool hasPrevious = false;
+    uint8_t previousX = 0;
+    uint8_t previousY = 0;
+
+    for (uint8_t column = 0; column < width && index < _graphValuesCount; column++) {
+        const uint8_t end = std::min<uint16_t>((column + 1) * MAX_DATAPOINTS / width, _graphValuesCount);
+        if (index >= end) {
             continue;
         }
 
-        _display->drawLine(
-            graphPosX + (i - 1) / scaleFactorX, horizontal_line_y - std::max<int16_t>(0, _graphValues[i - 1] / scaleFactorY - 0.5),
-            graphPosX + i / scaleFactorX, horizontal_line_y - std::max<int16_t>(0, _graphValues[i] / scaleFactorY - 0.5));
+        const float first = getGraphValue(index);
+        float min = first;
+        float max = first;
+        float last = first;
+        for (; index < end; index++) {
+            last = getGraphValue(index);
+            min = std::min(min, last);
+            max = std::max(max, last);
+        }
+
+        const uint8_t x = graphPosX + column;
+        if (hasPrevious) {
+            _display->drawLine(previousX, previousY, x, toY(first));
+        }
+        if (max > min) {
+            _display->drawVLine(x, toY(max), toY(min) - toY(max) + 1);
+        }
+
+        hasPrevious = true;
+        previousX = x;
+        previousY = toY(last);
     }
 }
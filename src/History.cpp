@@ -0,0 +1,379 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "History.h"
+#include "Datastore.h"
+#include <Hoymiles.h>
+#include <LittleFS.h>
+#include <algorithm>
+#include <cmath>
+#include <esp_rom_crc.h>
+
+#undef TAG
+static const char* TAG = "history";
+
+#define HISTORY_PATH "/littlefs/history"
+#define HISTORY_ROLLUP_PATH HISTORY_PATH "/rollup.bin"
+#define HISTORY_ROLLUP_TMP_PATH HISTORY_PATH "/rollup.tmp"
+#define HISTORY_ROLLUP_VERSION 3U
+
+#define HISTORY_LOOP_INTERVAL (5 * TASK_SECOND)
+#define HISTORY_SAMPLE_INTERVAL 60U
+#define HISTORY_SAVE_INTERVAL (15 * 60 * 1000)
+
+// The rollups are updated at most once per loop and average up to UINT16_MAX samples per bucket
+static_assert(24 * 60 * 60 * TASK_SECOND / HISTORY_LOOP_INTERVAL <= UINT16_MAX, "Loop too fast for the daily rollup");
+
+// Part of the file system which may be used by the history
+#define HISTORY_FS_RATIO 4
+
+HistoryClass History;
+
+HistoryClass::HistoryClass()
+    : _loopTask(HISTORY_LOOP_INTERVAL, TASK_FOREVER, std::bind(&HistoryClass::loop, this))
+{
+}
+
+void HistoryClass::init(Scheduler& scheduler)
+{
+    const uint32_t maxSegments = LittleFS.totalBytes() / HISTORY_FS_RATIO / HISTORY_SEGMENT_SIZE;
+
+    _available = _store.begin(HISTORY_PATH, maxSegments);
+    if (!_available) {
+        ESP_LOGE(TAG, "Failed to open %s", HISTORY_PATH);
+        return;
+    }
+
+    ESP_LOGI(TAG, "%" PRIu32 " of %" PRIu32 " segments in use", _store.getSegmentCount(), maxSegments);
+
+    loadRollups();
+
+    scheduler.addTask(_loopTask);
+    _loopTask.enable();
+}
+
+// Difference between local time and UTC in seconds
+static int32_t getUtcOffset(const time_t now)
+{
+    struct tm local;
+    struct tm utc;
+    localtime_r(&now, &local);
+    gmtime_r(&now, &utc);
+
+    int32_t offset = (local.tm_hour - utc.tm_hour) * 3600 + (local.tm_min - utc.tm_min) * 60;
+    if (local.tm_year != utc.tm_year) {
+        offset += local.tm_year > utc.tm_year ? 86400 : -86400;
+    } else if (local.tm_yday != utc.tm_yday) {
+        offset += local.tm_yday > utc.tm_yday ? 86400 : -86400;
+    }
+    return offset;
+}
+
+void HistoryClass::loop()
+{
+    struct tm timeinfo;
+    if (!getLocalTime(&timeinfo, 5)) {
+        return;
+    }
+    const uint32_t now = std::time(nullptr);
+    const int32_t utcOffset = getUtcOffset(now);
+
+    const bool sample = now - _lastSample >= HISTORY_SAMPLE_INTERVAL;
+    if (sample) {
+        _lastSample = now;
+    }
+
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        const uint32_t lastUpdate = inv->Statistics()->getLastUpdate();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto& state = _inverters[inv->serial()];
+
+            // Every statistics update goes into the rollups
+            if (lastUpdate > 0 && lastUpdate != state.LastUpdate) {
+                state.LastUpdate = lastUpdate;
+                state.Updated = true;
+                state.Rollup.add(now, utcOffset, inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC));
+            }
+
+            // Only sample inverters which sent new statistics since the last sample
+            if (!sample || !state.Updated) {
+                continue;
+            }
+            state.Updated = false;
+        }
+
+        addSample(inv->serial(), now);
+    }
+
+    const uint32_t generation = Datastore.getGeneration();
+    if (generation != _totalsGeneration) {
+        _totalsGeneration = generation;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _totals.add(now, utcOffset, Datastore.getTotalAcPowerEnabled());
+    }
+
+    if (millis() - _lastSave > HISTORY_SAVE_INTERVAL) {
+        save();
+    }
+}
+
+void HistoryClass::addSample(const uint64_t serial, const uint32_t time)
+{
+    auto inv = Hoymiles.getInverterBySerial(serial);
+    if (inv == nullptr) {
+        return;
+    }
+
+    // All values of the same frame
+    auto stats = inv->Statistics();
+    stats->getFieldValues(_fieldValues);
+
+    HistorySample_t sample = {};
+    sample.Time = time;
+    sample.Values[0] = lround(stats->getChannelFieldValue(_fieldValues, TYPE_AC, CH0, FLD_PAC) * 10);
+    sample.Values[1] = lround(stats->getChannelFieldValue(_fieldValues, TYPE_INV, CH0, FLD_YD));
+    sample.Values[2] = lround(stats->getChannelFieldValue(_fieldValues, TYPE_INV, CH0, FLD_YT) * 1000);
+    sample.Count = 3;
+
+    for (auto& c : stats->getChannelsByType(TYPE_DC)) {
+        if (sample.Count + 2 > HISTORY_MAX_SERIES) {
+            break;
+        }
+        sample.Values[sample.Count++] = lround(stats->getChannelFieldValue(_fieldValues, TYPE_DC, c, FLD_PDC) * 10);
+        sample.Values[sample.Count++] = lround(stats->getChannelFieldValue(_fieldValues, TYPE_DC, c, FLD_YD));
+    }
+
+    if (!_store.append(serial, sample)) {
+        ESP_LOGD(TAG, "Sample of %s not stored", inv->serialString().c_str());
+    }
+}
+
+void HistoryClass::flush()
+{
+    if (!_available) {
+        return;
+    }
+
+    _store.flush();
+}
+
+void HistoryClass::save()
+{
+    if (!_available) {
+        return;
+    }
+
+    _store.flush();
+    saveRollups();
+    _lastSave = millis();
+}
+
+void HistoryClass::close()
+{
+    _loopTask.disable();
+    _available = false;
+}
+
+// rollup.bin: header, count * (uint64 serial, rollup). The CRC covers everything
+// behind the header. Written to a temporary file which replaces the previous one,
+// so a power loss keeps the previous state.
+struct HistoryRollupHeader_t {
+    uint8_t Magic[4]; // 'H' 'R' version reserved
+    uint32_t Size; // of one rollup
+    uint32_t Count;
+    uint32_t Crc;
+};
+
+void HistoryClass::loadRollups()
+{
+    FILE* file = fopen(HISTORY_ROLLUP_PATH, "rb");
+    if (file == nullptr) {
+        return;
+    }
+
+    HistoryRollupHeader_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1
+        || header.Magic[0] != 'H' || header.Magic[1] != 'R' || header.Magic[2] != HISTORY_ROLLUP_VERSION
+        || header.Size != sizeof(HistoryRollup) || header.Count > INV_MAX_COUNT + 1) {
+        ESP_LOGW(TAG, "Ignoring incompatible rollups");
+        fclose(file);
+        return;
+    }
+
+    // The rollups are read directly into place, so the file is checked before
+    const size_t bodySize = header.Count * (sizeof(uint64_t) + sizeof(HistoryRollup));
+    uint8_t buf[256];
+    uint32_t crc = 0;
+    size_t remaining = bodySize;
+    while (remaining > 0) {
+        const size_t len = std::min(remaining, sizeof(buf));
+        if (fread(buf, len, 1, file) != 1) {
+            break;
+        }
+        crc = esp_rom_crc32_le(crc, buf, len);
+        remaining -= len;
+    }
+    if (remaining > 0 || crc != header.Crc || fseek(file, sizeof(header), SEEK_SET) != 0) {
+        ESP_LOGW(TAG, "Ignoring corrupt rollups");
+        fclose(file);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (uint32_t i = 0; i < header.Count; i++) {
+        uint64_t serial;
+        if (fread(&serial, sizeof(serial), 1, file) != 1) {
+            break;
+        }
+
+        // Rollups of removed inverters are skipped
+        HistoryRollup* rollup = nullptr;
+        if (serial == HISTORY_TOTAL_SERIAL) {
+            rollup = &_totals;
+        } else if (Hoymiles.getInverterBySerial(serial) != nullptr) {
+            rollup = &_inverters[serial].Rollup;
+        }
+
+        if (rollup == nullptr ? fseek(file, sizeof(HistoryRollup), SEEK_CUR) != 0 : !rollup->read(file)) {
+            ESP_LOGW(TAG, "Rollups truncated");
+            break;
+        }
+    }
+
+    fclose(file);
+}
+
+void HistoryClass::saveRollups()
+{
+    FILE* file = fopen(HISTORY_ROLLUP_TMP_PATH, "wb");
+    if (file == nullptr) {
+        ESP_LOGE(TAG, "Failed to open %s", HISTORY_ROLLUP_TMP_PATH);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // Removed inverters are dropped
+    for (auto it = _inverters.begin(); it != _inverters.end();) {
+        it = Hoymiles.getInverterBySerial(it->first) == nullptr ? _inverters.erase(it) : std::next(it);
+    }
+
+    // The file is a copy of the memory, so the CRC is calculated from it upfront
+    const uint64_t totalSerial = HISTORY_TOTAL_SERIAL;
+    auto addCrc = [](uint32_t crc, const uint64_t& serial, const HistoryRollup& rollup) {
+        crc = esp_rom_crc32_le(crc, reinterpret_cast<const uint8_t*>(&serial), sizeof(serial));
+        return esp_rom_crc32_le(crc, reinterpret_cast<const uint8_t*>(&rollup), sizeof(HistoryRollup));
+    };
+
+    HistoryRollupHeader_t header = { { 'H', 'R', HISTORY_ROLLUP_VERSION, 0 }, sizeof(HistoryRollup), 0, 0 };
+    header.Count = _inverters.size() + 1;
+    header.Crc = addCrc(0, totalSerial, _totals);
+    for (auto& [serial, state] : _inverters) {
+        header.Crc = addCrc(header.Crc, serial, state.Rollup);
+    }
+
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(&totalSerial, sizeof(totalSerial), 1, file) == 1
+        && _totals.write(file);
+
+    for (auto& [serial, state] : _inverters) {
+        success = success
+            && fwrite(&serial, sizeof(serial), 1, file) == 1
+            && state.Rollup.write(file);
+    }
+
+    lock.unlock();
+
+    success = fclose(file) == 0 && success;
+    if (!success || rename(HISTORY_ROLLUP_TMP_PATH, HISTORY_ROLLUP_PATH) != 0) {
+        ESP_LOGE(TAG, "Failed to write %s", HISTORY_ROLLUP_PATH);
+        remove(HISTORY_ROLLUP_TMP_PATH);
+    }
+}
+
+std::vector<HistoryBucket_t> HistoryClass::getBuckets(const uint64_t serial, const HistoryResolution resolution, const uint32_t start, const uint32_t end)
+{
+    std::vector<HistoryBucket_t> buckets;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const HistoryRollup* rollup = &_totals;
+    if (serial != HISTORY_TOTAL_SERIAL) {
+        auto it = _inverters.find(serial);
+        if (it == _inverters.end()) {
+            return buckets;
+        }
+        rollup = &it->second.Rollup;
+    }
+
+    for (size_t i = 0; i < HistoryRollup::capacity(resolution); i++) {
+        const HistoryBucket_t& bucket = rollup->at(resolution, i);
+        if (bucket.Start > 0 && bucket.Start + HistoryRollup::interval(resolution) > start && bucket.Start <= end) {
+            buckets.push_back(bucket);
+        }
+    }
+
+    return buckets;
+}
+
+size_t HistoryClass::getRollupCount()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _inverters.size() + 1;
+}
+
+size_t HistoryClass::getRollupBytes()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return (_inverters.size() + 1) * sizeof(HistoryRollup);
+}
+
+HistoryStore& HistoryClass::getStore()
+{
+    return _store;
+}
+
+String HistoryClass::getSeriesName(const uint8_t index)
+{
+    switch (index) {
+    case 0:
+        return "ac_power";
+    case 1:
+        return "yield_day";
+    case 2:
+        return "yield_total";
+    default:
+        break;
+    }
+
+    String name = "dc";
+    name += (index - 3) / 2 + 1;
+    name += (index - 3) % 2 == 0 ? "_power" : "_yield_day";
+    return name;
+}
+
+float HistoryClass::getSeriesScale(const uint8_t index)
+{
+    if (index == 0 || (index >= 3 && (index - 3) % 2 == 0)) {
+        return 0.1;
+    }
+    if (index == 2) {
+        return 0.001;
+    }
+    return 1;
+}
+
+uint32_t HistoryClass::getCumulativeMask()
+{
+    uint32_t mask = (1 << 1) | (1 << 2);
+    for (uint8_t i = 4; i < HISTORY_MAX_SERIES; i += 2) {
+        mask |= 1 << i;
+    }
+    return mask;
+}
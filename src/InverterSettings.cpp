@@ -66,6 +66,7 @@ void InverterSettingsClass::init(Scheduler& scheduler)
 
     ESP_LOGI(TAG, "RF: Setting poll interval...");
     Hoymiles.setPollInterval(config.Dtu.PollInterval);
+    Hoymiles.setAdaptivePolling(config.Dtu.PollAdaptive);
 
     // Configure inverters
     for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
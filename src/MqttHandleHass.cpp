@@ -12,6 +12,9 @@
 
 #define MAX_CONFIG_PUBLISH_RATIO 60000
 
+// Time between two groups of discovery documents
+#define PUBLISH_STEP_INTERVAL 250
+
 #undef TAG
 static const char* TAG = "mqtt";
 
@@ -39,10 +42,59 @@ void MqttHandleHassClass::loop()
         _wasConnected = false;
     }
 
-    if (_updateForced && _publishConfigTimeout.occured()) {
-        publishConfig();
+    // Discovery is the only traffic of the low priority. Just the dropped documents, including
+    // the ones lost in the client queue on a disconnect, are published again. All others keep their hashes.
+    const bool droppedComplete = MqttSettings.takeDroppedTopics(MqttPriority::Low, _droppedTopics);
+    if (!droppedComplete) {
+        _publishedHashes.clear();
+    }
+    for (auto topicHash : _droppedTopics) {
+        _publishedHashes.erase(topicHash);
+    }
+    if (!droppedComplete || !_droppedTopics.empty()) {
+        _publishDropped = true;
+    }
+
+    if (!Configuration.get().Mqtt.Hass.Enabled) {
+        // Everything is published again once enabled
+        _publishStep = -1;
+        _publishedHashes.clear();
+        _publishDropped = false;
+        return;
+    }
+
+    // A forced update starts over, dropped documents wait for the current run to finish
+    if ((_updateForced || (_publishDropped && _publishStep < 0)) && _publishConfigTimeout.occured()) {
+        if (_updateForced) {
+            ESP_LOGI(TAG, "Publish HA config");
+
+            // Documents which are not retained by the broker have to be sent again
+            if (!Configuration.get().Mqtt.Hass.Retain) {
+                _publishedHashes.clear();
+            }
+        } else {
+            ESP_LOGW(TAG, "HA config messages were dropped, publishing them again");
+        }
+
+        _publishConfigTimeout.set(MAX_CONFIG_PUBLISH_RATIO);
         _updateForced = false;
+        _publishDropped = false;
+        _publishStep = 0;
+    }
+
+    // The next group is only generated once the previous one was sent
+    if (_publishStep < 0 || !_publishStepTimeout.occured()
+        || !MqttSettings.getConnected() || MqttSettings.getOutboxStats().Messages > 0) {
+        return;
+    }
+
+    if (publishConfigStep(_publishStep)) {
+        _publishStep++;
+        _publishStepTimeout.set(PUBLISH_STEP_INTERVAL);
+        return;
     }
+
+    _publishStep = -1;
 }
 
 void MqttHandleHassClass::forceUpdate()
@@ -50,19 +102,48 @@ void MqttHandleHassClass::forceUpdate()
     _updateForced = true;
 }
 
-void MqttHandleHassClass::publishConfig()
+bool MqttHandleHassClass::publishConfigStep(const uint32_t step)
 {
-    if (!Configuration.get().Mqtt.Hass.Enabled) {
-        return;
+    if (step == 0) {
+        publishDtuConfig();
+        return true;
     }
 
-    if (!MqttSettings.getConnected() && Hoymiles.isAllRadioIdle()) {
-        return;
+    const CONFIG_T& config = Configuration.get();
+
+    // One group with the common entities per inverter, followed by one group per channel
+    uint32_t group = 1;
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+
+        if (step == group++) {
+            publishInverterConfig(inv);
+            return true;
+        }
+
+        for (auto& t : inv->Statistics()->getChannelTypes()) {
+            for (auto& c : inv->Statistics()->getChannelsByType(t)) {
+                if (step != group++) {
+                    continue;
+                }
+
+                for (uint8_t f = 0; f < DEVICE_CLS_ASSIGN_LIST_LEN; f++) {
+                    bool clear = false;
+                    if (t == TYPE_DC && !config.Mqtt.Hass.IndividualPanels) {
+                        clear = true;
+                    }
+                    publishInverterField(inv, t, c, deviceFieldAssignment[f], clear);
+                }
+                return true;
+            }
+        }
     }
 
-    ESP_LOGI(TAG, "Publish HA config");
-    _publishConfigTimeout.set(MAX_CONFIG_PUBLISH_RATIO);
+    return false;
+}
 
+void MqttHandleHassClass::publishDtuConfig()
+{
     const CONFIG_T& config = Configuration.get();
 
     // publish DTU sensors
@@ -81,48 +162,31 @@ void MqttHandleHassClass::publishConfig()
     publishDtuSensor("DC Power", "dc/power", "W", "", DEVICE_CLS_PWR, STATE_CLS_MEASUREMENT, CATEGORY_NONE);
 
     publishDtuBinarySensor("Status", config.Mqtt.Lwt.Topic, config.Mqtt.Lwt.Value_Online, config.Mqtt.Lwt.Value_Offline, DEVICE_CLS_CONNECTIVITY, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+}
 
-    // Loop all inverters
-    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-        auto inv = Hoymiles.getInverterByPos(i);
-        yield();
-
-        publishInverterButton(inv, "Turn Inverter Off", "cmd/power", "0", "mdi:power-plug-off", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterButton(inv, "Turn Inverter On", "cmd/power", "1", "mdi:power-plug", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterButton(inv, "Restart Inverter", "cmd/restart", "1", "", DEVICE_CLS_RESTART, STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterButton(inv, "Reset Radio Statistics", "cmd/reset_rf_stats", "1", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
-
-        publishInverterNumber(inv, "Limit NonPersistent Relative", "status/limit_relative", "cmd/limit_nonpersistent_relative", 0, 100, 0.1, "%", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterNumber(inv, "Limit Persistent Relative", "status/limit_relative", "cmd/limit_persistent_relative", 0, 100, 0.1, "%", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
-
-        publishInverterNumber(inv, "Limit NonPersistent Absolute", "status/limit_absolute", "cmd/limit_nonpersistent_absolute", 0, MAX_INVERTER_LIMIT, 1, "W", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
-        publishInverterNumber(inv, "Limit Persistent Absolute", "status/limit_absolute", "cmd/limit_persistent_absolute", 0, MAX_INVERTER_LIMIT, 1, "W", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
-
-        publishInverterBinarySensor(inv, "Reachable", "status/reachable", "1", "0", DEVICE_CLS_CONNECTIVITY, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterBinarySensor(inv, "Producing", "status/producing", "1", "0", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_NONE);
-
-        publishInverterSensor(inv, "TX Requests", "radio/tx_request", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RX Success", "radio/rx_success", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RX Fail Receive Nothing", "radio/rx_fail_nothing", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RX Fail Receive Partial", "radio/rx_fail_partial", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RX Fail Receive Corrupt", "radio/rx_fail_corrupt", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "TX Re-Request Fragment", "radio/tx_re_request", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-        publishInverterSensor(inv, "RSSI", "radio/rssi", "dBm", "", DEVICE_CLS_SIGNAL_STRENGTH, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
-
-        // Loop all channels
-        for (auto& t : inv->Statistics()->getChannelTypes()) {
-            for (auto& c : inv->Statistics()->getChannelsByType(t)) {
-                for (uint8_t f = 0; f < DEVICE_CLS_ASSIGN_LIST_LEN; f++) {
-                    bool clear = false;
-                    if (t == TYPE_DC && !config.Mqtt.Hass.IndividualPanels) {
-                        clear = true;
-                    }
-                    publishInverterField(inv, t, c, deviceFieldAssignment[f], clear);
-                    yield();
-                }
-            }
-        }
-    }
+void MqttHandleHassClass::publishInverterConfig(std::shared_ptr<InverterAbstract> inv)
+{
+    publishInverterButton(inv, "Turn Inverter Off", "cmd/power", "0", "mdi:power-plug-off", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
+    publishInverterButton(inv, "Turn Inverter On", "cmd/power", "1", "mdi:power-plug", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
+    publishInverterButton(inv, "Restart Inverter", "cmd/restart", "1", "", DEVICE_CLS_RESTART, STATE_CLS_NONE, CATEGORY_CONFIG);
+    publishInverterButton(inv, "Reset Radio Statistics", "cmd/reset_rf_stats", "1", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_CONFIG);
+
+    publishInverterNumber(inv, "Limit NonPersistent Relative", "status/limit_relative", "cmd/limit_nonpersistent_relative", 0, 100, 0.1, "%", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
+    publishInverterNumber(inv, "Limit Persistent Relative", "status/limit_relative", "cmd/limit_persistent_relative", 0, 100, 0.1, "%", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
+
+    publishInverterNumber(inv, "Limit NonPersistent Absolute", "status/limit_absolute", "cmd/limit_nonpersistent_absolute", 0, MAX_INVERTER_LIMIT, 1, "W", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
+    publishInverterNumber(inv, "Limit Persistent Absolute", "status/limit_absolute", "cmd/limit_persistent_absolute", 0, MAX_INVERTER_LIMIT, 1, "W", "mdi:speedometer", STATE_CLS_NONE, CATEGORY_CONFIG);
+
+    publishInverterBinarySensor(inv, "Reachable", "status/reachable", "1", "0", DEVICE_CLS_CONNECTIVITY, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterBinarySensor(inv, "Producing", "status/producing", "1", "0", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_NONE);
+
+    publishInverterSensor(inv, "TX Requests", "radio/tx_request", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterSensor(inv, "RX Success", "radio/rx_success", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterSensor(inv, "RX Fail Receive Nothing", "radio/rx_fail_nothing", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterSensor(inv, "RX Fail Receive Partial", "radio/rx_fail_partial", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterSensor(inv, "RX Fail Receive Corrupt", "radio/rx_fail_corrupt", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterSensor(inv, "TX Re-Request Fragment", "radio/tx_re_request", "", "", DEVICE_CLS_NONE, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
+    publishInverterSensor(inv, "RSSI", "radio/rssi", "dBm", "", DEVICE_CLS_SIGNAL_STRENGTH, STATE_CLS_NONE, CATEGORY_DIAGNOSTIC);
 }
 
 void MqttHandleHassClass::publishInverterField(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const byteAssign_fieldDeviceClass_t fieldType, const bool clear)
@@ -172,8 +236,17 @@ void MqttHandleHassClass::publishInverterField(std::shared_ptr<InverterAbstract>
         root["stat_t"] = stateTopic;
         root["uniq_id"] = serial + "_ch" + chanNum + "_" + fieldName;
 
-        if (Configuration.get().Mqtt.Hass.Expire) {
-            root["exp_aft"] = Hoymiles.getNumInverters() * max<uint32_t>(Hoymiles.PollInterval(), Configuration.get().Mqtt.PublishInterval) * inv->getReachableThreshold();
+        const auto& config = Configuration.get().Mqtt;
+        // Without a max age unchanged values are never sent again, so they must not expire either
+        if (config.Hass.Expire && !(config.ChangeOnly.Enabled && config.ChangeOnly.MaxAge == 0)) {
+            // Reachable inverters with a constant output are polled less often in adaptive mode
+            const uint32_t backoff = Hoymiles.getAdaptivePolling() ? 1 << HOY_ADAPTIVE_POLL_MAX_BACKOFF_STABLE : 1;
+            uint32_t interval = Hoymiles.getNumInverters() * max<uint32_t>(Hoymiles.PollInterval() * backoff, config.PublishInterval);
+            if (config.ChangeOnly.Enabled) {
+                // Values inside the deadband are repeated with the first publish after the max age
+                interval += config.ChangeOnly.MaxAge;
+            }
+            root["exp_aft"] = interval * inv->getReachableThreshold();
         }
 
         publish(configTopic, root);
@@ -301,11 +374,32 @@ String MqttHandleHassClass::getDtuUrl()
     return String("http://") + NetworkSettings.localIP().toString();
 }
 
+static uint32_t fnv1a(const String& str, uint32_t hash = 2166136261UL)
+{
+    for (size_t i = 0; i < str.length(); i++) {
+        hash = (hash ^ static_cast<uint8_t>(str[i])) * 16777619UL;
+    }
+    return hash;
+}
+
 void MqttHandleHassClass::publish(const String& subtopic, const String& payload)
 {
-    String topic = Configuration.get().Mqtt.Hass.Topic;
+    const CONFIG_T& config = Configuration.get();
+
+    String topic = config.Mqtt.Hass.Topic;
     topic += subtopic;
-    MqttSettings.publishGeneric(topic, payload, Configuration.get().Mqtt.Hass.Retain);
+
+    // The retain flag is part of the hash, so changing it publishes all documents again
+    const uint32_t topicHash = fnv1a(topic);
+    const uint32_t payloadHash = fnv1a(payload, config.Mqtt.Hass.Retain ? 1 : 2166136261UL);
+
+    auto published = _publishedHashes.find(topicHash);
+    if (published != _publishedHashes.end() && published->second == payloadHash) {
+        return;
+    }
+
+    MqttSettings.publishGeneric(topic, payload, config.Mqtt.Hass.Retain, 0, MqttPriority::Low);
+    _publishedHashes[topicHash] = payloadHash;
     yield();
 }
 
@@ -314,9 +408,10 @@ void MqttHandleHassClass::publish(const String& subtopic, const JsonDocument& do
     if (!Utils::checkJsonAlloc(doc, __FUNCTION__, __LINE__)) {
         return;
     }
-    String buffer;
-    serializeJson(doc, buffer);
-    publish(subtopic, buffer);
+    // Reused for all documents, so its capacity is only allocated once
+    _payloadBuffer = "";
+    serializeJson(doc, _payloadBuffer);
+    publish(subtopic, _payloadBuffer);
 }
 
 void MqttHandleHassClass::addCommonMetadata(
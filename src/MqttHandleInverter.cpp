@@ -29,85 +29,120 @@ void MqttHandleInverterClass::init(Scheduler& scheduler)
 
 void MqttHandleInverterClass::loop()
 {
-    _loopTask.setInterval(Configuration.get().Mqtt.PublishInterval * TASK_SECOND);
+    const CONFIG_T& config = Configuration.get();
+
+    _loopTask.setInterval(config.Mqtt.PublishInterval * TASK_SECOND);
 
     if (!MqttSettings.getConnected() || !Hoymiles.isAllRadioIdle()) {
         _loopTask.forceNextIteration();
         return;
     }
 
+    // A dropped message may carry a value which is recorded as published in
+    // change only mode, so just the values of dropped messages are published
+    // again. If too many were dropped, the rest waits for its max age.
+    if (!MqttSettings.takeDroppedTopics(MqttPriority::Normal, _droppedTopics)) {
+        ESP_LOGW(TAG, "Too many messages dropped by the outbox, some values are published with their max age");
+    }
+
+    if (_updateForced.exchange(false)) {
+        // Rebuilding the topic tables resets the publish states,
+        // so all values are published again
+        for (auto& topics : _topicTables) {
+            topics.clear();
+        }
+    }
+
     // Loop all inverters
     for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
         auto inv = Hoymiles.getInverterByPos(i);
 
-        const String subtopic = inv->serialString();
-
-        // Name
-        MqttSettings.publish(subtopic + "/name", inv->name());
+        // Rebuilt whenever the inverter at this position changed
+        auto& topics = _topicTables[i];
+        if (topics.getSerial() != inv->serial()) {
+            topics.build(*inv, _publishFields, sizeof(_publishFields) / sizeof(FieldId_t));
+        } else {
+            topics.resetStates(config.Mqtt.Topic, _droppedTopics);
+        }
 
-        // Radio Statistics
-        MqttSettings.publish(subtopic + "/radio/tx_request", String(inv->RadioStats.TxRequestData));
-        MqttSettings.publish(subtopic + "/radio/tx_re_request", String(inv->RadioStats.TxReRequestFragment));
-        MqttSettings.publish(subtopic + "/radio/rx_success", String(inv->RadioStats.RxSuccess));
-        MqttSettings.publish(subtopic + "/radio/rx_fail_nothing", String(inv->RadioStats.RxFailNoAnswer));
-        MqttSettings.publish(subtopic + "/radio/rx_fail_partial", String(inv->RadioStats.RxFailPartialAnswer));
-        MqttSettings.publish(subtopic + "/radio/rx_fail_corrupt", String(inv->RadioStats.RxFailCorruptData));
-        MqttSettings.publish(subtopic + "/radio/rssi", String(inv->getLastRssi()));
+        {
+            auto batch = MqttSettings.beginBatch();
 
-        if (inv->DevInfo()->getLastUpdate() > 0) {
-            // Bootloader Version
-            MqttSettings.publish(subtopic + "/device/bootloaderversion", String(inv->DevInfo()->getFwBootloaderVersion()));
+            // Name
+            batch.publish(topics.getTopic(InverterTopic::Name), inv->name(), &topics.getState(InverterTopic::Name));
 
-            // Firmware Version
-            MqttSettings.publish(subtopic + "/device/fwbuildversion", String(inv->DevInfo()->getFwBuildVersion()));
+            // Radio Statistics
+            batch.publish(topics.getTopic(InverterTopic::RadioTxRequest), inv->RadioStats.TxRequestData, &topics.getState(InverterTopic::RadioTxRequest));
+            batch.publish(topics.getTopic(InverterTopic::RadioTxReRequest), inv->RadioStats.TxReRequestFragment, &topics.getState(InverterTopic::RadioTxReRequest));
+            batch.publish(topics.getTopic(InverterTopic::RadioRxSuccess), inv->RadioStats.RxSuccess, &topics.getState(InverterTopic::RadioRxSuccess));
+            batch.publish(topics.getTopic(InverterTopic::RadioRxFailNothing), inv->RadioStats.RxFailNoAnswer, &topics.getState(InverterTopic::RadioRxFailNothing));
+            batch.publish(topics.getTopic(InverterTopic::RadioRxFailPartial), inv->RadioStats.RxFailPartialAnswer, &topics.getState(InverterTopic::RadioRxFailPartial));
+            batch.publish(topics.getTopic(InverterTopic::RadioRxFailCorrupt), inv->RadioStats.RxFailCorruptData, &topics.getState(InverterTopic::RadioRxFailCorrupt));
+            batch.publish(topics.getTopic(InverterTopic::RadioRssi), inv->getLastRssi(), &topics.getState(InverterTopic::RadioRssi));
 
-            // Firmware Build DateTime
-            MqttSettings.publish(subtopic + "/device/fwbuilddatetime", inv->DevInfo()->getFwBuildDateTimeStr());
+            if (inv->DevInfo()->getLastUpdate() > 0) {
+                // Bootloader Version
+                batch.publish(topics.getTopic(InverterTopic::DeviceBootloaderVersion), inv->DevInfo()->getFwBootloaderVersion(), &topics.getState(InverterTopic::DeviceBootloaderVersion));
 
-            // Hardware part number
-            MqttSettings.publish(subtopic + "/device/hwpartnumber", String(inv->DevInfo()->getHwPartNumber()));
+                // Firmware Version
+                batch.publish(topics.getTopic(InverterTopic::DeviceFwBuildVersion), inv->DevInfo()->getFwBuildVersion(), &topics.getState(InverterTopic::DeviceFwBuildVersion));
 
-            // Hardware version
-            MqttSettings.publish(subtopic + "/device/hwversion", inv->DevInfo()->getHwVersion());
-        }
+                // Firmware Build DateTime
+                batch.publish(topics.getTopic(InverterTopic::DeviceFwBuildDateTime), inv->DevInfo()->getFwBuildDateTimeStr().c_str(), &topics.getState(InverterTopic::DeviceFwBuildDateTime));
 
-        if (inv->SystemConfigPara()->getLastUpdate() > 0) {
-            // Limit
-            MqttSettings.publish(subtopic + "/status/limit_relative", String(inv->SystemConfigPara()->getLimitPercent()));
+                // Hardware part number
+                batch.publish(topics.getTopic(InverterTopic::DeviceHwPartNumber), inv->DevInfo()->getHwPartNumber(), &topics.getState(InverterTopic::DeviceHwPartNumber));
 
-            uint16_t maxpower = inv->DevInfo()->getMaxPower();
-            if (maxpower > 0) {
-                MqttSettings.publish(subtopic + "/status/limit_absolute", String(inv->SystemConfigPara()->getLimitPercent() * maxpower / 100));
+                // Hardware version
+                batch.publish(topics.getTopic(InverterTopic::DeviceHwVersion), inv->DevInfo()->getHwVersion().c_str(), &topics.getState(InverterTopic::DeviceHwVersion));
             }
-        }
 
-        MqttSettings.publish(subtopic + "/status/reachable", String(inv->isReachable()));
-        MqttSettings.publish(subtopic + "/status/producing", String(inv->isProducing()));
+            if (inv->SystemConfigPara()->getLastUpdate() > 0) {
+                // Limit
+                batch.publish(topics.getTopic(InverterTopic::StatusLimitRelative), inv->SystemConfigPara()->getLimitPercent(), 2, &topics.getState(InverterTopic::StatusLimitRelative));
 
-        if (inv->Statistics()->getLastUpdate() > 0) {
-            MqttSettings.publish(subtopic + "/status/last_update", String(std::time(0) - (millis() - inv->Statistics()->getLastUpdate()) / 1000));
-        } else {
-            MqttSettings.publish(subtopic + "/status/last_update", String(0));
-        }
+                uint16_t maxpower = inv->DevInfo()->getMaxPower();
+                if (maxpower > 0) {
+                    batch.publish(topics.getTopic(InverterTopic::StatusLimitAbsolute), inv->SystemConfigPara()->getLimitPercent() * maxpower / 100, 2, &topics.getState(InverterTopic::StatusLimitAbsolute));
+                }
+            }
+
+            batch.publish(topics.getTopic(InverterTopic::StatusReachable), inv->isReachable(), &topics.getState(InverterTopic::StatusReachable));
+            batch.publish(topics.getTopic(InverterTopic::StatusProducing), inv->isProducing(), &topics.getState(InverterTopic::StatusProducing));
 
-        const uint32_t lastUpdateInternal = inv->Statistics()->getLastUpdateFromInternal();
-        if (inv->Statistics()->getLastUpdate() > 0 && (lastUpdateInternal != _lastPublishStats[i])) {
-            _lastPublishStats[i] = lastUpdateInternal;
-
-            // Loop all channels
-            for (auto& t : inv->Statistics()->getChannelTypes()) {
-                for (auto& c : inv->Statistics()->getChannelsByType(t)) {
-                    if (t == TYPE_DC) {
-                        INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
-                        if (inv_cfg != nullptr) {
-                            // TODO(tbnobody)
-                            MqttSettings.publish(inv->serialString() + "/" + String(static_cast<uint8_t>(c) + 1) + "/name", inv_cfg->channel[c].Name);
-                        }
+            time_t lastUpdate = 0;
+            if (inv->Statistics()->getLastUpdate() > 0) {
+                lastUpdate = std::time(0) - (millis() - inv->Statistics()->getLastUpdate()) / 1000;
+            }
+            batch.publish(topics.getTopic(InverterTopic::StatusLastUpdate), lastUpdate, &topics.getState(InverterTopic::StatusLastUpdate));
+
+            // In change only mode the fields are checked every interval to publish them once their max age expired
+            const uint32_t lastUpdateInternal = inv->Statistics()->getLastUpdateFromInternal();
+            if (inv->Statistics()->getLastUpdate() > 0 && (lastUpdateInternal != _lastPublishStats[i] || batch.isChangeOnly())) {
+                _lastPublishStats[i] = lastUpdateInternal;
+                inv->Statistics()->getFieldValues(_fieldValues);
+
+                const INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
+                if (inv_cfg != nullptr) {
+                    for (auto& channelName : topics.getChannelNames()) {
+                        batch.publish(topics.getTopic(channelName), inv_cfg->channel[channelName.Channel].Name, &channelName.State);
                     }
-                    for (uint8_t f = 0; f < sizeof(_publishFields) / sizeof(FieldId_t); f++) {
-                        publishField(inv, t, c, _publishFields[f]);
+                }
+
+                // Home Assistant discovery refers to the field topics
+                if (config.Mqtt.Aggregated.FieldTopics || config.Mqtt.Hass.Enabled) {
+                    for (auto& field : topics.getFields()) {
+                        batch.publish(topics.getTopic(field),
+                            inv->Statistics()->getChannelFieldValue(_fieldValues, field.Type, field.Channel, field.Field),
+                            inv->Statistics()->getChannelFieldDigits(field.Type, field.Channel, field.Field),
+                            &field.State);
                     }
                 }
+
+                const auto format = static_cast<MqttAggregatedFormat>(config.Mqtt.Aggregated.Format);
+                if (format != MqttAggregatedFormat::None) {
+                    publishAggregated(batch, *inv, topics, format, lastUpdate);
+                }
             }
         }
 
@@ -115,14 +150,38 @@ void MqttHandleInverterClass::loop()
     }
 }
 
-void MqttHandleInverterClass::publishField(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+void MqttHandleInverterClass::publishAggregated(MqttSettingsClass::Batch& batch, InverterAbstract& inv, MqttTopicTable& topics, const MqttAggregatedFormat format, const time_t lastUpdate)
 {
-    const String topic = getTopic(inv, type, channel, fieldId);
-    if (topic == "") {
-        return;
-    }
+    auto& buffer = batch.getBuffer();
+
+    // The same code writes the CSV column names and values
+    auto addValues = [&](const MqttDocumentFormat documentFormat) {
+        buffer.beginDocument(documentFormat);
+
+        buffer.addDocumentValue(topics.getKey(InverterTopic::StatusLastUpdate), static_cast<int64_t>(lastUpdate));
+        buffer.addDocumentValue(topics.getKey(InverterTopic::StatusReachable), static_cast<int64_t>(inv.isReachable()));
+        buffer.addDocumentValue(topics.getKey(InverterTopic::StatusProducing), static_cast<int64_t>(inv.isProducing()));
 
-    MqttSettings.publish(topic, inv->Statistics()->getChannelFieldValueString(type, channel, fieldId));
+        for (auto& field : topics.getFields()) {
+            buffer.addDocumentValue(topics.getKey(field),
+                inv.Statistics()->getChannelFieldValue(_fieldValues, field.Type, field.Channel, field.Field),
+                inv.Statistics()->getChannelFieldDigits(field.Type, field.Channel, field.Field));
+        }
+
+        buffer.endDocument();
+    };
+
+    if (format == MqttAggregatedFormat::Json) {
+        addValues(MqttDocumentFormat::Json);
+        batch.publishPayload(topics.getTopic(InverterTopic::Json), &topics.getState(InverterTopic::Json));
+    } else if (format == MqttAggregatedFormat::Csv) {
+        // Retained and only sent again if the layout changed or after a reconnect
+        addValues(MqttDocumentFormat::CsvHeader);
+        batch.publishPayloadRetainedOnChange(topics.getTopic(InverterTopic::CsvColumns), topics.getState(InverterTopic::CsvColumns));
+
+        addValues(MqttDocumentFormat::Csv);
+        batch.publishPayload(topics.getTopic(InverterTopic::Csv), &topics.getState(InverterTopic::Csv));
+    }
 }
 
 String MqttHandleInverterClass::getTopic(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
@@ -150,6 +209,11 @@ String MqttHandleInverterClass::getTopic(std::shared_ptr<InverterAbstract> inv,
     return inv->serialString() + "/" + chanNum + "/" + chanName;
 }
 
+void MqttHandleInverterClass::forceUpdate()
+{
+    _updateForced = true;
+}
+
 void MqttHandleInverterClass::onMqttMessage(Topic t, const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, const size_t len)
 {
     const CONFIG_T& config = Configuration.get();
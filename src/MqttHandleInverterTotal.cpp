@@ -6,7 +6,9 @@
 #include "Configuration.h"
 #include "Datastore.h"
 #include "MqttSettings.h"
-#include <Hoymiles.h>
+
+// Unchanged totals are published again after this many publish intervals
+#define PUBLISH_HEARTBEAT_INTERVALS 10
 
 MqttHandleInverterTotalClass MqttHandleInverterTotal;
 
@@ -27,11 +29,19 @@ void MqttHandleInverterTotalClass::loop()
     // Update interval from config
     _loopTask.setInterval(Configuration.get().Mqtt.PublishInterval * TASK_SECOND);
 
-    if (!MqttSettings.getConnected() || !Hoymiles.isAllRadioIdle()) {
+    if (!MqttSettings.getConnected()) {
         _loopTask.forceNextIteration();
         return;
     }
 
+    // Nothing changed since the last publish
+    const uint32_t generation = Datastore.getGeneration();
+    if (generation == _lastGeneration && ++_unchangedIntervals < PUBLISH_HEARTBEAT_INTERVALS) {
+        return;
+    }
+    _lastGeneration = generation;
+    _unchangedIntervals = 0;
+
     MqttSettings.publish("ac/power", String(Datastore.getTotalAcPowerEnabled(), Datastore.getTotalAcPowerDigits()));
     MqttSettings.publish("ac/yieldtotal", String(Datastore.getTotalAcYieldTotalEnabled(), Datastore.getTotalAcYieldTotalDigits()));
     MqttSettings.publish("ac/yieldday", String(Datastore.getTotalAcYieldDayEnabled(), Datastore.getTotalAcYieldDayDigits()));
@@ -4,16 +4,39 @@
  */
 #include "MqttSettings.h"
 #include "Configuration.h"
+#include "MqttHandleInverter.h"
 #include <frozen/map.h>
 #include <frozen/string.h>
+#include <algorithm>
 
 #undef TAG
 static const char* TAG = "mqtt";
 
+// Messages handed over to the client at once, the rest stays in the outbox
+#define MQTT_CLIENT_QUEUE_MAX 16
+
+// Messages are handed over right away on publish, the loop only moves the
+// rest once the client sent its queue
+#define MQTT_OUTBOX_DRAIN_INTERVAL 20
+
+// Percentage of the free heap (including the queued messages) the outbox may use at
+// most, regardless of the configured budget. Keeps the outbox from exhausting the heap
+// on devices without PSRAM, where the history and the configuration copy are allocated as well.
+#define MQTT_OUTBOX_HEAP_SHARE 25
+#define MQTT_OUTBOX_BUDGET_MIN 1024U
+
 MqttSettingsClass::MqttSettingsClass()
+    : _loopTask(MQTT_OUTBOX_DRAIN_INTERVAL * TASK_MILLISECOND, TASK_FOREVER, std::bind(&MqttSettingsClass::loop, this))
 {
 }
 
+void MqttSettingsClass::loop()
+{
+    std::lock_guard<std::mutex> lock(_clientLock);
+    updateOutboxBudget();
+    drainOutbox();
+}
+
 void MqttSettingsClass::NetworkEvent(network_event event)
 {
     switch (event) {
@@ -34,7 +57,7 @@ void MqttSettingsClass::onMqttConnect(const bool sessionPresent)
 {
     ESP_LOGI(TAG, "Connected to MQTT.");
     const CONFIG_T& config = Configuration.get();
-    publish(config.Mqtt.Lwt.Topic, config.Mqtt.Lwt.Value_Online);
+    publish(config.Mqtt.Lwt.Topic, config.Mqtt.Lwt.Value_Online, MqttPriority::High);
 
     std::lock_guard<std::mutex> lock(_clientLock);
     if (_mqttClient != nullptr) {
@@ -42,6 +65,8 @@ void MqttSettingsClass::onMqttConnect(const bool sessionPresent)
             _mqttClient->subscribe(cb.topic.c_str(), cb.qos);
         }
     }
+
+    MqttHandleInverter.forceUpdate();
 }
 
 void MqttSettingsClass::subscribe(const String& topic, const uint8_t qos, const OnMessageCallback& cb)
@@ -80,6 +105,12 @@ void MqttSettingsClass::onMqttDisconnect(espMqttClientTypes::DisconnectReason re
 
     ESP_LOGW(TAG, "Disconnected from MQTT. Reason: %s", reasonStr);
 
+    {
+        // QoS 0 messages still queued by the client are lost
+        std::lock_guard<std::mutex> lock(_clientLock);
+        _outbox.dropInFlight();
+    }
+
     _mqttReconnectTimer.once(
         2, +[](MqttSettingsClass* instance) { instance->performConnect(); }, this);
 }
@@ -166,7 +197,7 @@ void MqttSettingsClass::performConnect()
 void MqttSettingsClass::performDisconnect()
 {
     const CONFIG_T& config = Configuration.get();
-    publish(config.Mqtt.Lwt.Topic, config.Mqtt.Lwt.Value_Offline);
+    publish(config.Mqtt.Lwt.Topic, config.Mqtt.Lwt.Value_Offline, MqttPriority::High);
     std::lock_guard<std::mutex> lock(_clientLock);
     if (_mqttClient == nullptr) {
         return;
@@ -207,7 +238,7 @@ String MqttSettingsClass::getClientId() const
     return clientId;
 }
 
-void MqttSettingsClass::publish(const String& subtopic, const String& payload)
+void MqttSettingsClass::publish(const String& subtopic, const String& payload, const MqttPriority priority)
 {
     String topic = getPrefix();
     topic += subtopic;
@@ -215,24 +246,182 @@ void MqttSettingsClass::publish(const String& subtopic, const String& payload)
     String value = payload;
     value.trim();
 
-    publishGeneric(topic, value, Configuration.get().Mqtt.Retain, 0);
+    publishGeneric(topic, value, Configuration.get().Mqtt.Retain, 0, priority);
 }
 
-void MqttSettingsClass::publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos)
+void MqttSettingsClass::publishGeneric(const String& topic, const String& payload, const bool retain, const uint8_t qos, const MqttPriority priority)
 {
     std::lock_guard<std::mutex> lock(_clientLock);
+    enqueue(topic.c_str(), payload.c_str(), retain, qos, priority);
+}
+
+void MqttSettingsClass::enqueue(const char* topic, const char* payload, const bool retain, const uint8_t qos, const MqttPriority priority)
+{
     if (_mqttClient == nullptr) {
         return;
     }
-    _mqttClient->publish(topic.c_str(), qos, retain, payload.c_str());
+
+    // Not held back, e.g. the last will has to be sent before disconnecting
+    if (priority == MqttPriority::High) {
+        _mqttClient->publish(topic, qos, retain, payload);
+        return;
+    }
+
+    _outbox.push(topic, payload, qos, retain, priority);
+    drainOutbox();
+}
+
+void MqttSettingsClass::drainOutbox()
+{
+    if (_mqttClient == nullptr || !_mqttClient->connected()) {
+        return;
+    }
+
+    _outbox.setInFlight(_mqttClient->queueSize());
+
+    while (_mqttClient->queueSize() < MQTT_CLIENT_QUEUE_MAX) {
+        const auto message = _outbox.front();
+        if (message == nullptr) {
+            break;
+        }
+
+        if (_mqttClient->publish(message->Topic.c_str(), message->Qos, message->Retain, message->Payload.c_str()) == 0) {
+            break;
+        }
+        _outbox.pop();
+    }
+}
+
+void MqttSettingsClass::updateOutboxBudget()
+{
+    const size_t heapLimit = (ESP.getFreeHeap() + _outbox.getBytes()) * MQTT_OUTBOX_HEAP_SHARE / 100;
+    const size_t budget = std::max<size_t>(std::min<size_t>(Configuration.get().Mqtt.Outbox.Budget, heapLimit), MQTT_OUTBOX_BUDGET_MIN);
+    if (budget != _outbox.getBudget()) {
+        _outbox.setBudget(budget);
+    }
 }
 
-void MqttSettingsClass::init()
+MqttSettingsClass::OutboxStats_t MqttSettingsClass::getOutboxStats()
+{
+    std::lock_guard<std::mutex> lock(_clientLock);
+
+    OutboxStats_t stats;
+    stats.Messages = _outbox.size();
+    stats.Bytes = _outbox.getBytes();
+    stats.Budget = _outbox.getBudget();
+    stats.ClientQueue = _mqttClient != nullptr ? _mqttClient->queueSize() : 0;
+    stats.Dropped = _outbox.getDropped();
+    stats.Coalesced = _outbox.getCoalesced();
+    return stats;
+}
+
+bool MqttSettingsClass::takeDroppedTopics(const MqttPriority priority, std::vector<uint32_t>& topics)
+{
+    std::lock_guard<std::mutex> lock(_clientLock);
+    return _outbox.takeDroppedTopics(priority, topics);
+}
+
+MqttSettingsClass::Batch MqttSettingsClass::beginBatch()
+{
+    return Batch(*this);
+}
+
+MqttSettingsClass::Batch::Batch(MqttSettingsClass& settings)
+    : _settings(settings)
+    , _lock(settings._batchLock)
+{
+    const CONFIG_T& config = Configuration.get();
+    _settings._publishBuffer.setPrefix(config.Mqtt.Topic);
+    _retain = config.Mqtt.Retain;
+
+    _filter.setEnabled(config.Mqtt.ChangeOnly.Enabled);
+    _filter.setDeadband(config.Mqtt.ChangeOnly.DeadbandSteps, config.Mqtt.ChangeOnly.DeadbandRelative);
+    _filter.setMaxAge(config.Mqtt.ChangeOnly.MaxAge * 1000);
+    _now = millis();
+}
+
+void MqttSettingsClass::Batch::publish(const char* subtopic, const char* payload, MqttPublishState_t* state)
+{
+    payload = _settings._publishBuffer.setPayload(payload);
+    if (state == nullptr || _filter.check(*state, payload, _now)) {
+        send(subtopic, _retain);
+    }
+}
+
+void MqttSettingsClass::Batch::publish(const char* subtopic, const float value, const uint8_t digits, MqttPublishState_t* state)
+{
+    if (state == nullptr || _filter.check(*state, value, digits, _now)) {
+        _settings._publishBuffer.setPayload(value, digits);
+        send(subtopic, _retain);
+    }
+}
+
+MqttPublishBuffer& MqttSettingsClass::Batch::getBuffer()
+{
+    return _settings._publishBuffer;
+}
+
+void MqttSettingsClass::Batch::publishPayload(const char* subtopic, MqttPublishState_t* state)
+{
+    if (state == nullptr || _filter.check(*state, _settings._publishBuffer.getPayload(), _now)) {
+        send(subtopic, _retain);
+    }
+}
+
+void MqttSettingsClass::Batch::publishPayloadRetainedOnChange(const char* subtopic, MqttPublishState_t& state)
+{
+    if (MqttPublishFilter::checkChanged(state, _settings._publishBuffer.getPayload(), _now)) {
+        send(subtopic, true);
+    }
+}
+
+bool MqttSettingsClass::Batch::isChangeOnly() const
+{
+    return _filter.getEnabled();
+}
+
+void MqttSettingsClass::Batch::send(const char* subtopic, const bool retain)
+{
+    const char* topic = _settings._publishBuffer.setTopic(subtopic);
+
+    auto& data = _settings._batchData;
+    BatchMessage_t message;
+    message.Topic = data.size();
+    data.append(topic).push_back('\0');
+    message.Payload = data.size();
+    data.append(_settings._publishBuffer.getPayload()).push_back('\0');
+    message.Retain = retain;
+    _settings._batchMessages.push_back(message);
+}
+
+MqttSettingsClass::Batch::~Batch()
+{
+    if (_settings._batchMessages.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_settings._clientLock);
+        const char* data = _settings._batchData.c_str();
+        for (const auto& message : _settings._batchMessages) {
+            _settings.enqueue(data + message.Topic, data + message.Payload, message.Retain, 0, MqttPriority::Normal);
+        }
+    }
+
+    // The capacity is kept for the next batch
+    _settings._batchData.clear();
+    _settings._batchMessages.clear();
+}
+
+void MqttSettingsClass::init(Scheduler& scheduler)
 {
     using std::placeholders::_1;
     NetworkSettings.onEvent(std::bind(&MqttSettingsClass::NetworkEvent, this, _1));
 
     createMqttClientObject();
+
+    scheduler.addTask(_loopTask);
+    _loopTask.enable();
 }
 
 void MqttSettingsClass::createMqttClientObject()
@@ -241,6 +430,8 @@ void MqttSettingsClass::createMqttClientObject()
     if (_mqttClient != nullptr) {
         delete _mqttClient;
         _mqttClient = nullptr;
+        // The queue of the previous client is gone
+        _outbox.dropInFlight();
     }
     const CONFIG_T& config = Configuration.get();
     if (config.Mqtt.Tls.Enabled) {
@@ -248,6 +439,13 @@ void MqttSettingsClass::createMqttClientObject()
     } else {
         _mqttClient = static_cast<MqttClient*>(new espMqttClient);
     }
+
+    // Messages queued for the previous client are kept unless MQTT got disabled
+    if (!config.Mqtt.Enabled) {
+        _outbox.clear();
+    }
+    updateOutboxBudget();
+    _outbox.setCoalesce(config.Mqtt.Outbox.Coalesce);
 }
 
 MqttSettingsClass MqttSettings;
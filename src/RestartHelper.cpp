@@ -4,7 +4,9 @@
  */
 #include "RestartHelper.h"
 #include "Display_Graphic.h"
+#include "History.h"
 #include "Led_Single.h"
+#include "Utils.h"
 #include <Esp.h>
 
 RestartHelperClass RestartHelper;
@@ -25,11 +27,24 @@ void RestartHelperClass::triggerRestart()
     _rebootTask.restart();
 }
 
+void RestartHelperClass::triggerFactoryReset()
+{
+    _factoryReset = true;
+    triggerRestart();
+}
+
 void RestartHelperClass::loop()
 {
     if (_rebootTask.isFirstIteration()) {
         LedSingle.turnAllOff();
         Display.setStatus(false);
+        if (_factoryReset) {
+            // Runs in the scheduler like the history loop, so no file is written after the removal
+            History.close();
+            Utils::removeAllFiles();
+        } else {
+            History.save();
+        }
     } else {
         ESP.restart();
     }
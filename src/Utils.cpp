@@ -70,20 +70,29 @@ bool Utils::checkJsonAlloc(const JsonDocument& doc, const char* function, const
     return true;
 }
 
-/// @brief Remove all files but the PINMAPPING_FILENAME
-void Utils::removeAllFiles()
+static void removeDirectoryContent(const String& path)
 {
-    auto root = LittleFS.open("/");
-    auto file = root.getNextFileName();
+    auto dir = LittleFS.open(path);
+    bool isDir = false;
+    auto file = dir.getNextFileName(&isDir);
 
     while (file != "") {
-        if (file != PINMAPPING_FILENAME) {
+        if (isDir) {
+            removeDirectoryContent(file);
+            LittleFS.rmdir(file);
+        } else if (file != PINMAPPING_FILENAME) {
             LittleFS.remove(file);
         }
-        file = root.getNextFileName();
+        file = dir.getNextFileName(&isDir);
     }
 }
 
+/// @brief Remove all files but the PINMAPPING_FILENAME, including the content of directories (e.g. the history)
+void Utils::removeAllFiles()
+{
+    removeDirectoryContent("/");
+}
+
 String Utils::generateMd5FromFile(String file)
 {
     if (!LittleFS.exists(file)) {
@@ -10,6 +10,46 @@
 #undef TAG
 static const char* TAG = "webapi";
 
+// Holds the current part of a chunked response
+class JsonPartBuffer : public Print {
+public:
+    size_t write(uint8_t c) override
+    {
+        _data.push_back(c);
+        return 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        _data.append(reinterpret_cast<const char*>(buffer), size);
+        return size;
+    }
+
+    void clear()
+    {
+        // Keeps the capacity for the next part
+        _data.clear();
+        _pos = 0;
+    }
+
+    bool empty() const
+    {
+        return _pos >= _data.size();
+    }
+
+    size_t read(uint8_t* buffer, const size_t maxLen)
+    {
+        const size_t len = std::min(maxLen, _data.size() - _pos);
+        memcpy(buffer, _data.data() + _pos, len);
+        _pos += len;
+        return len;
+    }
+
+private:
+    std::string _data;
+    size_t _pos = 0;
+};
+
 WebApiClass::WebApiClass()
     : _server(HTTP_PORT)
 {
@@ -24,6 +64,7 @@ void WebApiClass::init(Scheduler& scheduler)
     _webApiFile.init(_server, scheduler);
     _webApiFirmware.init(_server, scheduler);
     _webApiGridprofile.init(_server, scheduler);
+    _webApiHistory.init(_server, scheduler);
     _webApiI18n.init(_server, scheduler);
     _webApiInverter.init(_server, scheduler);
     _webApiLimit.init(_server, scheduler);
@@ -150,4 +191,69 @@ bool WebApiClass::sendJsonResponse(AsyncWebServerRequest* request, AsyncJsonResp
     return ret_val;
 }
 
+bool WebApiClass::acceptsMessagePack(AsyncWebServerRequest* request)
+{
+    if (!request->hasHeader("Accept")) {
+        return false;
+    }
+
+    const String& accept = request->getHeader("Accept")->value();
+    return accept.indexOf("application/msgpack") >= 0 || accept.indexOf("application/x-msgpack") >= 0;
+}
+
+bool WebApiClass::sendMessagePackResponse(AsyncWebServerRequest* request, AsyncMessagePackResponse* response, const char* function, const uint16_t line)
+{
+    bool ret_val = true;
+    if (response->overflowed()) {
+        auto& root = response->getRoot();
+
+        root.clear();
+        root["message"] = String("500 Internal Server Error: ") + function + ", " + line;
+        root["code"] = WebApiError::GenericInternalServerError;
+        root["type"] = "danger";
+        response->setCode(500);
+        ESP_LOGE(TAG, "WebResponse failed: %s, %" PRIu16 "", function, line);
+        ret_val = false;
+    }
+
+    response->setLength();
+    request->send(response);
+    return ret_val;
+}
+
+void WebApiClass::sendChunkedJsonResponse(AsyncWebServerRequest* request, const JsonPartWriter& writer)
+{
+    struct State_t {
+        JsonPartBuffer buffer;
+        size_t part = 0;
+        bool done = false;
+    };
+    auto state = std::make_shared<State_t>();
+
+    auto response = request->beginChunkedResponse("application/json", [state, writer, request](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+        // Parts may be empty, so generate until there is something to send
+        while (state->buffer.empty()) {
+            if (state->done) {
+                return 0;
+            }
+
+            state->buffer.clear();
+            try {
+                state->done = !writer(state->part++, state->buffer);
+            } catch (const std::bad_alloc& bad_alloc) {
+                // The headers have already been sent. Ending the response would leave the client with a
+                // truncated but complete looking JSON document, so the connection is aborted instead.
+                ESP_LOGE(TAG, "Chunked response temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
+                state->done = true;
+                request->client()->abort();
+                return 0;
+            }
+        }
+
+        return state->buffer.read(buffer, maxLen);
+    });
+
+    request->send(response);
+}
+
 WebApiClass WebApi;
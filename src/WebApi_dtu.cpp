@@ -4,6 +4,7 @@
  */
 #include "WebApi_dtu.h"
 #include "Configuration.h"
+#include "MqttHandleHass.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include <AsyncJson.h>
@@ -35,6 +36,10 @@ void WebApiDtuClass::applyDataTaskCb()
     Hoymiles.getRadioCmt()->setCountryMode(static_cast<CountryModeId_t>(config.Dtu.Cmt.CountryMode));
     Hoymiles.getRadioCmt()->setInverterTargetFrequency(config.Dtu.Cmt.Frequency);
     Hoymiles.setPollInterval(config.Dtu.PollInterval);
+    Hoymiles.setAdaptivePolling(config.Dtu.PollAdaptive);
+
+    // Expiry time depends on the poll interval
+    MqttHandleHass.forceUpdate();
 }
 
 void WebApiDtuClass::onDtuAdminGet(AsyncWebServerRequest* request)
@@ -54,6 +59,7 @@ void WebApiDtuClass::onDtuAdminGet(AsyncWebServerRequest* request)
         static_cast<uint32_t>(config.Dtu.Serial & 0xFFFFFFFF));
     root["serial"] = buffer;
     root["pollinterval"] = config.Dtu.PollInterval;
+    root["poll_adaptive"] = config.Dtu.PollAdaptive;
     root["nrf_enabled"] = Hoymiles.getRadioNrf()->isInitialized();
     root["nrf_palevel"] = config.Dtu.Nrf.PaLevel;
     root["cmt_enabled"] = Hoymiles.getRadioCmt()->isInitialized();
@@ -92,6 +98,7 @@ void WebApiDtuClass::onDtuAdminPost(AsyncWebServerRequest* request)
 
     if (!(root["serial"].is<String>()
             && root["pollinterval"].is<uint32_t>()
+            && root["poll_adaptive"].is<bool>()
             && root["nrf_palevel"].is<uint8_t>()
             && root["cmt_palevel"].is<int8_t>()
             && root["cmt_frequency"].is<uint32_t>()
@@ -158,6 +165,7 @@ void WebApiDtuClass::onDtuAdminPost(AsyncWebServerRequest* request)
         auto& config = guard.getConfig();
         config.Dtu.Serial = serial;
         config.Dtu.PollInterval = root["pollinterval"].as<uint32_t>();
+        config.Dtu.PollAdaptive = root["poll_adaptive"].as<bool>();
         config.Dtu.Nrf.PaLevel = root["nrf_palevel"].as<uint8_t>();
         config.Dtu.Cmt.PaLevel = root["cmt_palevel"].as<int8_t>();
         config.Dtu.Cmt.Frequency = root["cmt_frequency"].as<uint32_t>();
@@ -20,8 +20,6 @@ void WebApiEventlogClass::onEventlogStatus(AsyncWebServerRequest* request)
         return;
     }
 
-    AsyncJsonResponse* response = new AsyncJsonResponse();
-    auto& root = response->getRoot();
     auto serial = WebApi.parseSerialFromRequest(request);
 
     AlarmMessageLocale_t locale = AlarmMessageLocale_t::EN;
@@ -38,24 +36,38 @@ void WebApiEventlogClass::onEventlogStatus(AsyncWebServerRequest* request)
 
     auto inv = Hoymiles.getInverterBySerial(serial);
 
-    if (inv != nullptr) {
-        uint8_t logEntryCount = inv->EventLog()->getEntryCount();
+    // One event per part
+    WebApi.sendChunkedJsonResponse(request, [inv, locale, logEntryCount = uint8_t(0)](const size_t part, Print& output) mutable {
+        if (inv == nullptr) {
+            output.print("{}");
+            return false;
+        }
+
+        if (part == 0) {
+            logEntryCount = inv->EventLog()->getEntryCount();
+            output.printf("{\"count\":%" PRIu8 ",\"events\":[", logEntryCount);
+            return true;
+        }
 
-        root["count"] = logEntryCount;
-        JsonArray eventsArray = root["events"].to<JsonArray>();
+        const uint8_t logEntry = part - 1;
+        if (logEntry >= logEntryCount) {
+            output.print("]}");
+            return false;
+        }
 
-        for (uint8_t logEntry = 0; logEntry < logEntryCount; logEntry++) {
-            JsonObject eventsObject = eventsArray.add<JsonObject>();
+        AlarmLogEntry_t entry;
+        inv->EventLog()->getLogEntry(logEntry, entry, locale);
 
-            AlarmLogEntry_t entry;
-            inv->EventLog()->getLogEntry(logEntry, entry, locale);
+        JsonDocument doc;
+        doc["message_id"] = entry.MessageId;
+        doc["message"] = entry.Message;
+        doc["start_time"] = entry.StartTime;
+        doc["end_time"] = entry.EndTime;
 
-            eventsObject["message_id"] = entry.MessageId;
-            eventsObject["message"] = entry.Message;
-            eventsObject["start_time"] = entry.StartTime;
-            eventsObject["end_time"] = entry.EndTime;
+        if (logEntry > 0) {
+            output.print(',');
         }
-    }
-
-    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        serializeJson(doc, output);
+        return true;
+    });
 }
@@ -1,11 +1,10 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 /*
- * Copyright (C) 2022-2024 Thomas Basler and others
+ * Copyright (C) 2022-2025 Thomas Basler and others
  */
 #include "WebApi_file.h"
 #include "Configuration.h"
 #include "RestartHelper.h"
-#include "Utils.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include <AsyncJson.h>
@@ -42,12 +41,11 @@ void WebApiFileClass::onFileListGet(AsyncWebServerRequest* request)
     File rootfs = LittleFS.open("/");
     File file = rootfs.openNextFile();
     while (file) {
-        if (file.isDirectory()) {
-            continue;
+        if (!file.isDirectory()) {
+            JsonObject obj = data.add<JsonObject>();
+            obj["name"] = String(file.name());
+            obj["size"] = file.size();
         }
-        JsonObject obj = data.add<JsonObject>();
-        obj["name"] = String(file.name());
-        obj["size"] = file.size();
 
         file = rootfs.openNextFile();
     }
@@ -64,13 +62,18 @@ void WebApiFileClass::onFileGet(AsyncWebServerRequest* request)
 
     String requestFile = CONFIG_FILENAME;
     if (request->hasParam("file")) {
-        String name = "/" + request->getParam("file")->value();
-        if (LittleFS.exists(name)) {
-            requestFile = name;
-        } else {
-            request->send(404);
-            return;
-        }
+        requestFile = "/" + request->getParam("file")->value();
+    }
+
+    // The configuration is stored as binary image, the JSON file is created on export
+    if (requestFile == CONFIG_FILENAME && !Configuration.writeJson()) {
+        request->send(500);
+        return;
+    }
+
+    if (!LittleFS.exists(requestFile)) {
+        request->send(404);
+        return;
     }
 
     request->send(LittleFS, requestFile, String(), true);
@@ -105,6 +108,11 @@ void WebApiFileClass::onFileDelete(AsyncWebServerRequest* request)
 
     LittleFS.remove(name);
 
+    // The configuration is loaded from the image, which has to be removed as well
+    if (name == CONFIG_FILENAME) {
+        LittleFS.remove(CONFIG_IMAGE_FILENAME);
+    }
+
     retMsg["type"] = "success";
     retMsg["message"] = "File deleted";
     retMsg["code"] = WebApiError::FileDeleteSuccess;
@@ -146,8 +154,7 @@ void WebApiFileClass::onFileDeleteAll(AsyncWebServerRequest* request)
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 
-    Utils::removeAllFiles();
-    RestartHelper.triggerRestart();
+    RestartHelper.triggerFactoryReset();
 }
 
 void WebApiFileClass::onFileUpload(AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len, bool final)
@@ -174,6 +181,11 @@ void WebApiFileClass::onFileUpload(AsyncWebServerRequest* request, String filena
     if (final) {
         // close the file handle as the upload is now done
         request->_tempFile.close();
+
+        // Import the uploaded configuration instead of loading the binary image after the restart
+        if ("/" + request->getParam("file")->value() == CONFIG_FILENAME) {
+            LittleFS.remove(CONFIG_IMAGE_FILENAME);
+        }
     }
 }
 
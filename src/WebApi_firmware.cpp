@@ -60,6 +60,13 @@ void WebApiFirmwareClass::onFirmwareUpdateUpload(AsyncWebServerRequest* request,
             Update.printError(Serial);
             return request->send(400, "text/plain", "OTA could not begin");
         }
+
+        // The binary configuration image may not match the layout of the new firmware, which imports the JSON file then.
+        // Without a current export the new firmware would import an outdated configuration.
+        if (!Configuration.writeJson()) {
+            Update.abort();
+            return request->send(500, "text/plain", "Could not export configuration");
+        }
     }
 
     // Write chunked data to the free sketch space
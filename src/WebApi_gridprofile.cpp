@@ -21,35 +21,56 @@ void WebApiGridProfileClass::onGridProfileStatus(AsyncWebServerRequest* request)
         return;
     }
 
-    AsyncJsonResponse* response = new AsyncJsonResponse();
-    auto& root = response->getRoot();
     auto serial = WebApi.parseSerialFromRequest(request);
     auto inv = Hoymiles.getInverterBySerial(serial);
 
-    if (inv != nullptr) {
-        root["name"] = inv->GridProfile()->getProfileName();
-        root["version"] = inv->GridProfile()->getProfileVersion();
+    // One section per part, each read from the parser while it is sent
+    WebApi.sendChunkedJsonResponse(request, [inv, pos = static_cast<uint16_t>(GRID_PROFILE_SECTION_START)](const size_t part, Print& output) mutable {
+        if (inv == nullptr) {
+            output.print("{}");
+            return false;
+        }
 
-        auto jsonSections = root["sections"].to<JsonArray>();
-        auto profSections = inv->GridProfile()->getProfile();
+        if (part == 0) {
+            JsonDocument doc;
+            doc["name"] = inv->GridProfile()->getProfileName();
+            doc["version"] = inv->GridProfile()->getProfileVersion();
+
+            // Keep the root object open for the sections
+            String header;
+            serializeJson(doc, header);
+            header.remove(header.length() - 1);
+            output.print(header);
+            output.print(",\"sections\":[");
+            return true;
+        }
 
-        for (auto& profSection : profSections) {
-            auto jsonSection = jsonSections.add<JsonObject>();
-            jsonSection["name"] = profSection.SectionName;
+        GridProfileSection_t profSection;
+        if (!inv->GridProfile()->getSection(pos, profSection)) {
+            output.print("]}");
+            return false;
+        }
 
-            auto jsonItems = jsonSection["items"].to<JsonArray>();
+        JsonDocument doc;
+        doc["name"] = profSection.SectionName;
 
-            for (auto& profItem : profSection.items) {
-                auto jsonItem = jsonItems.add<JsonObject>();
+        auto jsonItems = doc["items"].to<JsonArray>();
 
-                jsonItem["n"] = profItem.Name;
-                jsonItem["u"] = profItem.Unit;
-                jsonItem["v"] = profItem.Value;
-            }
+        for (auto& profItem : profSection.items) {
+            auto jsonItem = jsonItems.add<JsonObject>();
+
+            jsonItem["n"] = profItem.Name;
+            jsonItem["u"] = profItem.Unit;
+            jsonItem["v"] = profItem.Value;
         }
-    }
 
-    WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+        if (part > 1) {
+            output.print(',');
+        }
+        serializeJson(doc, output);
+
+        return true;
+    });
 }
 
 void WebApiGridProfileClass::onGridProfileRawdata(AsyncWebServerRequest* request)
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2025 Thomas Basler and others
+ */
+#include "WebApi_history.h"
+#include "History.h"
+#include "WebApi.h"
+#include <Hoymiles.h>
+#include <algorithm>
+#include <memory>
+
+#define HISTORY_DEFAULT_RANGE (24 * 60 * 60)
+#define HISTORY_DEFAULT_POINTS 288U
+#define HISTORY_MAX_POINTS 1440U
+#define HISTORY_MIN_INTERVAL 60U
+
+void WebApiHistoryClass::init(AsyncWebServer& server, Scheduler& scheduler)
+{
+    using std::placeholders::_1;
+
+    server.on("/api/history", HTTP_GET, std::bind(&WebApiHistoryClass::onHistoryGet, this, _1));
+}
+
+void WebApiHistoryClass::onHistoryGet(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    const uint64_t serial = WebApi.parseSerialFromRequest(request);
+
+    uint32_t end = std::time(nullptr);
+    if (request->hasParam("end")) {
+        end = strtoul(request->getParam("end")->value().c_str(), nullptr, 10);
+    }
+
+    // Rollups default to all buckets, samples to the last day
+    const bool rollup = request->hasParam("resolution");
+
+    uint32_t start = !rollup && end > HISTORY_DEFAULT_RANGE ? end - HISTORY_DEFAULT_RANGE : 0;
+    if (request->hasParam("start")) {
+        start = std::min<uint32_t>(strtoul(request->getParam("start")->value().c_str(), nullptr, 10), end);
+    }
+
+    if (rollup) {
+        const String resolution = request->getParam("resolution")->value();
+        if (resolution == "minute") {
+            sendBuckets(request, serial, HistoryResolution::Minute, start, end);
+        } else if (resolution == "quarter") {
+            sendBuckets(request, serial, HistoryResolution::Quarter, start, end);
+        } else if (resolution == "day") {
+            sendBuckets(request, serial, HistoryResolution::Day, start, end);
+        } else {
+            request->send(400);
+        }
+        return;
+    }
+
+    uint32_t points = HISTORY_DEFAULT_POINTS;
+    if (request->hasParam("points")) {
+        points = std::clamp<uint32_t>(strtoul(request->getParam("points")->value().c_str(), nullptr, 10), 1, HISTORY_MAX_POINTS);
+    }
+
+    sendSamples(request, serial, start, end, points);
+}
+
+void WebApiHistoryClass::sendSamples(AsyncWebServerRequest* request, const uint64_t serial, const uint32_t start, const uint32_t end, const uint32_t points)
+{
+    const uint32_t interval = std::max<uint32_t>((end - start) / points + 1, HISTORY_MIN_INTERVAL);
+
+    // Make the latest samples readable
+    History.flush();
+
+    struct State_t {
+        State_t(const uint64_t serial, const uint32_t start, const uint32_t end, const uint32_t interval)
+            : reader(History.getStore(), serial, start, end)
+            , downsampler(start, interval, HistoryClass::getCumulativeMask())
+        {
+        }
+
+        HistoryReader reader;
+        HistoryDownsampler downsampler;
+        uint8_t count = 0;
+        bool first = true;
+    };
+    auto state = std::make_shared<State_t>(serial, start, end, interval);
+    state->count = History.getStore().getSeriesCount(serial);
+
+    // Header in the first part, one bucket per following part
+    WebApi.sendChunkedJsonResponse(request, [state, serial, start, end, interval](const size_t part, Print& output) {
+        if (part == 0) {
+            output.printf("{\"serial\":\"%012" PRIx64 "\",\"start\":%" PRIu32 ",\"end\":%" PRIu32 ",\"interval\":%" PRIu32 ",\"series\":[",
+                serial, start, end, interval);
+            for (uint8_t i = 0; i < state->count; i++) {
+                output.printf("%s\"%s\"", i > 0 ? "," : "", HistoryClass::getSeriesName(i).c_str());
+            }
+            output.print("],\"data\":[");
+            return true;
+        }
+
+        HistorySample_t sample;
+        HistorySample_t bucket;
+        bool completed = false;
+        bool more = true;
+
+        while (!completed && more) {
+            if (state->reader.next(sample)) {
+                completed = state->downsampler.add(sample, bucket);
+            } else {
+                completed = state->downsampler.finish(bucket);
+                more = false;
+            }
+        }
+
+        if (completed) {
+            output.printf("%s[%" PRIu32, state->first ? "" : ",", bucket.Time);
+            for (uint8_t i = 0; i < state->count; i++) {
+                output.print(',');
+                if (i < bucket.Count) {
+                    const double scale = HistoryClass::getSeriesScale(i);
+                    output.print(bucket.Values[i] * scale, scale < 0.01 ? 3 : (scale < 1 ? 1 : 0));
+                } else {
+                    output.print("null");
+                }
+            }
+            output.print(']');
+            state->first = false;
+        }
+
+        if (!more) {
+            output.print("]}");
+        }
+        return more;
+    });
+}
+
+void WebApiHistoryClass::sendBuckets(AsyncWebServerRequest* request, const uint64_t serial, const HistoryResolution resolution, const uint32_t start, const uint32_t end)
+{
+    // At most a few kB, so the buckets are copied instead of locking the rollup while sending
+    auto buckets = std::make_shared<std::vector<HistoryBucket_t>>(History.getBuckets(serial, resolution, start, end));
+
+    // Header in the first part, one bucket per following part
+    WebApi.sendChunkedJsonResponse(request, [buckets, serial, resolution](const size_t part, Print& output) {
+        if (part == 0) {
+            if (serial == HISTORY_TOTAL_SERIAL) {
+                output.print("{\"serial\":\"total\"");
+            } else {
+                output.printf("{\"serial\":\"%012" PRIx64 "\"", serial);
+            }
+            output.printf(",\"interval\":%" PRIu32 ",\"series\":[\"min\",\"max\",\"avg\",\"energy\"],\"data\":[",
+                HistoryRollup::interval(resolution));
+            return true;
+        }
+
+        const size_t index = part - 1;
+        if (index >= buckets->size()) {
+            output.print("]}");
+            return false;
+        }
+
+        const HistoryBucket_t& bucket = (*buckets)[index];
+        output.printf("%s[%" PRIu32 ",%.1f,%.1f,%.1f,%.1f]", index > 0 ? "," : "",
+            bucket.Start, bucket.Min, bucket.Max, bucket.getAverage(), bucket.Energy);
+        return true;
+    });
+}
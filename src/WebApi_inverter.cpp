@@ -122,30 +122,37 @@ void WebApiInverterClass::onInverterAdd(AsyncWebServerRequest* request)
         return;
     }
 
-    INVERTER_CONFIG_T* inverter = Configuration.getFreeInverterSlot();
+    INVERTER_CONFIG_T inverter;
 
-    if (!inverter) {
-        retMsg["message"] = "Only " STR(INV_MAX_COUNT) " inverters are supported!";
-        retMsg["code"] = WebApiError::InverterCount;
-        retMsg["param"]["max"] = INV_MAX_COUNT;
-        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
-        return;
-    }
+    {
+        auto guard = Configuration.getWriteGuard();
+        INVERTER_CONFIG_T* slot = guard.getFreeInverterSlot();
+
+        if (!slot) {
+            retMsg["message"] = "Only " STR(INV_MAX_COUNT) " inverters are supported!";
+            retMsg["code"] = WebApiError::InverterCount;
+            retMsg["param"]["max"] = INV_MAX_COUNT;
+            WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+            return;
+        }
 
-    // Interpret the string as a hex value and convert it to uint64_t
-    inverter->Serial = serial;
+        // Interpret the string as a hex value and convert it to uint64_t
+        slot->Serial = serial;
+
+        strncpy(slot->Name, root["name"].as<String>().c_str(), INV_MAX_NAME_STRLEN);
 
-    strncpy(inverter->Name, root["name"].as<String>().c_str(), INV_MAX_NAME_STRLEN);
+        inverter = *slot;
+    }
 
     WebApi.writeConfig(retMsg, WebApiError::InverterAdded, "Inverter created!");
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 
-    auto inv = Hoymiles.addInverter(inverter->Name, inverter->Serial);
+    auto inv = Hoymiles.addInverter(inverter.Name, inverter.Serial);
 
     if (inv != nullptr) {
         for (uint8_t c = 0; c < INV_MAX_CHAN_COUNT; c++) {
-            inv->Statistics()->setStringMaxPower(c, inverter->channel[c].MaxChannelPower);
+            inv->Statistics()->setStringMaxPower(c, inverter.channel[c].MaxChannelPower);
         }
     }
 
@@ -305,11 +312,9 @@ void WebApiInverterClass::onInverterDelete(AsyncWebServerRequest* request)
     }
 
     uint8_t inverter_id = root["id"].as<uint8_t>();
-    INVERTER_CONFIG_T const& inverter = Configuration.get().Inverter[inverter_id];
-
-    Hoymiles.removeInverterBySerial(inverter.Serial);
+    Hoymiles.removeInverterBySerial(Configuration.get().Inverter[inverter_id].Serial);
 
-    Configuration.deleteInverterById(inverter_id);
+    Configuration.getWriteGuard().deleteInverterById(inverter_id);
 
     WebApi.writeConfig(retMsg, WebApiError::InverterDeleted, "Inverter deleted!");
 
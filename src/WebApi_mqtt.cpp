@@ -89,6 +89,14 @@ void WebApiMqttClass::onMqttAdminGet(AsyncWebServerRequest* request)
     root["mqtt_hass_retain"] = config.Mqtt.Hass.Retain;
     root["mqtt_hass_topic"] = config.Mqtt.Hass.Topic;
     root["mqtt_hass_individualpanels"] = config.Mqtt.Hass.IndividualPanels;
+    root["mqtt_change_only"] = config.Mqtt.ChangeOnly.Enabled;
+    root["mqtt_change_only_deadband_steps"] = config.Mqtt.ChangeOnly.DeadbandSteps;
+    root["mqtt_change_only_deadband_relative"] = config.Mqtt.ChangeOnly.DeadbandRelative;
+    root["mqtt_change_only_max_age"] = config.Mqtt.ChangeOnly.MaxAge;
+    root["mqtt_aggregated_format"] = config.Mqtt.Aggregated.Format;
+    root["mqtt_aggregated_field_topics"] = config.Mqtt.Aggregated.FieldTopics;
+    root["mqtt_outbox_budget"] = config.Mqtt.Outbox.Budget;
+    root["mqtt_outbox_coalesce"] = config.Mqtt.Outbox.Coalesce;
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 }
@@ -129,7 +137,15 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
             && root["mqtt_hass_expire"].is<bool>()
             && root["mqtt_hass_retain"].is<bool>()
             && root["mqtt_hass_topic"].is<String>()
-            && root["mqtt_hass_individualpanels"].is<bool>())) {
+            && root["mqtt_hass_individualpanels"].is<bool>()
+            && root["mqtt_change_only"].is<bool>()
+            && root["mqtt_change_only_deadband_steps"].is<uint16_t>()
+            && root["mqtt_change_only_deadband_relative"].is<float>()
+            && root["mqtt_change_only_max_age"].is<uint32_t>()
+            && root["mqtt_aggregated_format"].is<uint8_t>()
+            && root["mqtt_aggregated_field_topics"].is<bool>()
+            && root["mqtt_outbox_budget"].is<uint32_t>()
+            && root["mqtt_outbox_coalesce"].is<bool>())) {
         retMsg["message"] = "Values are missing!";
         retMsg["code"] = WebApiError::GenericValueMissing;
         WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
@@ -253,6 +269,59 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
             return;
         }
 
+        if (root["mqtt_change_only"].as<bool>()) {
+            if (root["mqtt_change_only_deadband_steps"].as<uint16_t>() > 10000) {
+                retMsg["message"] = "Deadband must be a number between 0 and 10000 steps!";
+                retMsg["code"] = WebApiError::MqttDeadbandSteps;
+                retMsg["param"]["min"] = 0;
+                retMsg["param"]["max"] = 10000;
+                WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+                return;
+            }
+
+            if (root["mqtt_change_only_deadband_relative"].as<float>() < 0 || root["mqtt_change_only_deadband_relative"].as<float>() > 100) {
+                retMsg["message"] = "Relative deadband must be a number between 0 and 100 %!";
+                retMsg["code"] = WebApiError::MqttDeadbandRelative;
+                retMsg["param"]["min"] = 0;
+                retMsg["param"]["max"] = 100;
+                WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+                return;
+            }
+
+            if (root["mqtt_change_only_max_age"].as<uint32_t>() > 86400) {
+                retMsg["message"] = "Max age must be a number between 0 and 86400!";
+                retMsg["code"] = WebApiError::MqttMaxAge;
+                retMsg["param"]["min"] = 0;
+                retMsg["param"]["max"] = 86400;
+                WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+                return;
+            }
+        }
+
+        if (root["mqtt_aggregated_format"].as<uint8_t>() > static_cast<uint8_t>(MqttAggregatedFormat::Csv)) {
+            retMsg["message"] = "Invalid aggregated payload format!";
+            retMsg["code"] = WebApiError::MqttAggregatedFormat;
+            WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+            return;
+        }
+
+        if (root["mqtt_aggregated_format"].as<uint8_t>() == static_cast<uint8_t>(MqttAggregatedFormat::None)
+            && !root["mqtt_aggregated_field_topics"].as<bool>()) {
+            retMsg["message"] = "Individual value topics are required without aggregated payload!";
+            retMsg["code"] = WebApiError::MqttAggregatedFieldTopics;
+            WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+            return;
+        }
+
+        if (root["mqtt_outbox_budget"].as<uint32_t>() < 1024 || root["mqtt_outbox_budget"].as<uint32_t>() > 131072) {
+            retMsg["message"] = "Outbox budget must be a number between 1024 and 131072!";
+            retMsg["code"] = WebApiError::MqttOutboxBudget;
+            retMsg["param"]["min"] = 1024;
+            retMsg["param"]["max"] = 131072;
+            WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+            return;
+        }
+
         if (root["mqtt_hass_enabled"].as<bool>()) {
             if (root["mqtt_hass_topic"].as<String>().length() > MQTT_MAX_TOPIC_STRLEN) {
                 retMsg["message"] = "Hass topic must not be longer than " STR(MQTT_MAX_TOPIC_STRLEN) " characters!";
@@ -271,6 +340,8 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
         }
     }
 
+    bool topicChanged = false;
+
     {
         auto guard = Configuration.getWriteGuard();
         auto& config = guard.getConfig();
@@ -298,21 +369,35 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
         config.Mqtt.Hass.Retain = root["mqtt_hass_retain"].as<bool>();
         config.Mqtt.Hass.IndividualPanels = root["mqtt_hass_individualpanels"].as<bool>();
         strlcpy(config.Mqtt.Hass.Topic, root["mqtt_hass_topic"].as<String>().c_str(), sizeof(config.Mqtt.Hass.Topic));
+        config.Mqtt.ChangeOnly.Enabled = root["mqtt_change_only"].as<bool>();
+        config.Mqtt.ChangeOnly.DeadbandSteps = root["mqtt_change_only_deadband_steps"].as<uint16_t>();
+        config.Mqtt.ChangeOnly.DeadbandRelative = root["mqtt_change_only_deadband_relative"].as<float>();
+        config.Mqtt.ChangeOnly.MaxAge = root["mqtt_change_only_max_age"].as<uint32_t>();
+        config.Mqtt.Aggregated.Format = root["mqtt_aggregated_format"].as<uint8_t>();
+        config.Mqtt.Aggregated.FieldTopics = root["mqtt_aggregated_field_topics"].as<bool>();
+        config.Mqtt.Outbox.Budget = root["mqtt_outbox_budget"].as<uint32_t>();
+        config.Mqtt.Outbox.Coalesce = root["mqtt_outbox_coalesce"].as<bool>();
 
         // Check if base topic was changed
-        if (strcmp(config.Mqtt.Topic, root["mqtt_topic"].as<String>().c_str())) {
+        topicChanged = strcmp(config.Mqtt.Topic, root["mqtt_topic"].as<String>().c_str());
+        if (topicChanged) {
+            // The prefix is read from the published configuration, which still holds the old topic
             MqttHandleInverter.unsubscribeTopics();
             strlcpy(config.Mqtt.Topic, root["mqtt_topic"].as<String>().c_str(), sizeof(config.Mqtt.Topic));
-            MqttHandleInverter.subscribeTopics();
         }
     }
 
+    if (topicChanged) {
+        MqttHandleInverter.subscribeTopics();
+    }
+
     WebApi.writeConfig(retMsg);
 
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 
     MqttSettings.performReconnect();
     MqttHandleHass.forceUpdate();
+    MqttHandleInverter.forceUpdate();
 }
 
 String WebApiMqttClass::getTlsCertInfo(const char* cert)
@@ -5,10 +5,13 @@
  */
 #include "WebApi_prometheus.h"
 #include "Configuration.h"
+#include "History.h"
+#include "MqttSettings.h"
 #include "NetworkSettings.h"
 #include "WebApi.h"
 #include "__compiled_constants.h"
 #include <Hoymiles.h>
+#include <algorithm>
 
 #undef TAG
 static const char* TAG = "webapi";
@@ -22,111 +25,207 @@ void WebApiPrometheusClass::init(AsyncWebServer& server, Scheduler& scheduler)
 
 void WebApiPrometheusClass::onPrometheusMetricsGet(AsyncWebServerRequest* request)
 {
-    static size_t initialResponseBufferSize = 1024;
-
     if (!WebApi.checkCredentialsReadonly(request)) {
         return;
     }
 
     try {
-        auto stream = request->beginResponseStream("text/plain; charset=utf-8", initialResponseBufferSize);
+        updateExposition();
+    } catch (std::bad_alloc& bad_alloc) {
+        ESP_LOGE(TAG, "Call to /api/prometheus/metrics temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
 
-        stream->print("# HELP opendtu_build Build info\n");
-        stream->print("# TYPE opendtu_build gauge\n");
-        stream->printf("opendtu_build{name=\"%s\",id=\"%s\",version=\"%d.%d.%d\"} 1\n",
-            NetworkSettings.getHostname().c_str(), __COMPILED_GIT_HASH__, CONFIG_VERSION >> 24 & 0xff, CONFIG_VERSION >> 16 & 0xff, CONFIG_VERSION >> 8 & 0xff);
+        // Partially rendered parts must not be served
+        _parts.clear();
+        WebApi.sendTooManyRequests(request);
+        return;
+    }
 
-        stream->print("# HELP opendtu_platform Platform info\n");
-        stream->print("# TYPE opendtu_platform gauge\n");
-        stream->printf("opendtu_platform{arch=\"%s\",mac=\"%s\"} 1\n", ESP.getChipModel(), NetworkSettings.macAddress().c_str());
+    // The response keeps its own references to the parts, so the cache
+    // can be updated by another scrape while this one is still sent
+    std::vector<std::shared_ptr<StreamString>> texts;
+    texts.reserve(_parts.size());
+    for (const auto& part : _parts) {
+        texts.push_back(part.Text);
+    }
 
-        stream->print("# HELP opendtu_uptime Uptime in seconds\n");
-        stream->print("# TYPE opendtu_uptime counter\n");
-        stream->printf("opendtu_uptime %lld\n", esp_timer_get_time() / 1000000);
+    auto response = request->beginResponse("text/plain; charset=utf-8", _length, [texts](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+        size_t len = 0;
+        for (const auto& text : texts) {
+            if (index >= text->length()) {
+                index -= text->length();
+                continue;
+            }
+            const size_t chunk = std::min(maxLen - len, text->length() - index);
+            memcpy(buffer + len, text->c_str() + index, chunk);
+            len += chunk;
+            index = 0;
+            if (len == maxLen) {
+                break;
+            }
+        }
+        return len;
+    });
 
-        stream->print("# HELP opendtu_heap_size System memory size\n");
-        stream->print("# TYPE opendtu_heap_size gauge\n");
-        stream->printf("opendtu_heap_size %" PRIu32 "\n", ESP.getHeapSize());
+    request->send(response);
+}
 
-        stream->print("# HELP opendtu_free_heap_size System free memory\n");
-        stream->print("# TYPE opendtu_free_heap_size gauge\n");
-        stream->printf("opendtu_free_heap_size %" PRIu32 "\n", ESP.getFreeHeap());
+void WebApiPrometheusClass::updateExposition()
+{
+    const uint8_t inverterCount = Hoymiles.getNumInverters();
+    const bool expired = _parts.size() != inverterCount + 1U
+        || millis() - _lastRender >= PROMETHEUS_CACHE_MAX_AGE;
 
-        stream->print("# HELP opendtu_biggest_heap_block Biggest free heap block\n");
-        stream->print("# TYPE opendtu_biggest_heap_block gauge\n");
-        stream->printf("opendtu_biggest_heap_block %" PRIu32 "\n", ESP.getMaxAllocHeap());
+    _parts.resize(inverterCount + 1);
 
-        stream->print("# HELP opendtu_heap_min_free Minimum free memory since boot\n");
-        stream->print("# TYPE opendtu_heap_min_free gauge\n");
-        stream->printf("opendtu_heap_min_free %" PRIu32 "\n", ESP.getMinFreeHeap());
+    bool changed = expired;
+    for (uint8_t i = 0; i < inverterCount; i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        auto& part = _parts[i + 1];
 
-        stream->print("# HELP wifi_rssi WiFi RSSI\n");
-        stream->print("# TYPE wifi_rssi gauge\n");
-        stream->printf("wifi_rssi %" PRId8 "\n", WiFi.RSSI());
+        // Every update of a parser uses a newer timestamp
+        const uint32_t lastUpdate = std::max({
+            inv->Statistics()->getLastUpdateFromInternal(),
+            inv->SystemConfigPara()->getLastUpdate(),
+            inv->DevInfo()->getLastUpdate(),
+        });
 
-        stream->print("# HELP wifi_station WiFi Station info\n");
-        stream->print("# TYPE wifi_station gauge\n");
-        stream->printf("wifi_station{bssid=\"%s\"} 1\n", WiFi.BSSIDstr().c_str());
+        if (!expired && part.Serial == inv->serial() && part.LastUpdate == lastUpdate) {
+            continue;
+        }
 
-        for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-            auto inv = Hoymiles.getInverterByPos(i);
+        part.Serial = inv->serial();
+        part.LastUpdate = lastUpdate;
+        addInverter(clearPart(part), i, inv);
+        changed = true;
+    }
 
-            String serial = inv->serialString();
-            const char* name = inv->name();
-            if (i == 0) {
-                stream->print("# HELP opendtu_last_update last update from inverter in s\n");
-                stream->print("# TYPE opendtu_last_update gauge\n");
-            }
-            stream->printf("opendtu_last_update{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %" PRIu32 "\n",
-                serial.c_str(), i, name, inv->Statistics()->getLastUpdate() / 1000);
+    if (!changed) {
+        return;
+    }
 
-            if (i == 0) {
-                stream->print("# HELP opendtu_inverter_limit_relative current relative limit of the inverter\n");
-                stream->print("# TYPE opendtu_inverter_limit_relative gauge\n");
-            }
-            stream->printf("opendtu_inverter_limit_relative{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %f\n",
-                serial.c_str(), i, name, inv->SystemConfigPara()->getLimitPercent() / 100.0);
+    // The system metrics are refreshed together with every change of the inverter parts
+    addSystemInfo(clearPart(_parts[0]));
+    _lastRender = millis();
 
-            if (inv->DevInfo()->getMaxPower() > 0) {
-                if (i == 0) {
-                    stream->print("# HELP opendtu_inverter_limit_absolute current relative limit of the inverter\n");
-                    stream->print("# TYPE opendtu_inverter_limit_absolute gauge\n");
-                }
-                stream->printf("opendtu_inverter_limit_absolute{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %f\n",
-                    serial.c_str(), i, name, inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0);
-            }
+    _length = 0;
+    for (const auto& part : _parts) {
+        _length += part.Text->length();
+    }
+}
 
-            // Loop all channels if Statistics have been updated at least once since DTU boot
-            if (inv->Statistics()->getLastUpdate() > 0) {
-                for (auto& t : inv->Statistics()->getChannelTypes()) {
-                    for (auto& c : inv->Statistics()->getChannelsByType(t)) {
-                        addPanelInfo(stream, serial, i, inv, t, c);
-                        for (uint8_t f = 0; f < sizeof(_publishFields) / sizeof(_publishFields[0]); f++) {
-                            if (t == TYPE_INV && _publishFields[f].field == FLD_PDC) {
-                                addField(stream, serial, i, inv, t, c, _publishFields[f].field, _metricTypes[_publishFields[f].type], "PowerDC");
-                            } else {
-                                addField(stream, serial, i, inv, t, c, _publishFields[f].field, _metricTypes[_publishFields[f].type]);
-                            }
-                        }
+StreamString* WebApiPrometheusClass::clearPart(ExpositionPart_t& part)
+{
+    // A response which is still being sent keeps the previous text
+    if (!part.Text || part.Text.use_count() > 1) {
+        part.Text = std::make_shared<StreamString>();
+    } else {
+        // Keeps the capacity for the next render
+        part.Text->remove(0);
+    }
+    return part.Text.get();
+}
+
+void WebApiPrometheusClass::addSystemInfo(Print* stream)
+{
+    stream->print("# HELP opendtu_build Build info\n");
+    stream->print("# TYPE opendtu_build gauge\n");
+    stream->printf("opendtu_build{name=\"%s\",id=\"%s\",version=\"%d.%d.%d\"} 1\n",
+        NetworkSettings.getHostname().c_str(), __COMPILED_GIT_HASH__, CONFIG_VERSION >> 24 & 0xff, CONFIG_VERSION >> 16 & 0xff, CONFIG_VERSION >> 8 & 0xff);
+
+    stream->print("# HELP opendtu_platform Platform info\n");
+    stream->print("# TYPE opendtu_platform gauge\n");
+    stream->printf("opendtu_platform{arch=\"%s\",mac=\"%s\"} 1\n", ESP.getChipModel(), NetworkSettings.macAddress().c_str());
+
+    stream->print("# HELP opendtu_uptime Uptime in seconds\n");
+    stream->print("# TYPE opendtu_uptime counter\n");
+    stream->printf("opendtu_uptime %lld\n", esp_timer_get_time() / 1000000);
+
+    stream->print("# HELP opendtu_heap_size System memory size\n");
+    stream->print("# TYPE opendtu_heap_size gauge\n");
+    stream->printf("opendtu_heap_size %" PRIu32 "\n", ESP.getHeapSize());
+
+    stream->print("# HELP opendtu_free_heap_size System free memory\n");
+    stream->print("# TYPE opendtu_free_heap_size gauge\n");
+    stream->printf("opendtu_free_heap_size %" PRIu32 "\n", ESP.getFreeHeap());
+
+    stream->print("# HELP opendtu_biggest_heap_block Biggest free heap block\n");
+    stream->print("# TYPE opendtu_biggest_heap_block gauge\n");
+    stream->printf("opendtu_biggest_heap_block %" PRIu32 "\n", ESP.getMaxAllocHeap());
+
+    stream->print("# HELP opendtu_heap_min_free Minimum free memory since boot\n");
+    stream->print("# TYPE opendtu_heap_min_free gauge\n");
+    stream->printf("opendtu_heap_min_free %" PRIu32 "\n", ESP.getMinFreeHeap());
+
+    stream->print("# HELP wifi_rssi WiFi RSSI\n");
+    stream->print("# TYPE wifi_rssi gauge\n");
+    stream->printf("wifi_rssi %" PRId8 "\n", WiFi.RSSI());
+
+    stream->print("# HELP wifi_station WiFi Station info\n");
+    stream->print("# TYPE wifi_station gauge\n");
+    stream->printf("wifi_station{bssid=\"%s\"} 1\n", WiFi.BSSIDstr().c_str());
+
+    addQueueWaitStats(stream);
+    addCommandStats(stream);
+    addMqttStats(stream);
+    addHistoryStats(stream);
+}
+
+void WebApiPrometheusClass::addInverter(Print* stream, const uint8_t idx, std::shared_ptr<InverterAbstract> inv)
+{
+    String serial = inv->serialString();
+    const char* name = inv->name();
+    if (idx == 0) {
+        stream->print("# HELP opendtu_last_update last update from inverter in s\n");
+        stream->print("# TYPE opendtu_last_update gauge\n");
+    }
+    stream->printf("opendtu_last_update{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %" PRIu32 "\n",
+        serial.c_str(), idx, name, inv->Statistics()->getLastUpdate() / 1000);
+
+    if (idx == 0) {
+        stream->print("# HELP opendtu_poll_interval effective time between two polls of the inverter in s\n");
+        stream->print("# TYPE opendtu_poll_interval gauge\n");
+    }
+    stream->printf("opendtu_poll_interval{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %.3f\n",
+        serial.c_str(), idx, name, inv->PollState.EffectiveInterval / 1000.0);
+
+    if (idx == 0) {
+        stream->print("# HELP opendtu_inverter_limit_relative current relative limit of the inverter\n");
+        stream->print("# TYPE opendtu_inverter_limit_relative gauge\n");
+    }
+    stream->printf("opendtu_inverter_limit_relative{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %f\n",
+        serial.c_str(), idx, name, inv->SystemConfigPara()->getLimitPercent() / 100.0);
+
+    if (inv->DevInfo()->getMaxPower() > 0) {
+        if (idx == 0) {
+            stream->print("# HELP opendtu_inverter_limit_absolute current relative limit of the inverter\n");
+            stream->print("# TYPE opendtu_inverter_limit_absolute gauge\n");
+        }
+        stream->printf("opendtu_inverter_limit_absolute{serial=\"%s\",unit=\"%" PRIu8 "\",name=\"%s\"} %f\n",
+            serial.c_str(), idx, name, inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0);
+    }
+
+    // Loop all channels if Statistics have been updated at least once since DTU boot
+    if (inv->Statistics()->getLastUpdate() > 0) {
+        // All values of the same frame
+        std::vector<float> values;
+        inv->Statistics()->getFieldValues(values);
+
+        for (auto& t : inv->Statistics()->getChannelTypes()) {
+            for (auto& c : inv->Statistics()->getChannelsByType(t)) {
+                addPanelInfo(stream, serial, idx, inv, t, c);
+                for (uint8_t f = 0; f < sizeof(_publishFields) / sizeof(_publishFields[0]); f++) {
+                    if (t == TYPE_INV && _publishFields[f].field == FLD_PDC) {
+                        addField(stream, serial, idx, inv, values, t, c, _publishFields[f].field, _metricTypes[_publishFields[f].type], "PowerDC");
+                    } else {
+                        addField(stream, serial, idx, inv, values, t, c, _publishFields[f].field, _metricTypes[_publishFields[f].type]);
                     }
                 }
             }
         }
-        stream->addHeader("Cache-Control", "no-cache");
-        if (stream->available() > initialResponseBufferSize) {
-            initialResponseBufferSize = stream->available();
-            ESP_LOGI(TAG, "Increased /api/prometheus/metrics initialResponseBufferSize to %" PRIu32 " bytes", initialResponseBufferSize);
-        }
-        request->send(stream);
-
-    } catch (std::bad_alloc& bad_alloc) {
-        ESP_LOGE(TAG, "Call to /api/prometheus/metrics temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
-
-        WebApi.sendTooManyRequests(request);
     }
 }
 
-void WebApiPrometheusClass::addField(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* metricName, const char* channelName)
+void WebApiPrometheusClass::addField(Print* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const std::vector<float>& values, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, const char* metricName, const char* channelName)
 {
     if (inv->Statistics()->hasChannelFieldValue(type, channel, fieldId)) {
         const char* chanName = (channelName == nullptr) ? inv->Statistics()->getChannelFieldName(type, channel, fieldId) : channelName;
@@ -141,11 +240,11 @@ void WebApiPrometheusClass::addField(AsyncResponseStream* stream, const String&
             inv->name(),
             inv->Statistics()->getChannelTypeName(type),
             channel,
-            inv->Statistics()->getChannelFieldValueString(type, channel, fieldId).c_str());
+            String(inv->Statistics()->getChannelFieldValue(values, type, channel, fieldId), static_cast<unsigned int>(inv->Statistics()->getChannelFieldDigits(type, channel, fieldId))).c_str());
     }
 }
 
-void WebApiPrometheusClass::addPanelInfo(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel)
+void WebApiPrometheusClass::addPanelInfo(Print* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel)
 {
     if (type != TYPE_DC) {
         return;
@@ -187,3 +286,135 @@ void WebApiPrometheusClass::addPanelInfo(AsyncResponseStream* stream, const Stri
         channel,
         config->channel[channel].YieldTotalOffset);
 }
+
+void WebApiPrometheusClass::addQueueWaitStats(Print* stream)
+{
+    const std::pair<const char*, HoymilesRadio*> radios[] = {
+        { "nrf", Hoymiles.getRadioNrf() },
+        { "cmt", Hoymiles.getRadioCmt() },
+    };
+
+    stream->print("# HELP opendtu_radio_queue_wait_seconds time between queuing a command and its first transmission\n");
+    stream->print("# TYPE opendtu_radio_queue_wait_seconds summary\n");
+    for (const auto& [name, radio] : radios) {
+        if (!radio->isInitialized()) {
+            continue;
+        }
+        for (uint8_t p = 0; p < COMMAND_PRIORITY_COUNT; p++) {
+            const auto stats = radio->getQueueWaitStats(static_cast<CommandPriority>(p));
+            stream->printf("opendtu_radio_queue_wait_seconds_sum{radio=\"%s\",priority=\"%s\"} %.3f\n",
+                name, _commandPriorities[p], stats.TotalWait / 1000.0);
+            stream->printf("opendtu_radio_queue_wait_seconds_count{radio=\"%s\",priority=\"%s\"} %" PRIu32 "\n",
+                name, _commandPriorities[p], stats.Count);
+        }
+    }
+
+    stream->print("# HELP opendtu_radio_queue_wait_max_seconds longest time a command waited in the queue since boot\n");
+    stream->print("# TYPE opendtu_radio_queue_wait_max_seconds gauge\n");
+    for (const auto& [name, radio] : radios) {
+        if (!radio->isInitialized()) {
+            continue;
+        }
+        for (uint8_t p = 0; p < COMMAND_PRIORITY_COUNT; p++) {
+            const auto stats = radio->getQueueWaitStats(static_cast<CommandPriority>(p));
+            stream->printf("opendtu_radio_queue_wait_max_seconds{radio=\"%s\",priority=\"%s\"} %.3f\n",
+                name, _commandPriorities[p], stats.MaxWait / 1000.0);
+        }
+    }
+}
+
+template <typename T>
+void WebApiPrometheusClass::addHistogram(Print* stream, const char* metricName, const char* radio, const char* command, const T& histogram, const double divisor)
+{
+    uint32_t cumulative = 0;
+    for (size_t b = 0; b < T::size() - 1; b++) {
+        cumulative += histogram.getBucket(b);
+        stream->printf("%s_bucket{radio=\"%s\",command=\"%s\",le=\"%g\"} %" PRIu32 "\n",
+            metricName, radio, command, T::getUpperBound(b) / divisor, cumulative);
+    }
+    stream->printf("%s_bucket{radio=\"%s\",command=\"%s\",le=\"+Inf\"} %" PRIu32 "\n",
+        metricName, radio, command, histogram.getCount());
+    stream->printf("%s_sum{radio=\"%s\",command=\"%s\"} %g\n",
+        metricName, radio, command, histogram.getSum() / divisor);
+    stream->printf("%s_count{radio=\"%s\",command=\"%s\"} %" PRIu32 "\n",
+        metricName, radio, command, histogram.getCount());
+}
+
+void WebApiPrometheusClass::addCommandStats(Print* stream)
+{
+    const std::pair<const char*, HoymilesRadio*> radios[] = {
+        { "nrf", Hoymiles.getRadioNrf() },
+        { "cmt", Hoymiles.getRadioCmt() },
+    };
+
+    auto addMetric = [&](const char* metricName, const char* help, auto getHistogram, const double divisor) {
+        stream->printf("# HELP %s %s\n", metricName, help);
+        stream->printf("# TYPE %s histogram\n", metricName);
+        for (const auto& [name, radio] : radios) {
+            if (!radio->isInitialized()) {
+                continue;
+            }
+            for (uint8_t c = 0; c < COMMAND_TYPE_COUNT; c++) {
+                const auto type = static_cast<CommandType>(c);
+                const auto& stats = radio->getCommandStats(type);
+                // Skip commands which were never sent by this radio
+                if (stats.QueueWait.getCount() == 0) {
+                    continue;
+                }
+                addHistogram(stream, metricName, name, CommandAbstract::getCommandTypeName(type), getHistogram(stats), divisor);
+            }
+        }
+    };
+
+    // The queue wait is exported per priority class by addQueueWaitStats()
+    addMetric("opendtu_radio_command_exchange_seconds", "time between the first transmission of a command and its completion",
+        [](const HoymilesRadio::CommandStats_t& s) -> const auto& { return s.Exchange; }, 1000.0);
+    addMetric("opendtu_radio_command_retransmits", "resent requests and re-requested fragments per command",
+        [](const HoymilesRadio::CommandStats_t& s) -> const auto& { return s.Retransmits; }, 1.0);
+    addMetric("opendtu_radio_command_rssi_dbm", "RSSI of successfully received commands",
+        [](const HoymilesRadio::CommandStats_t& s) -> const auto& { return s.Rssi; }, 1.0);
+}
+
+void WebApiPrometheusClass::addMqttStats(Print* stream)
+{
+    const auto stats = MqttSettings.getOutboxStats();
+
+    stream->print("# HELP opendtu_mqtt_outbox_messages MQTT messages waiting in the outbox\n");
+    stream->print("# TYPE opendtu_mqtt_outbox_messages gauge\n");
+    stream->printf("opendtu_mqtt_outbox_messages %zu\n", stats.Messages);
+
+    stream->print("# HELP opendtu_mqtt_outbox_bytes memory used by the MQTT outbox\n");
+    stream->print("# TYPE opendtu_mqtt_outbox_bytes gauge\n");
+    stream->printf("opendtu_mqtt_outbox_bytes %zu\n", stats.Bytes);
+
+    stream->print("# HELP opendtu_mqtt_outbox_budget_bytes effective memory budget of the MQTT outbox, limited by the free heap\n");
+    stream->print("# TYPE opendtu_mqtt_outbox_budget_bytes gauge\n");
+    stream->printf("opendtu_mqtt_outbox_budget_bytes %zu\n", stats.Budget);
+
+    stream->print("# HELP opendtu_mqtt_client_queue_messages MQTT messages queued in the client\n");
+    stream->print("# TYPE opendtu_mqtt_client_queue_messages gauge\n");
+    stream->printf("opendtu_mqtt_client_queue_messages %zu\n", stats.ClientQueue);
+
+    stream->print("# HELP opendtu_mqtt_outbox_dropped_total MQTT messages dropped because the outbox budget was exceeded\n");
+    stream->print("# TYPE opendtu_mqtt_outbox_dropped_total counter\n");
+    stream->printf("opendtu_mqtt_outbox_dropped_total %" PRIu32 "\n", stats.Dropped);
+
+    stream->print("# HELP opendtu_mqtt_outbox_coalesced_total MQTT messages replaced by a newer message of the same topic\n");
+    stream->print("# TYPE opendtu_mqtt_outbox_coalesced_total counter\n");
+    stream->printf("opendtu_mqtt_outbox_coalesced_total %" PRIu32 "\n", stats.Coalesced);
+}
+
+void WebApiPrometheusClass::addHistoryStats(Print* stream)
+{
+    stream->print("# HELP opendtu_history_segments segment files of the history store\n");
+    stream->print("# TYPE opendtu_history_segments gauge\n");
+    stream->printf("opendtu_history_segments %" PRIu32 "\n", History.getStore().getSegmentCount());
+
+    stream->print("# HELP opendtu_history_segments_max maximum segment files of the history store\n");
+    stream->print("# TYPE opendtu_history_segments_max gauge\n");
+    stream->printf("opendtu_history_segments_max %" PRIu32 "\n", History.getStore().getMaxSegments());
+
+    stream->print("# HELP opendtu_history_rollup_bytes memory used by the history rollups\n");
+    stream->print("# TYPE opendtu_history_rollup_bytes gauge\n");
+    stream->printf("opendtu_history_rollup_bytes %zu\n", History.getRollupBytes());
+}
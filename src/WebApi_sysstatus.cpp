@@ -4,6 +4,8 @@
  */
 #include "WebApi_sysstatus.h"
 #include "Configuration.h"
+#include "History.h"
+#include "MqttSettings.h"
 #include "NetworkSettings.h"
 #include "PinMapping.h"
 #include "WebApi.h"
@@ -93,5 +95,20 @@ void WebApiSysstatusClass::onSystemStatus(AsyncWebServerRequest* request)
     root["cmt_configured"] = PinMapping.isValidCmt2300Config();
     root["cmt_connected"] = Hoymiles.getRadioCmt()->isConnected();
 
+    const auto outbox = MqttSettings.getOutboxStats();
+    JsonObject mqttOutbox = root["mqtt_outbox"].to<JsonObject>();
+    mqttOutbox["messages"] = outbox.Messages;
+    mqttOutbox["bytes"] = outbox.Bytes;
+    mqttOutbox["budget"] = outbox.Budget;
+    mqttOutbox["client_queue"] = outbox.ClientQueue;
+    mqttOutbox["dropped"] = outbox.Dropped;
+    mqttOutbox["coalesced"] = outbox.Coalesced;
+
+    JsonObject history = root["history"].to<JsonObject>();
+    history["segments"] = History.getStore().getSegmentCount();
+    history["max_segments"] = History.getStore().getMaxSegments();
+    history["rollups"] = History.getRollupCount();
+    history["rollup_bytes"] = History.getRollupBytes();
+
     WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
 }
@@ -8,6 +8,7 @@
 #include "WebApi.h"
 #include "defaults.h"
 #include <AsyncJson.h>
+#include <cmath>
 
 #undef TAG
 static const char* TAG = "webapi";
@@ -78,6 +79,24 @@ void WebApiWsLiveClass::sendDataTaskCb()
         return;
     }
 
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    bool hasDeltaClients = false;
+    {
+        std::lock_guard<std::mutex> clientsLock(_clientsMutex);
+        for (const auto& client : _clients) {
+            hasDeltaClients |= client.second.Delta;
+        }
+    }
+
+    if (hasDeltaClients && updateDeltaFields()) {
+        // The ids changed, so every delta client requires a new snapshot
+        std::lock_guard<std::mutex> clientsLock(_clientsMutex);
+        for (auto& client : _clients) {
+            client.second.SnapshotRequired = client.second.Delta;
+        }
+    }
+
     // Loop all inverters
     for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
         auto inv = Hoymiles.getInverterByPos(i);
@@ -85,15 +104,23 @@ void WebApiWsLiveClass::sendDataTaskCb()
             continue;
         }
 
+        // Has to be done for every inverter to keep the values of the snapshot in sync
+        _deltaChanges.clear();
+        if (hasDeltaClients) {
+            collectDeltaChanges(inv);
+        }
+
         const uint32_t lastUpdateInternal = inv->Statistics()->getLastUpdateFromInternal();
-        if (!((lastUpdateInternal > 0 && lastUpdateInternal > _lastPublishStats[i]) || (millis() - _lastPublishStats[i] > (10 * 1000)))) {
+        const bool publish = (lastUpdateInternal > 0 && lastUpdateInternal > _lastPublishStats[i]) || (millis() - _lastPublishStats[i] > (10 * 1000));
+        if (!publish && _deltaChanges.empty()) {
             continue;
         }
 
-        _lastPublishStats[i] = millis();
+        if (publish) {
+            _lastPublishStats[i] = millis();
+        }
 
         try {
-            std::lock_guard<std::mutex> lock(_mutex);
             JsonDocument root;
             JsonVariant var = root;
 
@@ -102,16 +129,40 @@ void WebApiWsLiveClass::sendDataTaskCb()
 
             generateCommonJsonResponse(var);
             generateInverterCommonJsonResponse(invObject, inv);
-            generateInverterChannelJsonResponse(invObject, inv);
 
-            if (!Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
-                continue;
+            // The histograms change slowly, don't attach them to every message.
+            // Not every message is sent to both groups, so they are tracked per group.
+            const bool commandStats = (hasDeltaClients && millis() - _lastPublishCommandStatsDelta > (10 * 1000))
+                || (publish && millis() - _lastPublishCommandStatsFull > (10 * 1000));
+            if (commandStats) {
+                generateCommandStatsJsonResponse(var);
             }
 
-            String buffer;
-            serializeJson(root, buffer);
+            if (hasDeltaClients) {
+                // Changed values as pairs of id and value
+                root["v"] = 2;
+                auto deltaArray = root["d"].to<JsonArray>();
+                for (const auto id : _deltaChanges) {
+                    deltaArray.add(id);
+                    deltaArray.add(_deltaFields[id].Value);
+                }
 
-            _ws.textAll(buffer);
+                sendToClients(root, ClientGroup::Delta);
+                if (commandStats) {
+                    _lastPublishCommandStatsDelta = millis();
+                }
+
+                root.remove("v");
+                root.remove("d");
+            }
+
+            if (publish) {
+                generateInverterChannelJsonResponse(invObject, inv);
+                sendToClients(root, ClientGroup::Full);
+                if (commandStats) {
+                    _lastPublishCommandStatsFull = millis();
+                }
+            }
 
         } catch (const std::bad_alloc& bad_alloc) {
             ESP_LOGE(TAG, "Call to /api/livedata/status temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
@@ -119,6 +170,140 @@ void WebApiWsLiveClass::sendDataTaskCb()
             ESP_LOGE(TAG, "Unknown exception in /api/livedata/status. Reason: \"%s\".", exc.what());
         }
     }
+
+    // Clients which connected during this run will get their snapshot with the next one
+    if (hasDeltaClients) {
+        sendSnapshots();
+    }
+}
+
+void WebApiWsLiveClass::sendSnapshots()
+{
+    if (!hasClients(ClientGroup::Snapshot)) {
+        return;
+    }
+
+    try {
+        JsonDocument root;
+        JsonVariant var = root;
+
+        root["v"] = 2;
+        auto invArray = var["inverters"].to<JsonArray>();
+        auto idArray = var["ids"].to<JsonArray>();
+
+        for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            if (inv == nullptr) {
+                continue;
+            }
+
+            const uint8_t invIdx = invArray.size();
+            auto invObject = invArray.add<JsonObject>();
+            generateInverterCommonJsonResponse(invObject, inv);
+            generateInverterChannelJsonResponse(invObject, inv);
+
+            // Every id is described by [index in inverters, channel type, channel, field name]
+            for (size_t id = 0; id < _deltaFields.size(); id++) {
+                const auto& field = _deltaFields[id];
+                if (field.Serial != inv->serial()) {
+                    continue;
+                }
+                auto idObject = idArray.add<JsonArray>();
+                idObject.add(invIdx);
+                idObject.add(inv->Statistics()->getChannelTypeName(field.Type));
+                idObject.add(static_cast<uint8_t>(field.Channel));
+                idObject.add(getLiveFieldName(inv, field.Type, field.Channel, field.Field));
+            }
+        }
+
+        generateCommonJsonResponse(var);
+
+        sendToClients(root, ClientGroup::Snapshot);
+
+    } catch (const std::bad_alloc& bad_alloc) {
+        ESP_LOGE(TAG, "Call to /api/livedata/status temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
+    } catch (const std::exception& exc) {
+        ESP_LOGE(TAG, "Unknown exception in /api/livedata/status. Reason: \"%s\".", exc.what());
+    }
+}
+
+WebApiWsLiveClass::ClientGroup WebApiWsLiveClass::getClientGroup(const ClientState_t& state)
+{
+    if (!state.Delta) {
+        return ClientGroup::Full;
+    }
+    return state.SnapshotRequired ? ClientGroup::Snapshot : ClientGroup::Delta;
+}
+
+bool WebApiWsLiveClass::hasClients(const ClientGroup group)
+{
+    std::lock_guard<std::mutex> lock(_clientsMutex);
+
+    for (auto& client : _ws.getClients()) {
+        if (client.status() != WS_CONNECTED) {
+            continue;
+        }
+
+        const auto it = _clients.find(client.id());
+        if (getClientGroup(it == _clients.end() ? ClientState_t() : it->second) == group) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WebApiWsLiveClass::sendToClients(JsonDocument& root, const ClientGroup group)
+{
+    if (!hasClients(group) || !Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
+        return;
+    }
+
+    // Serialize at most once per encoding and share the buffer between all clients
+    std::shared_ptr<std::vector<uint8_t>> jsonBuffer;
+    std::shared_ptr<std::vector<uint8_t>> msgPackBuffer;
+
+    for (auto& client : _ws.getClients()) {
+        if (client.status() != WS_CONNECTED) {
+            continue;
+        }
+
+        bool messagePack;
+        {
+            std::lock_guard<std::mutex> lock(_clientsMutex);
+            const auto it = _clients.find(client.id());
+            if (it == _clients.end()) {
+                if (group != ClientGroup::Full) {
+                    continue;
+                }
+                messagePack = false;
+            } else {
+                if (getClientGroup(it->second) != group) {
+                    continue;
+                }
+                it->second.SnapshotRequired = false;
+                messagePack = it->second.MessagePack;
+            }
+        }
+
+        if (messagePack) {
+            if (msgPackBuffer == nullptr) {
+                const size_t len = measureMsgPack(root);
+                msgPackBuffer = std::make_shared<std::vector<uint8_t>>(len + 1);
+                serializeMsgPack(root, msgPackBuffer->data(), msgPackBuffer->size());
+                msgPackBuffer->resize(len);
+            }
+            client.binary(msgPackBuffer);
+        } else {
+            if (jsonBuffer == nullptr) {
+                const size_t len = measureJson(root);
+                jsonBuffer = std::make_shared<std::vector<uint8_t>>(len + 1);
+                serializeJson(root, reinterpret_cast<char*>(jsonBuffer->data()), jsonBuffer->size());
+                jsonBuffer->resize(len);
+            }
+            client.text(jsonBuffer);
+        }
+    }
 }
 
 void WebApiWsLiveClass::generateCommonJsonResponse(JsonVariant& root)
@@ -137,6 +322,124 @@ void WebApiWsLiveClass::generateCommonJsonResponse(JsonVariant& root)
     hintObj["pin_mapping_issue"] = PIN_MAPPING_REQUIRED && !PinMapping.isMappingSelected();
 }
 
+bool WebApiWsLiveClass::updateDeltaFields()
+{
+    size_t id = 0;
+    bool changed = false;
+
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        if (inv == nullptr) {
+            continue;
+        }
+
+        forEachLiveField(inv, [&](const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) {
+            if (id >= _deltaFields.size()
+                || _deltaFields[id].Serial != inv->serial()
+                || _deltaFields[id].Type != type
+                || _deltaFields[id].Channel != channel
+                || _deltaFields[id].Field != fieldId) {
+                changed = true;
+            }
+            id++;
+        });
+    }
+
+    if (!changed && id == _deltaFields.size()) {
+        return false;
+    }
+
+    _deltaFields.clear();
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        if (inv == nullptr) {
+            continue;
+        }
+
+        forEachLiveField(inv, [&](const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) {
+            _deltaFields.push_back({ inv->serial(), type, channel, fieldId, NAN });
+        });
+    }
+
+    return true;
+}
+
+void WebApiWsLiveClass::collectDeltaChanges(std::shared_ptr<InverterAbstract> inv)
+{
+    inv->Statistics()->getFieldValues(_deltaValues);
+
+    for (size_t id = 0; id < _deltaFields.size(); id++) {
+        auto& field = _deltaFields[id];
+        if (field.Serial != inv->serial()) {
+            continue;
+        }
+
+        const float value = inv->Statistics()->getChannelFieldValue(_deltaValues, field.Type, field.Channel, field.Field);
+        // Also true for the initial NAN
+        if (!(value == field.Value)) {
+            field.Value = value;
+            _deltaChanges.push_back(id);
+        }
+    }
+}
+
+template <typename T>
+static void addHistogram(JsonObject root, const char* name, const T& histogram)
+{
+    auto histObj = root[name].to<JsonObject>();
+    histObj["sum"] = histogram.getSum();
+    auto bucketArray = histObj["buckets"].to<JsonArray>();
+    for (size_t b = 0; b < T::size(); b++) {
+        bucketArray.add(histogram.getBucket(b));
+    }
+}
+
+template <typename T>
+static void addHistogramBounds(JsonObject root, const char* name)
+{
+    // The last bucket (+Inf) has no upper bound
+    auto boundArray = root[name].to<JsonArray>();
+    for (size_t b = 0; b < T::size() - 1; b++) {
+        boundArray.add(T::getUpperBound(b));
+    }
+}
+
+void WebApiWsLiveClass::generateCommandStatsJsonResponse(JsonVariant& root)
+{
+    auto statsObj = root["command_stats"].to<JsonObject>();
+
+    auto boundsObj = statsObj["bounds"].to<JsonObject>();
+    addHistogramBounds<HoymilesRadio::LatencyHistogram_t>(boundsObj, "latency");
+    addHistogramBounds<HoymilesRadio::RetransmitHistogram_t>(boundsObj, "retransmits");
+    addHistogramBounds<HoymilesRadio::RssiHistogram_t>(boundsObj, "rssi");
+
+    const std::pair<const char*, HoymilesRadio*> radios[] = {
+        { "nrf", Hoymiles.getRadioNrf() },
+        { "cmt", Hoymiles.getRadioCmt() },
+    };
+
+    for (const auto& [name, radio] : radios) {
+        if (!radio->isInitialized()) {
+            continue;
+        }
+
+        auto radioObj = statsObj[name].to<JsonObject>();
+        for (uint8_t c = 0; c < COMMAND_TYPE_COUNT; c++) {
+            const auto type = static_cast<CommandType>(c);
+            const auto& stats = radio->getCommandStats(type);
+            if (stats.QueueWait.getCount() == 0) {
+                continue;
+            }
+
+            auto cmdObj = radioObj[CommandAbstract::getCommandTypeName(type)].to<JsonObject>();
+            addHistogram(cmdObj, "queue_wait", stats.QueueWait);
+            addHistogram(cmdObj, "exchange", stats.Exchange);
+            addHistogram(cmdObj, "retransmits", stats.Retransmits);
+            addHistogram(cmdObj, "rssi", stats.Rssi);
+        }
+    }
+}
+
 void WebApiWsLiveClass::generateInverterCommonJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv)
 {
     const INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
@@ -165,6 +468,13 @@ void WebApiWsLiveClass::generateInverterCommonJsonResponse(JsonObject& root, std
     root["radio_stats"]["rx_fail_partial"] = inv->RadioStats.RxFailPartialAnswer;
     root["radio_stats"]["rx_fail_corrupt"] = inv->RadioStats.RxFailCorruptData;
     root["radio_stats"]["rssi"] = inv->getLastRssi();
+    root["radio_stats"]["poll_interval"] = inv->PollState.EffectiveInterval;
+
+    if (inv->Statistics()->hasChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG)) {
+        root["events"] = inv->EventLog()->getEntryCount();
+    } else {
+        root["events"] = -1;
+    }
 }
 
 void WebApiWsLiveClass::generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv)
@@ -181,38 +491,49 @@ void WebApiWsLiveClass::generateInverterChannelJsonResponse(JsonObject& root, st
             if (t == TYPE_DC) {
                 chanTypeObj[String(static_cast<uint8_t>(c))]["name"]["u"] = inv_cfg->channel[c].Name;
             }
-            addField(chanTypeObj, inv, t, c, FLD_PAC);
-            addField(chanTypeObj, inv, t, c, FLD_UAC);
-            addField(chanTypeObj, inv, t, c, FLD_IAC);
-            if (t == TYPE_INV) {
-                addField(chanTypeObj, inv, t, c, FLD_PDC, "Power DC");
-            } else {
-                addField(chanTypeObj, inv, t, c, FLD_PDC);
+        }
+    }
+
+    // All values of the same frame
+    std::vector<float> values;
+    inv->Statistics()->getFieldValues(values);
+
+    forEachLiveField(inv, [&](const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId) {
+        auto chanTypeObj = root[inv->Statistics()->getChannelTypeName(type)].as<JsonObject>();
+        addField(chanTypeObj, inv, values, type, channel, fieldId, getLiveFieldName(inv, type, channel, fieldId));
+        if (fieldId == FLD_IRR) {
+            chanTypeObj[String(channel)][inv->Statistics()->getChannelFieldName(type, channel, FLD_IRR)]["max"] = inv->Statistics()->getStringMaxPower(channel);
+        }
+    });
+}
+
+void WebApiWsLiveClass::forEachLiveField(std::shared_ptr<InverterAbstract> inv, const std::function<void(const ChannelType_t, const ChannelNum_t, const FieldId_t)>& callback)
+{
+    static const FieldId_t fields[] = { FLD_PAC, FLD_UAC, FLD_IAC, FLD_PDC, FLD_UDC, FLD_IDC, FLD_YD, FLD_YT, FLD_F, FLD_T, FLD_PF, FLD_Q, FLD_EFF };
+
+    for (auto& t : inv->Statistics()->getChannelTypes()) {
+        for (auto& c : inv->Statistics()->getChannelsByType(t)) {
+            for (const auto f : fields) {
+                if (inv->Statistics()->hasChannelFieldValue(t, c, f)) {
+                    callback(t, c, f);
+                }
             }
-            addField(chanTypeObj, inv, t, c, FLD_UDC);
-            addField(chanTypeObj, inv, t, c, FLD_IDC);
-            addField(chanTypeObj, inv, t, c, FLD_YD);
-            addField(chanTypeObj, inv, t, c, FLD_YT);
-            addField(chanTypeObj, inv, t, c, FLD_F);
-            addField(chanTypeObj, inv, t, c, FLD_T);
-            addField(chanTypeObj, inv, t, c, FLD_PF);
-            addField(chanTypeObj, inv, t, c, FLD_Q);
-            addField(chanTypeObj, inv, t, c, FLD_EFF);
-            if (t == TYPE_DC && inv->Statistics()->getStringMaxPower(c) > 0) {
-                addField(chanTypeObj, inv, t, c, FLD_IRR);
-                chanTypeObj[String(c)][inv->Statistics()->getChannelFieldName(t, c, FLD_IRR)]["max"] = inv->Statistics()->getStringMaxPower(c);
+            if (t == TYPE_DC && inv->Statistics()->getStringMaxPower(c) > 0 && inv->Statistics()->hasChannelFieldValue(t, c, FLD_IRR)) {
+                callback(t, c, FLD_IRR);
             }
         }
     }
+}
 
-    if (inv->Statistics()->hasChannelFieldValue(TYPE_INV, CH0, FLD_EVT_LOG)) {
-        root["events"] = inv->EventLog()->getEntryCount();
-    } else {
-        root["events"] = -1;
+String WebApiWsLiveClass::getLiveFieldName(std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId)
+{
+    if (type == TYPE_INV && fieldId == FLD_PDC) {
+        return "Power DC";
     }
+    return inv->Statistics()->getChannelFieldName(type, channel, fieldId);
 }
 
-void WebApiWsLiveClass::addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, String topic)
+void WebApiWsLiveClass::addField(JsonObject& root, std::shared_ptr<InverterAbstract> inv, const std::vector<float>& values, const ChannelType_t type, const ChannelNum_t channel, const FieldId_t fieldId, String topic)
 {
     if (inv->Statistics()->hasChannelFieldValue(type, channel, fieldId)) {
         String chanName;
@@ -223,7 +544,7 @@ void WebApiWsLiveClass::addField(JsonObject& root, std::shared_ptr<InverterAbstr
         }
         String chanNum;
         chanNum = channel;
-        root[chanNum][chanName]["v"] = inv->Statistics()->getChannelFieldValue(type, channel, fieldId);
+        root[chanNum][chanName]["v"] = inv->Statistics()->getChannelFieldValue(values, type, channel, fieldId);
         root[chanNum][chanName]["u"] = inv->Statistics()->getChannelFieldUnit(type, channel, fieldId);
         root[chanNum][chanName]["d"] = inv->Statistics()->getChannelFieldDigits(type, channel, fieldId);
     }
@@ -242,45 +563,125 @@ void WebApiWsLiveClass::onWebsocketEvent(AsyncWebSocket* server, AsyncWebSocketC
         ESP_LOGD(TAG, "Websocket: [%s][%" PRIu32 "] connect", server->url(), client->id());
     } else if (type == WS_EVT_DISCONNECT) {
         ESP_LOGD(TAG, "Websocket: [%s][%" PRIu32 "] disconnect", server->url(), client->id());
+
+        std::lock_guard<std::mutex> lock(_clientsMutex);
+        _clients.erase(client->id());
+    } else if (type == WS_EVT_DATA) {
+        const AwsFrameInfo* info = static_cast<AwsFrameInfo*>(arg);
+        if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_TEXT) {
+            return;
+        }
+
+        auto isMessage = [&](const char* message) {
+            return len == strlen(message) && memcmp(data, message, len) == 0;
+        };
+
+        std::lock_guard<std::mutex> lock(_clientsMutex);
+        if (isMessage(WS_LIVE_PROTOCOL_DELTA)) {
+            ESP_LOGD(TAG, "Websocket: [%s][%" PRIu32 "] uses delta protocol", server->url(), client->id());
+            _clients[client->id()].Delta = true;
+            _clients[client->id()].SnapshotRequired = true;
+        } else if (isMessage(WS_LIVE_ENCODING_MSGPACK)) {
+            ESP_LOGD(TAG, "Websocket: [%s][%" PRIu32 "] uses MessagePack", server->url(), client->id());
+            _clients[client->id()].MessagePack = true;
+        }
     }
 }
 
-void WebApiWsLiveClass::onLivedataStatus(AsyncWebServerRequest* request)
+void WebApiWsLiveClass::generateLivedataStatusResponse(JsonVariant& root, const uint64_t serial)
 {
-    if (!WebApi.checkCredentialsReadonly(request)) {
-        return;
+    auto invArray = root["inverters"].to<JsonArray>();
+
+    if (serial > 0) {
+        auto inv = Hoymiles.getInverterBySerial(serial);
+        if (inv != nullptr) {
+            JsonObject invObject = invArray.add<JsonObject>();
+            generateInverterCommonJsonResponse(invObject, inv);
+            generateInverterChannelJsonResponse(invObject, inv);
+        }
+    } else {
+        // Loop all inverters
+        for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+            auto inv = Hoymiles.getInverterByPos(i);
+            if (inv == nullptr) {
+                continue;
+            }
+
+            JsonObject invObject = invArray.add<JsonObject>();
+            generateInverterCommonJsonResponse(invObject, inv);
+        }
     }
 
-    try {
-        std::lock_guard<std::mutex> lock(_mutex);
-        AsyncJsonResponse* response = new AsyncJsonResponse();
-        auto& root = response->getRoot();
-        auto invArray = root["inverters"].to<JsonArray>();
-        auto serial = WebApi.parseSerialFromRequest(request);
+    generateCommonJsonResponse(root);
+}
 
+bool WebApiWsLiveClass::writeLivedataStatusPart(const uint64_t serial, const size_t part, bool& first, Print& output)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (part == 0) {
+        output.print("{\"inverters\":[");
+        return true;
+    }
+
+    // One inverter per part
+    const size_t invPos = part - 1;
+    if ((serial > 0 && invPos == 0) || (serial == 0 && invPos < Hoymiles.getNumInverters())) {
+        auto inv = (serial > 0) ? Hoymiles.getInverterBySerial(serial) : Hoymiles.getInverterByPos(invPos);
+        if (inv == nullptr) {
+            return true;
+        }
+
+        JsonDocument doc;
+        JsonObject invObject = doc.to<JsonObject>();
+        generateInverterCommonJsonResponse(invObject, inv);
         if (serial > 0) {
-            auto inv = Hoymiles.getInverterBySerial(serial);
-            if (inv != nullptr) {
-                JsonObject invObject = invArray.add<JsonObject>();
-                generateInverterCommonJsonResponse(invObject, inv);
-                generateInverterChannelJsonResponse(invObject, inv);
-            }
-        } else {
-            // Loop all inverters
-            for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-                auto inv = Hoymiles.getInverterByPos(i);
-                if (inv == nullptr) {
-                    continue;
-                }
+            generateInverterChannelJsonResponse(invObject, inv);
+        }
 
-                JsonObject invObject = invArray.add<JsonObject>();
-                generateInverterCommonJsonResponse(invObject, inv);
+        if (Utils::checkJsonAlloc(doc, __FUNCTION__, __LINE__)) {
+            if (!first) {
+                output.print(',');
             }
+            first = false;
+            serializeJson(doc, output);
         }
+        return true;
+    }
+
+    JsonDocument doc;
+    JsonVariant var = doc;
+    generateCommonJsonResponse(var);
 
-        generateCommonJsonResponse(root);
+    // Append the members of doc to the root object (skip the opening brace)
+    String common;
+    serializeJson(doc, common);
+    output.print("],");
+    output.print(common.c_str() + 1);
+    return false;
+}
+
+void WebApiWsLiveClass::onLivedataStatus(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
 
-        WebApi.sendJsonResponse(request, response, __FUNCTION__, __LINE__);
+    const auto serial = WebApi.parseSerialFromRequest(request);
+
+    if (!WebApi.acceptsMessagePack(request)) {
+        // The parts lock the mutex by themselves. Sending may already generate the first parts.
+        WebApi.sendChunkedJsonResponse(request, [this, serial, first = true](const size_t part, Print& output) mutable {
+            return writeLivedataStatusPart(serial, part, first, output);
+        });
+        return;
+    }
+
+    try {
+        std::lock_guard<std::mutex> lock(_mutex);
+        AsyncMessagePackResponse* response = new AsyncMessagePackResponse();
+        generateLivedataStatusResponse(response->getRoot(), serial);
+        WebApi.sendMessagePackResponse(request, response, __FUNCTION__, __LINE__);
 
     } catch (const std::bad_alloc& bad_alloc) {
         ESP_LOGE(TAG, "Call to /api/livedata/status temporarely out of resources. Reason: \"%s\".", bad_alloc.what());
@@ -5,6 +5,7 @@
 #include "Configuration.h"
 #include "Datastore.h"
 #include "Display_Graphic.h"
+#include "History.h"
 #include "I18n.h"
 #include "InverterSettings.h"
 #include "Led_Single.h"
@@ -105,7 +106,7 @@ void setup()
 
     // Initialize MqTT
     ESP_LOGI(TAG, "Initializing MQTT...");
-    MqttSettings.init();
+    MqttSettings.init(scheduler);
     MqttHandleDtu.init(scheduler);
     MqttHandleInverter.init(scheduler);
     MqttHandleInverterTotal.init(scheduler);
@@ -126,6 +127,7 @@ void setup()
     InverterSettings.init(scheduler);
 
     Datastore.init(scheduler);
+    History.init(scheduler);
     RestartHelper.init(scheduler);
 
     ESP_LOGI(TAG, "Startup complete");
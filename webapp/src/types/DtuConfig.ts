@@ -9,6 +9,7 @@ export interface CountryDef {
 export interface DtuConfig {
     serial: string;
     pollinterval: number;
+    poll_adaptive: boolean;
     nrf_enabled: boolean;
     nrf_palevel: number;
     cmt_enabled: boolean;
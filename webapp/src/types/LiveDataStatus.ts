@@ -29,6 +29,7 @@ export interface RadioStatistics {
     rx_fail_partial: number;
     rx_fail_corrupt: number;
     rssi: number;
+    poll_interval: number;
 }
 
 export interface Inverter {
@@ -49,6 +50,14 @@ export interface Inverter {
     radio_stats: RadioStatistics;
 }
 
+// Describes an id of the delta protocol
+export interface LiveDataDeltaField {
+    serial: string;
+    type: 'AC' | 'DC' | 'INV';
+    channel: number;
+    name: keyof InverterStatistics;
+}
+
 export interface Total {
     Power: ValueObject;
     YieldDay: ValueObject;
@@ -23,4 +23,12 @@ export interface MqttConfig {
     mqtt_hass_retain: boolean;
     mqtt_hass_topic: string;
     mqtt_hass_individualpanels: boolean;
+    mqtt_change_only: boolean;
+    mqtt_change_only_deadband_steps: number;
+    mqtt_change_only_deadband_relative: number;
+    mqtt_change_only_max_age: number;
+    mqtt_aggregated_format: number;
+    mqtt_aggregated_field_topics: boolean;
+    mqtt_outbox_budget: number;
+    mqtt_outbox_coalesce: boolean;
 }
@@ -1,5 +1,6 @@
 import type { Emitter, EventType } from 'mitt';
 import type { Router } from 'vue-router';
+import { decodeMsgPack } from './msgpack';
 
 export function authHeader(): Headers {
     // return authorization header with basic auth credentials
@@ -71,8 +72,13 @@ export function handleResponse(
     router: Router,
     ignore_error: boolean = false
 ) {
-    return response.text().then((text) => {
-        const data = text && JSON.parse(text);
+    // MessagePack is only sent if it was requested using the Accept header
+    const contentType = response.headers.get('Content-Type') || '';
+    const body = contentType.includes('msgpack')
+        ? response.arrayBuffer().then((buffer) => buffer.byteLength && decodeMsgPack(buffer))
+        : response.text().then((text) => text && JSON.parse(text));
+
+    return body.then((data) => {
         if (!response.ok) {
             if (response.status === 401) {
                 // auto logout if 401 response returned from api
@@ -0,0 +1,124 @@
+// Minimal MessagePack decoder for the messages produced by ArduinoJson's serializeMsgPack.
+// Extension and binary types are not used by the firmware and therefore not supported.
+
+/* eslint-disable  @typescript-eslint/no-explicit-any */
+export function decodeMsgPack(buffer: ArrayBuffer): any {
+    const view = new DataView(buffer);
+    const textDecoder = new TextDecoder();
+    let pos = 0;
+
+    const readString = (length: number): string => {
+        const str = textDecoder.decode(new Uint8Array(buffer, pos, length));
+        pos += length;
+        return str;
+    };
+
+    const readArray = (length: number): any[] => {
+        const arr = [];
+        for (let i = 0; i < length; i++) {
+            arr.push(readValue());
+        }
+        return arr;
+    };
+
+    const readMap = (length: number): Record<string, any> => {
+        const obj: Record<string, any> = {};
+        for (let i = 0; i < length; i++) {
+            const key = readValue();
+            obj[key] = readValue();
+        }
+        return obj;
+    };
+
+    const readValue = (): any => {
+        const type = view.getUint8(pos++);
+        let value: any;
+
+        if (type <= 0x7f) {
+            return type; // positive fixint
+        } else if (type <= 0x8f) {
+            return readMap(type & 0x0f);
+        } else if (type <= 0x9f) {
+            return readArray(type & 0x0f);
+        } else if (type <= 0xbf) {
+            return readString(type & 0x1f);
+        } else if (type >= 0xe0) {
+            return type - 0x100; // negative fixint
+        }
+
+        switch (type) {
+            case 0xc0:
+                return null;
+            case 0xc2:
+                return false;
+            case 0xc3:
+                return true;
+            case 0xca:
+                value = view.getFloat32(pos);
+                pos += 4;
+                return value;
+            case 0xcb:
+                value = view.getFloat64(pos);
+                pos += 8;
+                return value;
+            case 0xcc:
+                return view.getUint8(pos++);
+            case 0xcd:
+                value = view.getUint16(pos);
+                pos += 2;
+                return value;
+            case 0xce:
+                value = view.getUint32(pos);
+                pos += 4;
+                return value;
+            case 0xcf:
+                value = Number(view.getBigUint64(pos));
+                pos += 8;
+                return value;
+            case 0xd0:
+                return view.getInt8(pos++);
+            case 0xd1:
+                value = view.getInt16(pos);
+                pos += 2;
+                return value;
+            case 0xd2:
+                value = view.getInt32(pos);
+                pos += 4;
+                return value;
+            case 0xd3:
+                value = Number(view.getBigInt64(pos));
+                pos += 8;
+                return value;
+            case 0xd9:
+                return readString(view.getUint8(pos++));
+            case 0xda:
+                value = view.getUint16(pos);
+                pos += 2;
+                return readString(value);
+            case 0xdb:
+                value = view.getUint32(pos);
+                pos += 4;
+                return readString(value);
+            case 0xdc:
+                value = view.getUint16(pos);
+                pos += 2;
+                return readArray(value);
+            case 0xdd:
+                value = view.getUint32(pos);
+                pos += 4;
+                return readArray(value);
+            case 0xde:
+                value = view.getUint16(pos);
+                pos += 2;
+                return readMap(value);
+            case 0xdf:
+                value = view.getUint32(pos);
+                pos += 4;
+                return readMap(value);
+        }
+
+        throw new Error('Unsupported MessagePack type 0x' + type.toString(16));
+    };
+
+    return readValue();
+}